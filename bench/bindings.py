@@ -0,0 +1,109 @@
+#!/usr/bin/env python3
+"""Benchmarks the Python bindings (python/physics.cpp) at scale: bulk create
+and apply_force per body, a step driven from Python against the same step
+timed natively, and the cost of viewing the body arrays, which should not
+grow with the body count. Also checks that views share memory with the
+world and that step() releases the GIL, by counting in a Python thread
+while another steps.
+
+Works with the standard library alone; uses NumPy for the arrays when it is
+installed. make bench-python builds the module and runs this.
+
+Usage: bindings.py module_dir [--bodies 1000000] [--steps 20]
+"""
+import argparse
+import array
+import os
+import random
+import sys
+import threading
+import time
+
+try:
+    import numpy
+except ImportError:
+    numpy = None
+
+
+def floats(values):
+    """A float32 array of values, NumPy's if available."""
+    return numpy.asarray(values, dtype=numpy.float32) if numpy else array.array("f", values)
+
+
+def view(body_array):
+    """A view of a World body array without copying."""
+    return numpy.asarray(body_array) if numpy else memoryview(body_array)
+
+
+def timed(function, *args):
+    """Returns (seconds, result) of one call."""
+    start = time.perf_counter()
+    result = function(*args)
+    return time.perf_counter() - start, result
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("module_dir", help="directory holding the built physics module")
+    parser.add_argument("--bodies", type=int, default=1000000)
+    parser.add_argument("--steps", type=int, default=20)
+    args = parser.parse_args()
+    sys.path.insert(0, os.path.abspath(args.module_dir))
+    import physics
+
+    bodies, steps = args.bodies, args.steps
+    rng = random.Random(5)
+    side = (bodies ** 0.5) * 3.0
+    xs = floats([rng.uniform(0.0, side) for _ in range(bodies)])
+    ys = floats([rng.uniform(0.0, side) for _ in range(bodies)])
+    print(f"bodies={bodies} steps={steps} arrays={'numpy' if numpy else 'memoryview'}")
+
+    world = physics.World(threads=1)
+    world.add_gravity(0.0, -9.81)
+    seconds, handles = timed(world.create, xs, ys, 0.5, 1.0)
+    print(f"{'create':>24} {seconds / bodies * 1e9:10.1f} ns/body")
+    pushes = floats([1.0] * bodies)
+    seconds, _ = timed(world.apply_force, pushes, pushes)
+    print(f"{'apply_force (all)':>24} {seconds / bodies * 1e9:10.1f} ns/body")
+    seconds, _ = timed(world.apply_force, pushes, pushes, handles)
+    print(f"{'apply_force (handles)':>24} {seconds / bodies * 1e9:10.1f} ns/body")
+
+    # Each call of a one-step loop crosses the language boundary once; it should add nothing measurable
+    seconds, _ = timed(world.step, 1.0 / 60.0, steps)
+    print(f"{'step(dt, n)':>24} {seconds / steps * 1e3:10.2f} ms/step")
+    start = time.perf_counter()
+    for _ in range(steps):
+        world.step(1.0 / 60.0)
+    print(f"{'n x step(dt)':>24} {(time.perf_counter() - start) / steps * 1e3:10.2f} ms/step")
+
+    seconds, x = timed(view, world.x)
+    print(f"{'view of x':>24} {seconds * 1e6:10.2f} us")
+    probe = bodies // 2
+    x[probe] = -1.0
+    indices = world.indices(handles[probe:probe + 1])
+    shared = view(world.x)[indices[0]] == -1.0
+    print(f"{'views share memory':>24} {'yes' if shared else 'NO'}")
+    del x
+
+    # A Python thread counts while another thread steps; with the GIL held it would barely run
+    counter, stop = [0], threading.Event()
+
+    def count():
+        while not stop.is_set():
+            counter[0] += 1
+
+    counting = threading.Thread(target=count)
+    counting.start()
+    stepper = threading.Thread(target=world.step, args=(1.0 / 60.0, steps))
+    start = time.perf_counter()
+    stepper.start()
+    stepper.join()
+    stepping_seconds = time.perf_counter() - start
+    stop.set()
+    counting.join()
+    print(f"{'counts while stepping':>24} {counter[0] / stepping_seconds:10.0f} /s")
+    return 0 if shared else 1
+
+
+if __name__ == "__main__":
+    sys.exit(main())
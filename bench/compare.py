@@ -0,0 +1,71 @@
+#!/usr/bin/env python3
+"""Compares two benchmark JSON files written by the suite benchmark (or by
+Google Benchmark) and flags benchmarks that got slower than the threshold.
+
+Each benchmark is compared on its median aggregate when the run has
+repetitions, otherwise on the mean of its iteration entries. Exits with 1 if
+any benchmark regressed, so it can gate a build.
+
+Usage: compare.py baseline.json current.json [--threshold 5]
+"""
+import argparse
+import json
+import sys
+
+
+def load(path):
+    """Returns {run_name: ns per iteration} for the benchmarks in path."""
+    try:
+        with open(path) as f:
+            data = json.load(f)
+    except OSError as error:
+        sys.exit(f"cannot read {path}: {error.strerror}")
+
+    medians, iterations = {}, {}
+    for entry in data.get("benchmarks", []):
+        name = entry.get("run_name", entry["name"])
+        scale = {"ns": 1.0, "us": 1e3, "ms": 1e6, "s": 1e9}[entry.get("time_unit", "ns")]
+        time = entry["real_time"] * scale
+        if entry.get("run_type") == "aggregate":
+            if entry.get("aggregate_name") == "median":
+                medians[name] = time
+        else:
+            iterations.setdefault(name, []).append(time)
+
+    times = {name: sum(values) / len(values) for name, values in iterations.items()}
+    times.update(medians)
+    return times
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("baseline")
+    parser.add_argument("current")
+    parser.add_argument("--threshold", type=float, default=5.0, help="percent slowdown that counts as a regression")
+    args = parser.parse_args()
+
+    baseline = load(args.baseline)
+    current = load(args.current)
+
+    regressions = 0
+    print(f"{'benchmark':40} {'baseline':>14} {'current':>14} {'change':>9}")
+    for name, time in current.items():
+        if name not in baseline:
+            print(f"{name:40} {'-':>14} {time:14.1f} {'new':>9}")
+            continue
+        change = (time - baseline[name]) / baseline[name] * 100.0
+        flag = ""
+        if change > args.threshold:
+            flag = "  REGRESSION"
+            regressions += 1
+        print(f"{name:40} {baseline[name]:14.1f} {time:14.1f} {change:+8.1f}%{flag}")
+    for name in baseline:
+        if name not in current:
+            print(f"{name:40} {baseline[name]:14.1f} {'-':>14} {'missing':>9}")
+
+    print(f"\n{regressions} regression(s) over {args.threshold:g}% (times in ns per iteration)")
+    return 1 if regressions else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
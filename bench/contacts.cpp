@@ -0,0 +1,129 @@
+// Contact benchmark: narrow-phase contacts/sec at every SIMD level, and how many
+// solver iterations a resting pyramid needs with and without warm starting.
+// Usage: contacts [bodies] [rows] [steps]
+#include <world.h>
+#include <broadphase.h>
+#include <narrowphase.h>
+#include <simd.h>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <random>
+#include <vector>
+
+namespace {
+
+    // Densely packed random circles, so a good share of the pairs really touch
+    void buildCloud(world::BodyStore& store, int bodies) {
+        std::mt19937 rng(7);
+        float side = std::sqrt(static_cast<float>(bodies)) * 1.6f;
+        std::uniform_real_distribution<float> position(0.0f, side);
+        std::uniform_real_distribution<float> radius(0.4f, 1.0f);
+        store.reserve(bodies);
+        for (int i = 0; i < bodies; i++) {
+            store.create(position(rng), position(rng), radius(rng), 1.0f);
+        }
+    }
+
+    // Hexagonally packed pyramid of unit circles resting on a row of static ones
+    void buildPyramid(world::World& world, int rows) {
+        const float radius = 0.5f;
+        const float row_height = radius * std::sqrt(3.0f);
+        world.addForceGenerator(std::unique_ptr<forces::ForceGenerator>(new forces::UniformGravity(0.0f, -9.8f)));
+        for (int i = -1; i <= rows; i++) {
+            world.createCircle(vector::Vector<float, 2>(i * 2.0f * radius, 0.0f), radius, 1.0f, true, 0.0f);
+        }
+        for (int row = 0; row < rows; row++) {
+            for (int i = 0; i < rows - row; i++) {
+                float x = (row + 2 * i) * radius + radius;
+                float y = (row + 1) * row_height;
+                world.createCircle(vector::Vector<float, 2>(x, y), radius, 1.0f, false, 0.0f);
+            }
+        }
+    }
+
+    void benchNarrowPhase(int bodies) {
+        world::BodyStore store;
+        buildCloud(store, bodies);
+        std::vector<broadphase::BodyPair> pairs;
+        broadphase::SpatialHashGrid grid;
+        grid.findPairs(store, pairs);
+
+        std::printf("narrow-phase: bodies=%d pairs=%zu\n", bodies, pairs.size());
+        std::printf("%8s %14s %14s %10s\n", "level", "pairs/sec", "contacts/sec", "identical");
+
+        narrowphase::NarrowPhase narrow_phase;
+        std::vector<narrowphase::Contact> contacts;
+        std::vector<narrowphase::Contact> reference;
+        const simd::Level levels[] = {simd::Level::Scalar, simd::Level::SSE2, simd::Level::AVX2, simd::Level::AVX512};
+        for (simd::Level level : levels) {
+            simd::setLevel(level);
+            if (simd::active() != level) {
+                continue;  // not supported on this CPU
+            }
+
+            const int repeats = 20;
+            auto start = std::chrono::steady_clock::now();
+            for (int r = 0; r < repeats; r++) {
+                narrow_phase.collide(store, pairs, contacts);
+            }
+            double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+            if (reference.empty()) {
+                reference = contacts;
+            }
+            bool identical = contacts.size() == reference.size() &&
+                             std::memcmp(contacts.data(), reference.data(), contacts.size() * sizeof(narrowphase::Contact)) == 0;
+            std::printf("%8s %14.3e %14.3e %10s\n", simd::name(level), pairs.size() * repeats / seconds,
+                        contacts.size() * repeats / seconds, identical ? "yes" : "NO");
+        }
+        simd::setLevel(simd::detect());
+    }
+
+    void benchSolver(int rows, int steps, bool warm_starting) {
+        world::World world(1);
+        buildPyramid(world, rows);
+        world.sleepSettings().enabled = false;  // keep every contact in the solve
+        solver::Settings& settings = world.solverSettings();
+        settings.warm_starting = warm_starting;
+        settings.iterations = 100;  // high cap so the count reflects convergence, not the limit
+
+        // Second half of the run is the resting stack
+        long long iterations = 0;
+        int measured = 0;
+        auto start = std::chrono::steady_clock::now();
+        for (int s = 0; s < steps; s++) {
+            world.step(1.0f / 60.0f);
+            if (s >= steps / 2) {
+                iterations += world.solverIterations();
+                measured++;
+            }
+        }
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        // How far the top of the pyramid sank, a rough measure of how well it is held up
+        const world::BodyStore& store = world.bodies();
+        float expected = rows * 0.5f * std::sqrt(3.0f);
+        float top = store.y()[store.size() - 1];
+        std::printf("%14s %10zu %16.2f %12.2f %12.4f\n", warm_starting ? "warm" : "cold", world.contacts().size(),
+                    measured ? static_cast<double>(iterations) / measured : 0.0, steps / seconds, expected - top);
+    }
+
+}
+
+int main(int argc, char** argv) {
+    int bodies = argc > 1 ? std::atoi(argv[1]) : 100000;
+    int rows = argc > 2 ? std::atoi(argv[2]) : 20;
+    int steps = argc > 3 ? std::atoi(argv[3]) : 300;
+
+    benchNarrowPhase(bodies);
+    std::printf("\n");
+    std::printf("pyramid: rows=%d steps=%d\n", rows, steps);
+    std::printf("%14s %10s %16s %12s %12s\n", "warm-starting", "contacts", "iterations/step", "steps/sec", "top sag");
+    benchSolver(rows, steps, false);
+    benchSolver(rows, steps, true);
+    return 0;
+}
@@ -0,0 +1,152 @@
+// Determinism benchmark: runs one scene under different thread counts, SIMD levels,
+// broad-phase backends and destroy orders, and reports the first step whose state
+// hash differs from a reference run, and what a step and its hash cost.
+// Usage: determinism [bodies] [steps]
+#include <world.h>
+#include <aabb_tree.h>
+#include <simd.h>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <random>
+#include <vector>
+
+namespace {
+
+    const int DESTROY_STEP = 50;    // step before which every DESTROY_EVERYth body is destroyed
+    const int DESTROY_EVERY = 37;
+
+    struct Variant {
+        const char* name;
+        unsigned threads = 1;
+        simd::Level level = simd::Level::Scalar;
+        int backend = 0;                // 0 grid, 1 sweep and prune, 2 tree
+        bool reverse_destroys = false;
+        bool creation_order = true;
+        bool ordered_pairs = true;
+    };
+
+    // Random circles in a square sized for roughly constant density, one in ten static
+    std::vector<world::BodyHandle> buildScene(world::World& world, int bodies) {
+        std::mt19937 rng(42);
+        float side = std::sqrt(static_cast<float>(bodies)) * 3.0f;
+        std::uniform_real_distribution<float> position(0.0f, side);
+        std::uniform_real_distribution<float> radius(0.4f, 1.0f);
+        std::uniform_real_distribution<float> speed(-2.0f, 2.0f);
+
+        std::vector<world::BodyHandle> handles;
+        world.bodies().reserve(bodies);
+        for (int i = 0; i < bodies; i++) {
+            bool is_static = i % 10 == 0;
+            objects::Circle circle = world.createCircle(vector::Vector<float, 2>(position(rng), position(rng)), radius(rng), 1.0f, is_static, 0.5f);
+            if (!is_static) {
+                circle.setVelocity(speed(rng), speed(rng));
+            }
+            handles.push_back(circle.getHandle());
+        }
+        return handles;
+    }
+
+    // Hash of every step, and the mean time of the hash stage and of whole steps
+    struct Run {
+        std::vector<std::uint64_t> hashes;
+        double hash_seconds = 0.0;
+        double step_seconds = 0.0;
+    };
+
+    Run simulate(const Variant& variant, int bodies, int steps) {
+        simd::setLevel(variant.level);
+        world::World world(variant.threads);
+        if (variant.backend == 1) {
+            world.setBroadPhase(std::unique_ptr<broadphase::BroadPhase>(new broadphase::SweepAndPrune()));
+        } else if (variant.backend == 2) {
+            world.setBroadPhase(std::unique_ptr<broadphase::BroadPhase>(new broadphase::TreeBroadPhase()));
+        }
+        world::DeterminismSettings& settings = world.determinismSettings();
+        settings.creation_order = variant.creation_order;
+        settings.ordered_pairs = variant.ordered_pairs;
+        settings.state_hash = true;
+
+        std::vector<world::BodyHandle> handles = buildScene(world, bodies);
+        Run run;
+        for (int s = 0; s < steps; s++) {
+            if (s == DESTROY_STEP) {
+                for (std::size_t k = 0; k < handles.size(); k += DESTROY_EVERY) {
+                    std::size_t i = variant.reverse_destroys ? handles.size() - 1 - k : k;
+                    world.bodies().destroy(handles[i]);
+                }
+            }
+            world.step(1.0f / 60.0f);
+            const profiling::FrameStats& stats = world.frameStats();
+            run.hashes.push_back(stats.state_hash);
+            run.hash_seconds += stats.stageSeconds(profiling::Stage::Hash) / steps;
+            run.step_seconds += stats.step_seconds / steps;
+        }
+        simd::setLevel(simd::detect());
+        return run;
+    }
+
+}
+
+int main(int argc, char** argv) {
+    int bodies = argc > 1 ? std::atoi(argv[1]) : 20000;
+    int steps = argc > 2 ? std::atoi(argv[2]) : 200;
+    // Reversing destroys from the end of the list needs the same bodies destroyed either way
+    if (bodies % DESTROY_EVERY != 1) {
+        bodies += (DESTROY_EVERY + 1 - bodies % DESTROY_EVERY) % DESTROY_EVERY;
+    }
+    std::printf("bodies=%d steps=%d (every %dth body destroyed before step %d)\n", bodies, steps, DESTROY_EVERY, DESTROY_STEP);
+
+    std::vector<Variant> variants;
+    variants.push_back(Variant{"reference (1 thread, scalar, grid)"});
+    Variant threaded{"4 threads"};
+    threaded.threads = 4;
+    variants.push_back(threaded);
+    const simd::Level levels[] = {simd::Level::SSE2, simd::Level::AVX2, simd::Level::AVX512};
+    for (simd::Level level : levels) {
+        if (level <= simd::detect()) {
+            Variant simd_variant{simd::name(level)};
+            simd_variant.level = level;
+            variants.push_back(simd_variant);
+        }
+    }
+    Variant sap{"sweep and prune"};
+    sap.backend = 1;
+    variants.push_back(sap);
+    Variant tree{"dynamic aabb tree"};
+    tree.backend = 2;
+    variants.push_back(tree);
+    Variant reversed{"destroyed in reverse"};
+    reversed.reverse_destroys = true;
+    variants.push_back(reversed);
+    // Without each ordering option the run drifts from the reference
+    Variant sap_unordered{"sweep and prune, unordered pairs"};
+    sap_unordered.backend = 1;
+    sap_unordered.ordered_pairs = false;
+    variants.push_back(sap_unordered);
+    Variant reversed_unordered{"reverse, no creation order"};
+    reversed_unordered.reverse_destroys = true;
+    reversed_unordered.creation_order = false;
+    variants.push_back(reversed_unordered);
+
+    std::printf("%-36s %14s %10s %10s   %s\n", "variant", "diverged at", "step ms", "hash ms", "final hash");
+    Run reference;
+    for (std::size_t v = 0; v < variants.size(); v++) {
+        Run run = simulate(variants[v], bodies, steps);
+        if (v == 0) {
+            reference = run;
+        }
+        int diverged = -1;
+        for (int s = 0; s < steps && diverged < 0; s++) {
+            if (run.hashes[s] != reference.hashes[s]) {
+                diverged = s + 1;
+            }
+        }
+        char at[32];
+        std::snprintf(at, sizeof(at), diverged < 0 ? "identical" : "step %d", diverged);
+        std::printf("%-36s %14s %10.3f %10.3f   %016llx\n", variants[v].name, at, run.step_seconds * 1e3, run.hash_seconds * 1e3,
+                    static_cast<unsigned long long>(run.hashes.back()));
+    }
+    return 0;
+}
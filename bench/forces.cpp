@@ -0,0 +1,154 @@
+// Force generator benchmark: gravity and drag passes per body at every SIMD level,
+// and Barnes-Hut mutual gravity against the exact O(n^2) sum for accuracy and time.
+// Usage: forces [bodies] [reference_bodies]
+#include <forces.h>
+#include <body_store.h>
+#include <simd.h>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <vector>
+
+namespace {
+
+    double secondsSince(std::chrono::steady_clock::time_point start) {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    // Moving circles in a square, one in ten static
+    void buildField(world::BodyStore& store, int bodies) {
+        std::mt19937 rng(3);
+        std::uniform_real_distribution<float> position(0.0f, 1000.0f);
+        std::uniform_real_distribution<float> speed(-5.0f, 5.0f);
+        std::uniform_real_distribution<float> mass(0.5f, 2.0f);
+        store.reserve(bodies);
+        for (int i = 0; i < bodies; i++) {
+            world::BodyHandle handle = store.create(position(rng), position(rng), 0.5f, mass(rng), i % 10 == 0);
+            store.setVelocity(store.indexOf(handle), speed(rng), speed(rng));
+        }
+    }
+
+    // A clustered galaxy-like disc: density falling off with radius, as Barnes-Hut is meant for
+    void buildCluster(world::BodyStore& store, int bodies) {
+        std::mt19937 rng(11);
+        std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+        store.reserve(bodies);
+        for (int i = 0; i < bodies; i++) {
+            float r = 100.0f * unit(rng) * unit(rng);
+            float angle = 6.2831853f * unit(rng);
+            store.create(r * std::cos(angle), r * std::sin(angle), 0.1f, 0.5f + unit(rng));
+        }
+    }
+
+    void benchFields(int bodies) {
+        world::BodyStore store;
+        buildField(store, bodies);
+        forces::UniformGravity gravity;
+        forces::Drag drag(0.1f, 0.01f);
+        const int repeats = 20;
+
+        std::printf("gravity + drag: bodies=%d\n", bodies);
+        std::printf("%8s %14s %14s %10s\n", "level", "gravity ns", "drag ns", "identical");
+        std::vector<float> reference_fx, reference_fy;
+        const simd::Level levels[] = {simd::Level::Scalar, simd::Level::SSE2, simd::Level::AVX2, simd::Level::AVX512};
+        for (simd::Level level : levels) {
+            simd::setLevel(level);
+            if (simd::active() != level) {
+                continue;
+            }
+            store.clearForces(0, store.size());
+            auto start = std::chrono::steady_clock::now();
+            for (int r = 0; r < repeats; r++) {
+                gravity.apply(store, nullptr);
+            }
+            double gravity_seconds = secondsSince(start);
+            start = std::chrono::steady_clock::now();
+            for (int r = 0; r < repeats; r++) {
+                drag.apply(store, nullptr);
+            }
+            double drag_seconds = secondsSince(start);
+
+            bool identical = true;
+            if (level == simd::Level::Scalar) {
+                reference_fx.assign(store.fx(), store.fx() + store.size());
+                reference_fy.assign(store.fy(), store.fy() + store.size());
+            } else {
+                identical = std::memcmp(reference_fx.data(), store.fx(), store.size() * sizeof(float)) == 0 &&
+                            std::memcmp(reference_fy.data(), store.fy(), store.size() * sizeof(float)) == 0;
+            }
+            std::printf("%8s %14.3f %14.3f %10s\n", simd::name(level), gravity_seconds / repeats / bodies * 1e9,
+                        drag_seconds / repeats / bodies * 1e9, identical ? "yes" : "NO");
+        }
+        simd::setLevel(simd::detect());
+    }
+
+    // Relative error of each force against the exact one, as RMS and max over the bodies
+    void forceError(const world::BodyStore& store, const std::vector<float>& exact_fx, const std::vector<float>& exact_fy, double& rms, double& worst) {
+        double sum = 0.0;
+        worst = 0.0;
+        for (std::size_t i = 0; i < store.size(); i++) {
+            double ex = exact_fx[i], ey = exact_fy[i];
+            double dx = store.fx()[i] - ex, dy = store.fy()[i] - ey;
+            double error = std::sqrt((dx * dx + dy * dy) / (ex * ex + ey * ey + 1e-30));
+            sum += error * error;
+            worst = std::fmax(worst, error);
+        }
+        rms = std::sqrt(sum / static_cast<double>(store.size()));
+    }
+
+    void benchMutualGravity(int bodies) {
+        world::BodyStore store;
+        buildCluster(store, bodies);
+        forces::MutualGravity gravity(1.0f, 0.5f, 0.05f);
+
+        gravity.setMethod(forces::MutualGravity::Method::Exact);
+        auto start = std::chrono::steady_clock::now();
+        gravity.apply(store, nullptr);
+        double exact_seconds = secondsSince(start);
+        std::vector<float> exact_fx(store.fx(), store.fx() + store.size());
+        std::vector<float> exact_fy(store.fy(), store.fy() + store.size());
+
+        std::printf("\nmutual gravity: bodies=%d exact=%.1f ms\n", bodies, exact_seconds * 1e3);
+        std::printf("%8s %10s %10s %12s %12s %10s\n", "theta", "ms", "speedup", "rms error", "max error", "nodes");
+        gravity.setMethod(forces::MutualGravity::Method::BarnesHut);
+        const float angles[] = {0.3f, 0.5f, 0.7f, 1.0f};
+        for (float angle : angles) {
+            gravity.setOpeningAngle(angle);
+            store.clearForces(0, store.size());
+            start = std::chrono::steady_clock::now();
+            gravity.apply(store, nullptr);
+            double seconds = secondsSince(start);
+            double rms, worst;
+            forceError(store, exact_fx, exact_fy, rms, worst);
+            std::printf("%8.1f %10.2f %9.1fx %12.2e %12.2e %10zu\n", angle, seconds * 1e3, exact_seconds / seconds, rms, worst, gravity.nodeCount());
+        }
+    }
+
+    // Barnes-Hut time per body as the count grows, which should only rise with log n
+    void benchScaling(int max_bodies) {
+        std::printf("\nbarnes-hut scaling (theta 0.5)\n");
+        std::printf("%10s %10s %12s\n", "bodies", "ms", "ns/body");
+        forces::MutualGravity gravity(1.0f, 0.5f, 0.05f);
+        for (int bodies = 1000; bodies <= max_bodies; bodies *= 10) {
+            world::BodyStore store;
+            buildCluster(store, bodies);
+            auto start = std::chrono::steady_clock::now();
+            gravity.apply(store, nullptr);
+            double seconds = secondsSince(start);
+            std::printf("%10d %10.2f %12.1f\n", bodies, seconds * 1e3, seconds / bodies * 1e9);
+        }
+    }
+
+}
+
+int main(int argc, char** argv) {
+    int bodies = argc > 1 ? std::atoi(argv[1]) : 1000000;
+    int reference_bodies = argc > 2 ? std::atoi(argv[2]) : 20000;
+    benchFields(bodies);
+    benchMutualGravity(reference_bodies);
+    benchScaling(bodies);
+    return 0;
+}
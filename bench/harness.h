@@ -0,0 +1,334 @@
+#ifndef BENCH_HARNESS_H // Inclusion guard
+#define BENCH_HARNESS_H
+
+// Small benchmark harness modelled on Google Benchmark: benchmarks register a
+// function taking a State, the harness picks an iteration count that runs for
+// at least the minimum time, repeats the run and reports each repetition plus
+// mean/median/stddev aggregates, on stdout and optionally as JSON in the same
+// layout Google Benchmark writes (so its tools can read our output too).
+//
+// Flags: --benchmark_filter=<substring>    only run benchmarks whose name contains it
+//        --benchmark_min_time=<seconds>    minimum time per repetition (default 0.2)
+//        --benchmark_repetitions=<n>       repetitions per benchmark (default 5)
+//        --benchmark_out=<file>            also write the results as JSON
+//        --benchmark_list_tests            print the benchmark names and exit
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <functional>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace bench {
+
+    // Keeps a value alive so the computation producing it can't be optimised away
+    template<typename T>
+    inline void doNotOptimise(const T& value) {
+#if defined(__GNUC__)
+        asm volatile("" : : "r,m"(value) : "memory");
+#else
+        static volatile const T* sink;
+        sink = &value;
+#endif
+    }
+
+    /* Handed to a benchmark function, which sets up its data, then loops
+    while (state.keepRunning()) around the code being measured. Only time
+    spent inside the loop counts, minus any pauseTiming/resumeTiming spans.*/
+    class State {
+    private:
+        using Clock = std::chrono::steady_clock;
+
+        std::uint64_t max_iterations;
+        std::uint64_t done = 0;
+        std::int64_t argument;
+        bool running = false;
+        Clock::time_point started;
+        double elapsed = 0.0;
+
+    public:
+        std::uint64_t items_processed = 0;                      // Reported as items_per_second when set
+        std::vector<std::pair<std::string, double>> counters;   // Extra values reported as-is
+
+        State(std::uint64_t iterations, std::int64_t arg) : max_iterations(iterations), argument(arg) {}
+
+        bool keepRunning() {
+            if (done == 0 && !running) {
+                resumeTiming();
+            }
+            if (done < max_iterations) {
+                done++;
+                return true;
+            }
+            pauseTiming();
+            return false;
+        }
+        void pauseTiming() {
+            if (running) {
+                elapsed += std::chrono::duration<double>(Clock::now() - started).count();
+                running = false;
+            }
+        }
+        void resumeTiming() {
+            running = true;
+            started = Clock::now();
+        }
+
+        std::int64_t range() const { return argument; }     // The argument the benchmark was registered with
+        std::uint64_t iterations() const { return max_iterations; }
+        double seconds() const { return elapsed; }
+        void setItemsProcessed(std::uint64_t items) { items_processed = items; }
+        void counter(const char* name, double value) { counters.emplace_back(name, value); }
+    };
+
+    struct Benchmark {
+        std::string name;
+        std::function<void(State&)> function;
+        std::int64_t argument;
+    };
+
+    inline std::vector<Benchmark>& registry() {
+        static std::vector<Benchmark> benchmarks;
+        return benchmarks;
+    }
+
+    /* Registers function once per argument, named name/argument, or just name
+    when arguments is empty. Use from a static initialiser:
+        static bench::Registration r("world/step", stepBenchmark, {1000, 10000});*/
+    struct Registration {
+        Registration(const std::string& name, std::function<void(State&)> function, std::vector<std::int64_t> arguments = {}) {
+            if (arguments.empty()) {
+                registry().push_back(Benchmark{name, function, 0});
+                return;
+            }
+            for (std::int64_t argument : arguments) {
+                registry().push_back(Benchmark{name + "/" + std::to_string(argument), function, argument});
+            }
+        }
+    };
+
+    // ======================================================================== //
+    // ================================== Running ============================= //
+    // ======================================================================== //
+
+    struct Options {
+        std::string filter;
+        double min_time = 0.2;
+        int repetitions = 5;
+        std::string out;
+        bool list = false;
+    };
+
+    struct Run {
+        std::string name;        // name, or name_<aggregate> for aggregates
+        std::string run_name;
+        std::string aggregate;   // empty for a plain repetition
+        int repetition_index = 0;
+        std::uint64_t iterations = 0;
+        double ns = 0.0;         // per iteration
+        double items_per_second = 0.0;
+        std::vector<std::pair<std::string, double>> counters;
+    };
+
+    inline Options parseOptions(int argc, char** argv) {
+        Options options;
+        for (int i = 1; i < argc; i++) {
+            const char* arg = argv[i];
+            auto value = [arg](const char* flag) -> const char* {
+                std::size_t length = std::strlen(flag);
+                return std::strncmp(arg, flag, length) == 0 && arg[length] == '=' ? arg + length + 1 : nullptr;
+            };
+            if (const char* v = value("--benchmark_filter")) {
+                options.filter = v;
+            } else if (const char* v = value("--benchmark_min_time")) {
+                options.min_time = std::atof(v);
+            } else if (const char* v = value("--benchmark_repetitions")) {
+                options.repetitions = std::max(1, std::atoi(v));
+            } else if (const char* v = value("--benchmark_out")) {
+                options.out = v;
+            } else if (std::strcmp(arg, "--benchmark_list_tests") == 0) {
+                options.list = true;
+            } else {
+                std::fprintf(stderr, "unknown flag %s\n", arg);
+                std::exit(1);
+            }
+        }
+        return options;
+    }
+
+    // Runs benchmark with the given iteration count and returns the measured state
+    inline State runOnce(const Benchmark& benchmark, std::uint64_t iterations) {
+        State state(iterations, benchmark.argument);
+        benchmark.function(state);
+        return state;
+    }
+
+    /* Grows the iteration count from 1 until one run lasts min_time, scaling by
+    the measured time per iteration (at most 10x per attempt), like Google
+    Benchmark does. Benchmarks slow enough to exceed min_time in one iteration
+    just run once.*/
+    inline std::uint64_t chooseIterations(const Benchmark& benchmark, double min_time) {
+        std::uint64_t iterations = 1;
+        for (;;) {
+            State state = runOnce(benchmark, iterations);
+            double seconds = state.seconds();
+            if (seconds >= min_time || iterations >= 1000000000ULL) {
+                return iterations;
+            }
+            double scale = seconds > 0.0 ? 1.4 * min_time / seconds : 10.0;
+            scale = std::min(10.0, std::max(scale, 2.0));
+            iterations = static_cast<std::uint64_t>(static_cast<double>(iterations) * scale);
+        }
+    }
+
+    inline Run aggregate(const std::vector<Run>& runs, const char* kind) {
+        Run result = runs.front();
+        result.aggregate = kind;
+        result.name = result.run_name + "_" + kind;
+        auto reduce = [&](auto field) {
+            std::vector<double> values;
+            for (const Run& run : runs) {
+                values.push_back(field(run));
+            }
+            double mean = 0.0;
+            for (double v : values) {
+                mean += v;
+            }
+            mean /= static_cast<double>(values.size());
+            if (std::strcmp(kind, "mean") == 0) {
+                return mean;
+            }
+            if (std::strcmp(kind, "median") == 0) {
+                std::sort(values.begin(), values.end());
+                std::size_t mid = values.size() / 2;
+                return values.size() % 2 ? values[mid] : 0.5 * (values[mid - 1] + values[mid]);
+            }
+            double variance = 0.0;
+            for (double v : values) {
+                variance += (v - mean) * (v - mean);
+            }
+            return values.size() > 1 ? std::sqrt(variance / static_cast<double>(values.size() - 1)) : 0.0;
+        };
+        result.ns = reduce([](const Run& run) { return run.ns; });
+        result.items_per_second = reduce([](const Run& run) { return run.items_per_second; });
+        for (std::size_t c = 0; c < result.counters.size(); c++) {
+            result.counters[c].second = reduce([c](const Run& run) { return run.counters[c].second; });
+        }
+        return result;
+    }
+
+    inline void writeJson(const std::string& path, const std::vector<Run>& runs, const char* build) {
+        std::FILE* file = std::fopen(path.c_str(), "w");
+        if (!file) {
+            std::fprintf(stderr, "cannot write %s\n", path.c_str());
+            std::exit(1);
+        }
+        char date[64];
+        std::time_t now = std::time(nullptr);
+        std::strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%S", std::localtime(&now));
+        std::fprintf(file, "{\n  \"context\": {\n");
+        std::fprintf(file, "    \"date\": \"%s\",\n", date);
+        std::fprintf(file, "    \"num_cpus\": %u,\n", std::thread::hardware_concurrency());
+        std::fprintf(file, "    \"library_build_type\": \"%s\"\n", build);
+        std::fprintf(file, "  },\n  \"benchmarks\": [");
+        for (std::size_t r = 0; r < runs.size(); r++) {
+            const Run& run = runs[r];
+            std::fprintf(file, "%s\n    {\n", r ? "," : "");
+            std::fprintf(file, "      \"name\": \"%s\",\n", run.name.c_str());
+            std::fprintf(file, "      \"run_name\": \"%s\",\n", run.run_name.c_str());
+            std::fprintf(file, "      \"run_type\": \"%s\",\n", run.aggregate.empty() ? "iteration" : "aggregate");
+            if (run.aggregate.empty()) {
+                std::fprintf(file, "      \"repetition_index\": %d,\n", run.repetition_index);
+            } else {
+                std::fprintf(file, "      \"aggregate_name\": \"%s\",\n", run.aggregate.c_str());
+            }
+            std::fprintf(file, "      \"iterations\": %llu,\n", static_cast<unsigned long long>(run.iterations));
+            std::fprintf(file, "      \"real_time\": %.6g,\n", run.ns);
+            std::fprintf(file, "      \"time_unit\": \"ns\"");
+            if (run.items_per_second > 0.0) {
+                std::fprintf(file, ",\n      \"items_per_second\": %.6g", run.items_per_second);
+            }
+            for (const auto& counter : run.counters) {
+                std::fprintf(file, ",\n      \"%s\": %.6g", counter.first.c_str(), counter.second);
+            }
+            std::fprintf(file, "\n    }");
+        }
+        std::fprintf(file, "\n  ]\n}\n");
+        std::fclose(file);
+    }
+
+    // Prints a time in the most readable unit
+    inline void printTime(double ns) {
+        if (ns >= 1e6) {
+            std::printf("%12.3f ms", ns / 1e6);
+        } else if (ns >= 1e3) {
+            std::printf("%12.3f us", ns / 1e3);
+        } else {
+            std::printf("%12.3f ns", ns);
+        }
+    }
+
+    /* Runs every registered benchmark matching the filter and returns the exit
+    code for main. build names the configuration the binary was compiled with.*/
+    inline int runBenchmarks(int argc, char** argv, const char* build) {
+        Options options = parseOptions(argc, argv);
+        std::vector<Run> results;
+
+        if (!options.list) {
+            std::printf("%-40s %15s %12s %16s\n", "benchmark", "time/iter", "iterations", "items/sec");
+        }
+        for (const Benchmark& benchmark : registry()) {
+            if (benchmark.name.find(options.filter) == std::string::npos) {
+                continue;
+            }
+            if (options.list) {
+                std::printf("%s\n", benchmark.name.c_str());
+                continue;
+            }
+
+            std::uint64_t iterations = chooseIterations(benchmark, options.min_time);
+            std::vector<Run> runs;
+            for (int r = 0; r < options.repetitions; r++) {
+                State state = runOnce(benchmark, iterations);
+                Run run;
+                run.name = run.run_name = benchmark.name;
+                run.repetition_index = r;
+                run.iterations = iterations;
+                run.ns = state.seconds() * 1e9 / static_cast<double>(iterations);
+                run.items_per_second = state.items_processed > 0 && state.seconds() > 0.0 ? state.items_processed / state.seconds() : 0.0;
+                run.counters = state.counters;
+                runs.push_back(run);
+            }
+            results.insert(results.end(), runs.begin(), runs.end());
+            results.push_back(aggregate(runs, "mean"));
+            results.push_back(aggregate(runs, "median"));
+            results.push_back(aggregate(runs, "stddev"));
+
+            const Run& median = results[results.size() - 2];
+            std::printf("%-40s ", benchmark.name.c_str());
+            printTime(median.ns);
+            std::printf(" %12llu", static_cast<unsigned long long>(iterations));
+            if (median.items_per_second > 0.0) {
+                std::printf(" %16.4g", median.items_per_second);
+            }
+            std::printf("\n");
+            std::fflush(stdout);
+        }
+
+        if (!options.out.empty() && !options.list) {
+            writeJson(options.out, results, build);
+        }
+        return 0;
+    }
+
+} // namespace bench
+
+#endif
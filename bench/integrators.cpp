@@ -0,0 +1,138 @@
+// Integrator benchmark: energy drift of circular orbits around a fixed point mass
+// against the cost of a step, for each integrator policy and a few timesteps.
+// Runs each policy on a functor through integrateRange, then in World::step
+// with the central mass as a static body pulling through MutualGravity.
+// Usage: integrators [bodies] [orbits]
+#include <body_store.h>
+#include <integrate.h>
+#include <world.h>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+namespace {
+
+    const float GM = 1.0f;  // gravitational parameter of the central mass at the origin
+
+    // Inverse square attraction towards the origin, depends only on position
+    struct CentralGravity {
+        void operator()(std::size_t, float x, float y, float, float, float& ax, float& ay) const {
+            float r2 = x * x + y * y;
+            float inv_r = 1.0f / std::sqrt(r2);
+            float scale = -GM * inv_r * inv_r * inv_r;
+            ax = x * scale;
+            ay = y * scale;
+        }
+    };
+
+    // Specific orbital energy, v^2 / 2 - GM / r, in double so the measurement adds no error
+    double energy(const world::BodyStore& store, std::uint32_t i) {
+        double x = store.x()[i], y = store.y()[i], vx = store.vx()[i], vy = store.vy()[i];
+        return 0.5 * (vx * vx + vy * vy) - GM / std::sqrt(x * x + y * y);
+    }
+
+    // Bodies on circular orbits of radius 1 to 2 (periods 2*pi to about 17.8)
+    void buildOrbits(world::BodyStore& store, int bodies) {
+        store.clear();
+        store.reserve(bodies);
+        for (int i = 0; i < bodies; i++) {
+            float r = 1.0f + static_cast<float>(i) / bodies;
+            float angle = 0.61803f * i;
+            float speed = std::sqrt(GM / r);
+            world::BodyHandle handle = store.create(r * std::cos(angle), r * std::sin(angle), 0.01f, 1.0f);
+            store.setVelocity(store.indexOf(handle), -speed * std::sin(angle), speed * std::cos(angle));
+        }
+    }
+
+    template<typename Integrator>
+    void run(const char* name, world::BodyStore& store, int bodies, float orbits, float dt) {
+        buildOrbits(store, bodies);
+        std::vector<double> initial(bodies);
+        for (int i = 0; i < bodies; i++) {
+            initial[i] = energy(store, i);
+        }
+
+        // Simulate for the given number of periods of the innermost orbit
+        const int steps = static_cast<int>(orbits * 2.0f * 3.14159265f / dt);
+        auto start = std::chrono::steady_clock::now();
+        for (int s = 0; s < steps; s++) {
+            world::integrateRange<Integrator>(store, 0, store.size(), dt, CentralGravity());
+        }
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        // Worst relative energy error over all bodies
+        double drift = 0.0;
+        for (int i = 0; i < bodies; i++) {
+            drift = std::fmax(drift, std::fabs((energy(store, i) - initial[i]) / initial[i]));
+        }
+        double ns = seconds * 1e9 / (static_cast<double>(steps) * bodies);
+        std::printf("%20s %8.3f %8d %14.3e %14.2f %8d\n", name, dt, steps, drift, ns, Integrator::evaluations);
+    }
+
+    /* The same orbits stepped by a World: the unit mass is a static body at the
+    origin and the orbiting bodies are too light to pull each other measurably.
+    Their radii are spaced so they never touch, and sleeping is off.*/
+    template<typename Integrator>
+    void runWorld(const char* name, int bodies, float orbits, float dt) {
+        world::World sim(1);
+        sim.sleepSettings().enabled = false;
+        sim.addForceGenerator(std::make_unique<forces::MutualGravity>(1.0f, 0.5f, 0.0f));
+        sim.setIntegrator<Integrator>();
+        sim.createCircle({0.0f, 0.0f}, 0.5f, GM, true);
+            for (int i = 0; i < bodies; i++) {
+            float r = 1.0f + static_cast<float>(i) / bodies;
+            float angle = 0.61803f * i;
+            float speed = std::sqrt(GM / r);
+            objects::Circle circle = sim.createCircle({r * std::cos(angle), r * std::sin(angle)}, 0.2f / bodies, 1e-9f);
+            circle.setVelocity({-speed * std::sin(angle), speed * std::cos(angle)});
+        }
+
+        // Orbiting bodies keep their creation order after the static one: dense indices 1..bodies
+        std::vector<double> initial(bodies);
+        for (int i = 0; i < bodies; i++) {
+            initial[i] = energy(sim.bodies(), i + 1);
+        }
+        const int steps = static_cast<int>(orbits * 2.0f * 3.14159265f / dt);
+        auto start = std::chrono::steady_clock::now();
+        for (int s = 0; s < steps; s++) {
+            sim.step(dt);
+        }
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        double drift = 0.0;
+        for (int i = 0; i < bodies; i++) {
+            drift = std::fmax(drift, std::fabs((energy(sim.bodies(), i + 1) - initial[i]) / initial[i]));
+        }
+        double ns = seconds * 1e9 / (static_cast<double>(steps) * bodies);
+        std::printf("%20s %8.3f %8d %14.3e %14.2f %8d\n", name, dt, steps, drift, ns, Integrator::evaluations);
+    }
+
+}
+
+int main(int argc, char** argv) {
+    int bodies = argc > 1 ? std::atoi(argv[1]) : 10000;
+    float orbits = argc > 2 ? static_cast<float>(std::atof(argv[2])) : 10.0f;
+
+    world::BodyStore store;
+    std::printf("bodies=%d orbits=%.1f\n", bodies, orbits);
+    std::printf("%20s %8s %8s %14s %14s %8s\n", "integrator", "dt", "steps", "energy drift", "ns/body-step", "evals");
+    const float timesteps[] = {0.1f, 0.05f, 0.01f};
+    for (float dt : timesteps) {
+        run<world::SemiImplicitEuler>("semi-implicit-euler", store, bodies, orbits, dt);
+        run<world::VelocityVerlet>("velocity-verlet", store, bodies, orbits, dt);
+        run<world::RungeKutta4>("rk4", store, bodies, orbits, dt);
+    }
+
+    // A whole step per evaluation is much dearer, so the World runs a tenth of the bodies
+    const int world_bodies = bodies / 10 > 0 ? bodies / 10 : 1;
+    std::printf("world::step with MutualGravity, bodies=%d\n", world_bodies);
+    std::printf("%20s %8s %8s %14s %14s %8s\n", "integrator", "dt", "steps", "energy drift", "ns/body-step", "evals");
+    for (float dt : timesteps) {
+        runWorld<world::SemiImplicitEuler>("semi-implicit-euler", world_bodies, orbits, dt);
+        runWorld<world::VelocityVerlet>("velocity-verlet", world_bodies, orbits, dt);
+        runWorld<world::RungeKutta4>("rk4", world_bodies, orbits, dt);
+    }
+    return 0;
+}
@@ -0,0 +1,95 @@
+// Thread scaling benchmark: steps/sec of World::step at 1, 2, 4, ... N threads,
+// plus the heap allocations made by the timed (post warm-up) steps, counted by
+// bench/support/count_allocations.cpp. Exits with 1 if any timed step allocated
+// or a thread count didn't reproduce the single-threaded result.
+// Usage: scaling [bodies] [steps] [max_threads]
+#include <world.h>
+#include <allocation.h>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <thread>
+#include <vector>
+
+namespace {
+
+    // Random circles in a square sized for roughly constant density, one in ten static
+    void buildScene(world::World& world, int bodies) {
+        std::mt19937 rng(42);
+        float side = std::sqrt(static_cast<float>(bodies)) * 3.0f;
+        std::uniform_real_distribution<float> position(0.0f, side);
+        std::uniform_real_distribution<float> radius(0.4f, 1.0f);
+        std::uniform_real_distribution<float> speed(-2.0f, 2.0f);
+
+        world.bodies().reserve(bodies);
+        for (int i = 0; i < bodies; i++) {
+            bool is_static = i % 10 == 0;
+            objects::Circle circle = world.createCircle(vector::Vector<float, 2>(position(rng), position(rng)), radius(rng), 1.0f, is_static, 0.5f);
+            if (!is_static) {
+                circle.setVelocity(speed(rng), speed(rng));
+            }
+        }
+    }
+
+}
+
+int main(int argc, char** argv) {
+    int bodies = argc > 1 ? std::atoi(argv[1]) : 100000;
+    int steps = argc > 2 ? std::atoi(argv[2]) : 100;
+    unsigned max_threads = argc > 3 ? static_cast<unsigned>(std::atoi(argv[3])) : std::thread::hardware_concurrency();
+    if (max_threads == 0) {
+        max_threads = 1;
+    }
+
+    std::printf("bodies=%d steps=%d\n", bodies, steps);
+    std::printf("%8s %12s %10s %10s %10s\n", "threads", "steps/sec", "speedup", "identical", "allocs");
+
+    std::vector<float> reference;
+    double base_rate = 0.0;
+    bool passed = true;
+    for (unsigned threads = 1;; threads *= 2) {
+        if (threads > max_threads) {
+            threads = max_threads;
+        }
+
+        world::World world(threads);
+        std::uint64_t building = memory::heapAllocations();
+        buildScene(world, bodies);
+        if (memory::heapAllocations() == building) {
+            std::printf("allocations aren't counted, link bench/support/count_allocations.cpp\n");
+            return 1;
+        }
+        for (int s = 0; s < 10; s++) {
+            world.step(1.0f / 60.0f);  // warm-up: sizes the per-step buffers
+        }
+
+        std::uint64_t allocations = memory::heapAllocations();
+        auto start = std::chrono::steady_clock::now();
+        for (int s = 0; s < steps; s++) {
+            world.step(1.0f / 60.0f);
+        }
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        allocations = memory::heapAllocations() - allocations;
+        double rate = steps / seconds;
+
+        // Every thread count must reproduce the single-threaded result exactly
+        const world::BodyStore& store = world.bodies();
+        std::vector<float> state(store.x(), store.x() + store.size());
+        state.insert(state.end(), store.y(), store.y() + store.size());
+        if (reference.empty()) {
+            reference = state;
+            base_rate = rate;
+        }
+        bool identical = std::memcmp(state.data(), reference.data(), state.size() * sizeof(float)) == 0;
+
+        std::printf("%8u %12.2f %9.2fx %10s %10llu\n", threads, rate, rate / base_rate, identical ? "yes" : "NO",
+                    static_cast<unsigned long long>(allocations));
+        passed = passed && identical && allocations == 0;
+        if (threads == max_threads) {
+            break;
+        }
+    }
+    return passed ? 0 : 1;
+}
@@ -0,0 +1,179 @@
+// Snapshot benchmark: building a scene body by body against loading it from a
+// snapshot, and what streaming a replay recording costs the stepping thread.
+// Usage: snapshot [bodies] [frames]
+#include <world.h>
+#include <snapshot.h>
+#include <recorder.h>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <vector>
+
+namespace {
+
+    const char* SNAPSHOT_PATH = "bench_snapshot.snap";
+    const char* RECORDING_PATH = "bench_recording.rec";
+
+    double secondsSince(std::chrono::steady_clock::time_point start) {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    // Random circles in a square sized for roughly constant density, one in ten static
+    void buildScene(world::World& world, int bodies) {
+        std::mt19937 rng(42);
+        float side = std::sqrt(static_cast<float>(bodies)) * 3.0f;
+        std::uniform_real_distribution<float> position(0.0f, side);
+        std::uniform_real_distribution<float> radius(0.4f, 1.0f);
+        std::uniform_real_distribution<float> speed(-2.0f, 2.0f);
+
+        world.bodies().reserve(bodies);
+        for (int i = 0; i < bodies; i++) {
+            bool is_static = i % 10 == 0;
+            objects::Circle circle = world.createCircle(vector::Vector<float, 2>(position(rng), position(rng)), radius(rng), 1.0f, is_static, 0.5f);
+            if (!is_static) {
+                circle.setVelocity(speed(rng), speed(rng));
+            }
+        }
+    }
+
+    bool sameArray(const float* a, const float* b, std::size_t count) { return std::memcmp(a, b, count * sizeof(float)) == 0; }
+
+    bool sameBodies(const world::BodyStore& a, const world::BodyStore& b) {
+        std::size_t n = a.size();
+        return n == b.size() && sameArray(a.x(), b.x(), n) && sameArray(a.y(), b.y(), n) && sameArray(a.vx(), b.vx(), n) &&
+               sameArray(a.vy(), b.vy(), n) && sameArray(a.invMass(), b.invMass(), n) && sameArray(a.radius(), b.radius(), n) &&
+               std::memcmp(a.flags(), b.flags(), n * sizeof(std::uint32_t)) == 0;
+    }
+
+}
+
+int main(int argc, char** argv) {
+    int bodies = argc > 1 ? std::atoi(argv[1]) : 1000000;
+    int frames = argc > 2 ? std::atoi(argv[2]) : 240;
+    std::printf("bodies=%d frames=%d\n", bodies, frames);
+
+    // Scene creation: createCircle one body at a time, then save and load
+    world::World built(1);
+    auto start = std::chrono::steady_clock::now();
+    buildScene(built, bodies);
+    double build_seconds = secondsSince(start);
+
+    start = std::chrono::steady_clock::now();
+    bool saved = built.saveSnapshot(SNAPSHOT_PATH);
+    double save_seconds = secondsSince(start);
+
+    snapshot::View view;
+    start = std::chrono::steady_clock::now();
+    bool mapped = view.open(SNAPSHOT_PATH);
+    double map_seconds = secondsSince(start);
+    view.close();
+
+    world::World loaded(1);
+    start = std::chrono::steady_clock::now();
+    bool restored = loaded.loadSnapshot(SNAPSHOT_PATH);
+    double load_seconds = secondsSince(start);
+    if (!saved || !mapped || !restored) {
+        std::fprintf(stderr, "snapshot round trip failed (save=%d map=%d load=%d)\n", saved, mapped, restored);
+        return 1;
+    }
+
+    std::printf("\n%-24s %12s\n", "scene", "ms");
+    std::printf("%-24s %12.2f\n", "createCircle", build_seconds * 1e3);
+    std::printf("%-24s %12.2f\n", "saveSnapshot", save_seconds * 1e3);
+    std::printf("%-24s %12.3f\n", "View::open (map only)", map_seconds * 1e3);
+    const bool identical = sameBodies(built.bodies(), loaded.bodies());
+    std::printf("%-24s %12.2f   %.1fx faster, identical=%s\n", "loadSnapshot", load_seconds * 1e3, build_seconds / load_seconds, identical ? "yes" : "NO");
+
+    // Recording: capture cost on the stepping thread and the encoded size
+    recording::Recorder recorder;
+    if (!recorder.open(RECORDING_PATH)) {
+        std::fprintf(stderr, "can't create %s\n", RECORDING_PATH);
+        return 1;
+    }
+    // The state of the last frame stored, whichever that was, to check the replay against
+    std::vector<float> last[4];
+    std::uint64_t last_stored = 0;
+    bool any_stored = false;
+    std::vector<double> capture_seconds(frames);
+    for (int f = 0; f < frames; f++) {
+        loaded.step(1.0f / 60.0f);
+        start = std::chrono::steady_clock::now();
+        bool captured = recorder.capture(loaded.bodies());
+        capture_seconds[f] = secondsSince(start);
+        if (captured) {
+            const world::BodyStore& store = loaded.bodies();
+            last[0].assign(store.x(), store.x() + store.size());
+            last[1].assign(store.y(), store.y() + store.size());
+            last[2].assign(store.vx(), store.vx() + store.size());
+            last[3].assign(store.vy(), store.vy() + store.size());
+            last_stored = recorder.framesCaptured() - 1;
+            any_stored = true;
+        }
+    }
+    recorder.close();
+
+    // Replay, checking the last frame against the simulation within half a quantisation step
+    recording::Reader reader;
+    recording::Frame frame;
+    std::uint64_t keyframes = 0, replayed = 0;
+    double max_error[2] = {0.0, 0.0};   // positions, velocities
+    bool within_step = true;
+    if (reader.open(RECORDING_PATH)) {
+        while (reader.next(frame)) {
+            replayed++;
+            keyframes += frame.keyframe ? 1 : 0;
+        }
+    }
+    const bool last_matches = !any_stored || (replayed > 0 && frame.frame == last_stored && frame.x.size() == last[0].size());
+    if (any_stored && last_matches) {
+        const std::vector<float>* replay[4] = {&frame.x, &frame.y, &frame.vx, &frame.vy};
+        for (int c = 0; c < 4; c++) {
+            const double step = c < 2 ? reader.positionStep() : reader.velocityStep();
+            for (std::size_t i = 0; i < last[c].size(); i++) {
+                // Half a step from quantising, plus half an ulp from rounding the result back to float
+                float value = std::fabs(last[c][i]);
+                double bound = 0.5 * step + 0.5 * (std::nextafter(value, INFINITY) - value);
+                double error = std::fabs(static_cast<double>((*replay[c])[i]) - last[c][i]);
+                max_error[c / 2] = std::fmax(max_error[c / 2], error);
+                within_step = within_step && error <= bound;
+            }
+        }
+    }
+
+    std::uint64_t stored = recorder.framesCaptured() - recorder.framesDropped();
+    double raw_bytes = static_cast<double>(stored) * bodies * 4 * sizeof(float);
+    std::printf("\n%-24s %12s\n", "recording", "");
+    // The minimum is the copy alone; with few cores the median also holds time the I/O thread took while encoding
+    std::sort(capture_seconds.begin(), capture_seconds.end());
+    std::printf("%-24s %12.1f / %.1f\n", "capture us min/median", frames ? capture_seconds[0] * 1e6 : 0.0, frames ? capture_seconds[frames / 2] * 1e6 : 0.0);
+    std::printf("%-24s %12llu / %llu\n", "frames dropped", static_cast<unsigned long long>(recorder.framesDropped()),
+                static_cast<unsigned long long>(recorder.framesCaptured()));
+    std::printf("%-24s %12.1f\n", "bytes/body/frame", stored ? recorder.bytesWritten() / static_cast<double>(stored) / bodies : 0.0);
+    std::printf("%-24s %12.1fx\n", "compression vs floats", raw_bytes / recorder.bytesWritten());
+    std::printf("%-24s %12llu / %llu keyframes\n", "frames replayed", static_cast<unsigned long long>(replayed), static_cast<unsigned long long>(keyframes));
+    std::printf("%-24s %12.2e (step %.2e)\n", "max position error", max_error[0], static_cast<double>(reader.positionStep()));
+    std::printf("%-24s %12.2e (step %.2e)\n", "max velocity error", max_error[1], static_cast<double>(reader.velocityStep()));
+
+    std::remove(SNAPSHOT_PATH);
+    std::remove(RECORDING_PATH);
+    // A mismatch anywhere fails the run, so the benchmark doubles as a check
+    bool ok = true;
+    if (!identical) {
+        std::fprintf(stderr, "loaded bodies differ from the saved ones\n");
+        ok = false;
+    }
+    if (replayed != stored || recorder.writeFailed() || !last_matches) {
+        std::fprintf(stderr, "replay read %llu of %llu stored frames%s\n", static_cast<unsigned long long>(replayed),
+                     static_cast<unsigned long long>(stored), last_matches ? "" : ", last frame doesn't match the last capture");
+        ok = false;
+    }
+    if (!within_step) {
+        std::fprintf(stderr, "replayed values are more than half a quantisation step from the simulation\n");
+        ok = false;
+    }
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,222 @@
+// Regression benchmark suite: Vector operations, Circle::update throughput,
+// broad-phase pair generation and full World::step throughput at 1k to 1M
+// bodies. Takes the flags described in harness.h; `make bench-run` writes the
+// results as JSON and `make bench-compare` checks them against a baseline.
+// Usage: suite [--benchmark_filter=world/step] [--benchmark_out=results.json]
+#include "harness.h"
+#include <aabb_tree.h>
+#include <broadphase.h>
+#include <objects.h>
+#include <vector.h>
+#include <world.h>
+#include <cmath>
+#include <memory>
+#include <random>
+#include <vector>
+
+#ifndef BUILD_CONFIG
+#define BUILD_CONFIG unknown
+#endif
+#define BENCH_STRING(x) BENCH_STRING_VALUE(x)
+#define BENCH_STRING_VALUE(x) #x
+
+namespace {
+
+    const float DT = 1.0f / 60.0f;
+
+    // Random circles in a square sized for roughly constant density, one in ten static
+    template<typename Create>
+    void buildScene(int bodies, Create&& create) {
+        std::mt19937 rng(42);
+        float side = std::sqrt(static_cast<float>(bodies)) * 3.0f;
+        std::uniform_real_distribution<float> position(0.0f, side);
+        std::uniform_real_distribution<float> radius(0.4f, 1.0f);
+        std::uniform_real_distribution<float> speed(-2.0f, 2.0f);
+        for (int i = 0; i < bodies; i++) {
+            float x = position(rng), y = position(rng), r = radius(rng);
+            float vx = speed(rng), vy = speed(rng);
+            create(i, x, y, r, i % 10 == 0, vx, vy);
+        }
+    }
+
+    // ======================================================================== //
+    // ================================== Vector ============================== //
+    // ======================================================================== //
+
+    const int VECTOR_COUNT = 4096;
+
+    template<typename T, int Dimension>
+    std::vector<vector::Vector<T, Dimension>> vectors(T offset) {
+        std::vector<vector::Vector<T, Dimension>> values(VECTOR_COUNT);
+        for (int i = 0; i < VECTOR_COUNT; i++) {
+            for (int d = 0; d < Dimension; d++) {
+                values[i][d] = static_cast<T>((i * 7 + d * 3) % 17) * T(0.25) + offset;
+            }
+        }
+        return values;
+    }
+
+    // r = a + b * dt - c over arrays of vectors
+    template<typename T, int Dimension>
+    void vectorChain(bench::State& state) {
+        auto a = vectors<T, Dimension>(T(1)), b = vectors<T, Dimension>(T(2)), c = vectors<T, Dimension>(T(3));
+        std::vector<vector::Vector<T, Dimension>> r(VECTOR_COUNT);
+        const T dt = T(0.016);
+        while (state.keepRunning()) {
+            for (int i = 0; i < VECTOR_COUNT; i++) {
+                r[i] = a[i] + b[i] * dt - c[i];
+            }
+            bench::doNotOptimise(r.data());
+        }
+        state.setItemsProcessed(state.iterations() * VECTOR_COUNT);
+    }
+
+    template<typename T, int Dimension>
+    void vectorDot(bench::State& state) {
+        auto a = vectors<T, Dimension>(T(1)), b = vectors<T, Dimension>(T(2));
+        while (state.keepRunning()) {
+            T sum = 0;
+            for (int i = 0; i < VECTOR_COUNT; i++) {
+                sum += a[i].dot(b[i]);
+            }
+            bench::doNotOptimise(sum);
+        }
+        state.setItemsProcessed(state.iterations() * VECTOR_COUNT);
+    }
+
+    template<typename T, int Dimension, bool Fast>
+    void vectorNormalise(bench::State& state) {
+        auto a = vectors<T, Dimension>(T(1));
+        std::vector<vector::Vector<T, Dimension>> r(VECTOR_COUNT);
+        while (state.keepRunning()) {
+            for (int i = 0; i < VECTOR_COUNT; i++) {
+                r[i] = Fast ? a[i].fastNormalised() : a[i].normalised();
+            }
+            bench::doNotOptimise(r.data());
+        }
+        state.setItemsProcessed(state.iterations() * VECTOR_COUNT);
+    }
+
+    bench::Registration vector_chain_f2("vector/chain/float2", vectorChain<float, 2>);
+    bench::Registration vector_chain_f3("vector/chain/float3", vectorChain<float, 3>);
+    bench::Registration vector_chain_f4("vector/chain/float4", vectorChain<float, 4>);
+    bench::Registration vector_chain_d2("vector/chain/double2", vectorChain<double, 2>);
+    bench::Registration vector_dot_f2("vector/dot/float2", vectorDot<float, 2>);
+    bench::Registration vector_dot_f4("vector/dot/float4", vectorDot<float, 4>);
+    bench::Registration vector_normalise_f2("vector/normalised/float2", vectorNormalise<float, 2, false>);
+    bench::Registration vector_fast_normalise_f2("vector/fastNormalised/float2", vectorNormalise<float, 2, true>);
+
+    // ======================================================================== //
+    // ============================== Circle::update ========================== //
+    // ======================================================================== //
+
+    // Standalone circles, each holding its own state
+    void circleUpdateStandalone(bench::State& state) {
+        std::vector<objects::Circle> circles;
+        circles.reserve(state.range());
+        buildScene(static_cast<int>(state.range()), [&](int, float x, float y, float r, bool is_static, float vx, float vy) {
+            circles.emplace_back(vector::Vector<float, 2>(x, y), r, 1.0f, is_static, 0.5f);
+            circles.back().setVelocity(vx, vy);
+        });
+        // Forces last one update, so gravity is applied before each as a per-object caller would
+        while (state.keepRunning()) {
+            for (objects::Circle& circle : circles) {
+                circle.applyForce(0.0f, -9.81f);
+                circle.update(DT);
+            }
+        }
+        state.setItemsProcessed(state.iterations() * circles.size());
+    }
+
+    // Views onto bodies in a BodyStore, each update resolving its handle
+    void circleUpdateView(bench::State& state) {
+        world::BodyStore store;
+        std::vector<objects::Circle> circles;
+        store.reserve(state.range());
+        circles.reserve(state.range());
+        buildScene(static_cast<int>(state.range()), [&](int, float x, float y, float r, bool is_static, float vx, float vy) {
+            world::BodyHandle handle = store.create(x, y, r, 1.0f, is_static, 0.5f);
+            circles.emplace_back(store, handle);
+            circles.back().setVelocity(vx, vy);
+        });
+        // Forces last one update, so gravity is applied before each as a per-object caller would
+        while (state.keepRunning()) {
+            for (objects::Circle& circle : circles) {
+                circle.applyForce(0.0f, -9.81f);
+                circle.update(DT);
+            }
+        }
+        state.setItemsProcessed(state.iterations() * circles.size());
+    }
+
+    bench::Registration circle_standalone("circle/update/standalone", circleUpdateStandalone, {1000, 100000});
+    bench::Registration circle_view("circle/update/view", circleUpdateView, {1000, 100000});
+
+    // ======================================================================== //
+    // ================================ Broad-phase =========================== //
+    // ======================================================================== //
+
+    /* findPairs over a fixed scene. The store is kept between runs of the same
+    size so the million body scene is only built once.*/
+    template<typename Backend>
+    void broadPhasePairs(bench::State& state) {
+        static std::unique_ptr<world::BodyStore> store;
+        if (!store || static_cast<std::int64_t>(store->size()) != state.range()) {
+            store.reset(new world::BodyStore());
+            store->reserve(state.range());
+            buildScene(static_cast<int>(state.range()), [&](int, float x, float y, float r, bool is_static, float, float) {
+                store->create(x, y, r, 1.0f, is_static, 0.5f);
+            });
+        }
+        Backend backend;
+        std::vector<broadphase::BodyPair> pairs;
+        backend.findPairs(*store, pairs);  // warm-up: sizes buffers and builds persistent structures
+        backend.resetStats();
+        while (state.keepRunning()) {
+            backend.findPairs(*store, pairs);
+        }
+        state.setItemsProcessed(state.iterations() * store->size());
+        state.counter("pairs", static_cast<double>(pairs.size()));
+    }
+
+    bench::Registration broad_brute("broadphase/brute-force", broadPhasePairs<broadphase::BruteForce>, {1000, 10000});
+    bench::Registration broad_grid("broadphase/spatial-hash-grid", broadPhasePairs<broadphase::SpatialHashGrid>, {1000, 10000, 100000, 1000000});
+    bench::Registration broad_sap("broadphase/sweep-and-prune", broadPhasePairs<broadphase::SweepAndPrune>, {1000, 10000, 100000, 1000000});
+    bench::Registration broad_tree("broadphase/dynamic-aabb-tree", broadPhasePairs<broadphase::TreeBroadPhase>, {1000, 10000, 100000, 1000000});
+
+    // ======================================================================== //
+    // ================================ World::step =========================== //
+    // ======================================================================== //
+
+    /* Full step: integrate, broad-phase, narrow-phase, solve, islands. Like the
+    broad-phase benchmarks the world is kept between runs of the same size, so
+    later repetitions keep stepping the same, settling, scene.*/
+    void worldStep(bench::State& state) {
+        static std::unique_ptr<world::World> world;
+        if (!world || static_cast<std::int64_t>(world->bodies().size()) != state.range()) {
+            world.reset(new world::World());
+            world->bodies().reserve(state.range());
+            buildScene(static_cast<int>(state.range()), [&](int, float x, float y, float r, bool is_static, float vx, float vy) {
+                objects::Circle circle = world->createCircle(vector::Vector<float, 2>(x, y), r, 1.0f, is_static, 0.5f);
+                if (!is_static) {
+                    circle.setVelocity(vx, vy);
+                }
+            });
+            for (int s = 0; s < 10; s++) {
+                world->step(DT);  // warm-up: sizes the per-step buffers
+            }
+        }
+        while (state.keepRunning()) {
+            world->step(DT);
+        }
+        state.setItemsProcessed(state.iterations() * world->bodies().size());
+        state.counter("solver_iterations", world->solverIterations());
+    }
+
+    bench::Registration world_step("world/step", worldStep, {1000, 10000, 100000, 1000000});
+
+}
+
+int main(int argc, char** argv) {
+    return bench::runBenchmarks(argc, argv, BENCH_STRING(BUILD_CONFIG));
+}
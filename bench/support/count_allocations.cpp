@@ -0,0 +1,49 @@
+// Opt-in replacement of the global allocation functions that counts every
+// operator new in memory::heapAllocations() before forwarding to malloc.
+// Only executables that link this file pay for the count (see makefile,
+// COUNTING_BENCHES); the library and everything else use the standard ones.
+#include <allocation.h>
+#include <cstdlib>
+#include <new>
+
+// ======================================================================== //
+// ======================== Global Allocation Functions =================== //
+// ======================================================================== //
+// Replacing the plain and aligned forms is enough: the nothrow and array
+// forms are specified to forward to these.
+void* operator new(std::size_t size) {
+    memory::countHeapAllocation();
+    if (void* p = std::malloc(size == 0 ? 1 : size)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void* operator new(std::size_t size, std::align_val_t alignment) {
+    memory::countHeapAllocation();
+    std::size_t align = static_cast<std::size_t>(alignment);
+    if (align < sizeof(void*)) {
+        align = sizeof(void*);
+    }
+#ifdef _WIN32
+    void* p = _aligned_malloc(size == 0 ? 1 : size, align);
+#else
+    void* p = nullptr;
+    if (posix_memalign(&p, align, size == 0 ? 1 : size) != 0) {
+        p = nullptr;
+    }
+#endif
+    if (!p) {
+        throw std::bad_alloc();
+    }
+    return p;
+}
+
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+#ifdef _WIN32
+void operator delete(void* p, std::align_val_t) noexcept { _aligned_free(p); }
+#else
+void operator delete(void* p, std::align_val_t) noexcept { std::free(p); }
+#endif
+void operator delete(void* p, std::size_t, std::align_val_t alignment) noexcept { operator delete(p, alignment); }
@@ -0,0 +1,192 @@
+// Vector microbenchmark: the current vector::Vector (expression templates, SSE
+// specialisations) against the previous implementation (component loops,
+// hand-written copy constructor and assignment), kept below as legacy::Vector.
+// Usage: vector [count] [repeats]
+#include <vector.h>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+namespace legacy {
+
+    // The previous vector::Vector, trimmed to what the benchmark uses
+    template<typename T, int Dimension>
+    class Vector {
+    private:
+        T components[Dimension];
+
+    public:
+        Vector() {
+            for (int i = 0; i < Dimension; i++) {
+                components[i] = T(0);
+            }
+        }
+        Vector(const Vector<T, Dimension>& other) {
+            for (int i = 0; i < Dimension; i++) {
+                components[i] = other[i];
+            }
+        }
+
+        T& operator[](int index) { return components[index]; }
+        const T& operator[](int index) const { return components[index]; }
+
+        Vector<T, Dimension>& operator=(const Vector<T, Dimension>& other) {
+            if (this != &other) {
+                for (int i = 0; i < Dimension; i++) {
+                    components[i] = other[i];
+                }
+            }
+            return *this;
+        }
+        Vector<T, Dimension>& operator+=(const Vector<T, Dimension>& other) {
+            for (int i = 0; i < Dimension; i++) {
+                components[i] += other[i];
+            }
+            return *this;
+        }
+        Vector<T, Dimension> operator+(const Vector<T, Dimension>& other) const {
+            Vector<T, Dimension> result(*this);
+            result += other;
+            return result;
+        }
+        Vector<T, Dimension>& operator-=(const Vector<T, Dimension>& other) {
+            for (int i = 0; i < Dimension; i++) {
+                components[i] -= other[i];
+            }
+            return *this;
+        }
+        Vector<T, Dimension> operator-(const Vector<T, Dimension>& other) const {
+            Vector<T, Dimension> result(*this);
+            result -= other;
+            return result;
+        }
+        Vector<T, Dimension> operator*(T scalar) const {
+            Vector<T, Dimension> result;
+            for (int i = 0; i < Dimension; i++) {
+                result[i] = components[i] * scalar;
+            }
+            return result;
+        }
+        T dot(const Vector<T, Dimension>& other) const {
+            T result = 0;
+            for (int i = 0; i < Dimension; i++) {
+                result += components[i] * other[i];
+            }
+            return result;
+        }
+        T magnitude() const { return std::sqrt(dot(*this)); }
+    };
+
+}
+
+namespace {
+
+    double seconds(std::chrono::steady_clock::time_point start) {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    template<typename V, typename T, int Dimension>
+    void fill(std::vector<V>& values, int count, T offset) {
+        values.resize(count);
+        for (int i = 0; i < count; i++) {
+            for (int d = 0; d < Dimension; d++) {
+                values[i][d] = static_cast<T>((i * 7 + d * 3) % 17) * T(0.25) + offset;
+            }
+        }
+    }
+
+    /* Times r = a + b * dt - c, then r = normalised(r) written with dot/magnitude,
+    over arrays of count vectors. Returns ns per vector for each, plus a checksum
+    so the work can't be optimised away.*/
+    template<typename V, typename T, int Dimension>
+    void chain(const char* label, int count, int repeats) {
+        std::vector<V> a, b, c, r;
+        fill<V, T, Dimension>(a, count, T(1));
+        fill<V, T, Dimension>(b, count, T(2));
+        fill<V, T, Dimension>(c, count, T(3));
+        r.resize(count);
+        const T dt = T(0.016);
+
+        auto start = std::chrono::steady_clock::now();
+        for (int rep = 0; rep < repeats; rep++) {
+            for (int i = 0; i < count; i++) {
+                r[i] = a[i] + b[i] * dt - c[i];
+            }
+        }
+        double chain_ns = seconds(start) * 1e9 / (static_cast<double>(count) * repeats);
+
+        T checksum = 0;
+        start = std::chrono::steady_clock::now();
+        for (int rep = 0; rep < repeats; rep++) {
+            for (int i = 0; i < count; i++) {
+                V n = a[i] * (T(1) / a[i].magnitude());
+                checksum += n.dot(b[i]);
+            }
+        }
+        double normalise_ns = seconds(start) * 1e9 / (static_cast<double>(count) * repeats);
+
+        start = std::chrono::steady_clock::now();
+        for (int rep = 0; rep < repeats; rep++) {
+            c = r;  // bulk copy, a memmove once the type is trivially copyable
+        }
+        double copy_ns = seconds(start) * 1e9 / (static_cast<double>(count) * repeats);
+
+        std::printf("%22s %14.3f %14.3f %12.3f %14g\n", label, chain_ns, normalise_ns, copy_ns, static_cast<double>(checksum + r[count / 2][0] + c[0][0]));
+    }
+
+    // normalised() against fastNormalised() for the new class only
+    template<typename T, int Dimension>
+    void normalise(const char* label, int count, int repeats) {
+        std::vector<vector::Vector<T, Dimension>> a;
+        fill<vector::Vector<T, Dimension>, T, Dimension>(a, count, T(1));
+
+        T checksum = 0;
+        double worst = 0.0;
+        auto start = std::chrono::steady_clock::now();
+        for (int rep = 0; rep < repeats; rep++) {
+            for (int i = 0; i < count; i++) {
+                checksum += a[i].normalised()[0];
+            }
+        }
+        double exact_ns = seconds(start) * 1e9 / (static_cast<double>(count) * repeats);
+
+        start = std::chrono::steady_clock::now();
+        for (int rep = 0; rep < repeats; rep++) {
+            for (int i = 0; i < count; i++) {
+                checksum += a[i].fastNormalised()[0];
+            }
+        }
+        double fast_ns = seconds(start) * 1e9 / (static_cast<double>(count) * repeats);
+
+        for (int i = 0; i < count; i++) {
+            double error = std::fabs(static_cast<double>(a[i].fastNormalised().magnitude()) - 1.0);
+            worst = error > worst ? error : worst;
+        }
+        std::printf("%22s %14.3f %14.3f %14.2e %14g\n", label, exact_ns, fast_ns, worst, static_cast<double>(checksum));
+    }
+
+}
+
+int main(int argc, char** argv) {
+    int count = argc > 1 ? std::atoi(argv[1]) : 4096;
+    int repeats = argc > 2 ? std::atoi(argv[2]) : 2000;
+
+    std::printf("count=%d repeats=%d (ns per vector)\n", count, repeats);
+    std::printf("%22s %14s %14s %12s %14s\n", "type", "a+b*dt-c", "normalise+dot", "copy", "checksum");
+    chain<legacy::Vector<float, 2>, float, 2>("legacy float2", count, repeats);
+    chain<vector::Vector<float, 2>, float, 2>("float2", count, repeats);
+    chain<legacy::Vector<float, 3>, float, 3>("legacy float3", count, repeats);
+    chain<vector::Vector<float, 3>, float, 3>("float3", count, repeats);
+    chain<legacy::Vector<float, 4>, float, 4>("legacy float4", count, repeats);
+    chain<vector::Vector<float, 4>, float, 4>("float4", count, repeats);
+    chain<legacy::Vector<double, 2>, double, 2>("legacy double2", count, repeats);
+    chain<vector::Vector<double, 2>, double, 2>("double2", count, repeats);
+
+    std::printf("\n%22s %14s %14s %14s %14s\n", "type", "normalised", "fastNormalised", "max error", "checksum");
+    normalise<float, 2>("float2", count, repeats);
+    normalise<float, 3>("float3", count, repeats);
+    normalise<float, 4>("float4", count, repeats);
+    normalise<double, 2>("double2", count, repeats);
+    return 0;
+}
@@ -0,0 +1,275 @@
+#ifndef AABB_TREE_H // Inclusion guard
+#define AABB_TREE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <broadphase.h>
+
+namespace broadphase {
+
+    /* Incrementally updated bounding volume hierarchy.
+    Leaves hold a (usually enlarged) box plus a user value; internal nodes
+    hold the union of their children. Leaves are inserted where they grow
+    the tree's total perimeter the least and the tree is rebalanced with
+    rotations on the way back up. Rotations keep the height logarithmic but
+    not the quality: a tree grown one leaf at a time from scattered boxes
+    ends up with overlapping siblings, and queries visit several times the
+    nodes they need. rebuild() builds the hierarchy again top-down with a
+    binned surface area heuristic (perimeter in 2D), which large batches of
+    new leaves get automatically and rebuildIfDegraded() applies once
+    re-insertions have pushed cost() well past what the last rebuild gave.
+    Leaf ids (proxies) stay valid until removed, across rebuilds too.*/
+    class DynamicAabbTree {
+    public:
+        static constexpr int NULL_NODE = -1;
+
+    private:
+        struct Node {
+            Aabb box;
+            int parent;         // also the free list link for unused nodes
+            int child1;
+            int child2;
+            int height;         // 0 for leaves, -1 for free nodes
+            std::uint32_t user_data;
+
+            bool isLeaf() const { return child1 == NULL_NODE; }
+        };
+
+        // A range of leaves waiting to be split, with the node that will hold it
+        struct BuildTask {
+            std::uint32_t begin;
+            std::uint32_t end;
+            int node;
+        };
+
+        std::vector<Node> nodes;
+        int root = NULL_NODE;
+        int free_list = NULL_NODE;
+        std::size_t leaf_count = 0;
+        float built_cost = 0.0f;            // cost() right after the last rebuild
+        std::size_t changes = 0;            // leaves inserted, moved or removed since then
+
+        // Rebuild scratch, kept so a steady scene doesn't allocate
+        std::vector<int> build_leaves;
+        std::vector<int> build_order;       // internal nodes, parents before children
+        std::vector<BuildTask> build_tasks;
+
+        int allocateNode();
+        void freeNode(int node);
+        void insertLeaf(int leaf);
+        void removeLeaf(int leaf);
+        int balance(int node);
+        std::uint32_t split(std::uint32_t begin, std::uint32_t end);  // Partition build_leaves[begin, end), returns the middle
+
+        /* Traversal stack with inline storage, so queries only touch the heap for
+        trees far deeper than balancing allows. Each query owns its own stack,
+        which keeps concurrent read-only queries safe.*/
+        class Stack {
+        private:
+            int inline_items[128];
+            std::vector<int> overflow;
+            std::size_t count = 0;
+
+        public:
+            void push(int value) {
+                if (count < 128) {
+                    inline_items[count] = value;
+                } else {
+                    overflow.push_back(value);
+                }
+                count++;
+            }
+            int pop() {
+                count--;
+                if (count < 128) {
+                    return inline_items[count];
+                }
+                int value = overflow.back();
+                overflow.pop_back();
+                return value;
+            }
+            bool empty() const { return count == 0; }
+        };
+
+    public:
+        // ======================================================================== //
+        // ============================= Proxy Management ========================= //
+        // ======================================================================== //
+        int insert(const Aabb& box, std::uint32_t user_data);  // Returns the proxy id
+        void remove(int proxy);
+        void update(int proxy, const Aabb& box);  // Re-insert with a new box
+        void clear();
+
+        /* Inserts count leaves, writing their proxy ids to proxies. A batch of at
+        least a quarter of the tree (the first one, for a start) is placed by
+        rebuilding the whole tree instead of one leaf at a time.*/
+        void insert(const Aabb* boxes, const std::uint32_t* user_data, std::size_t count, int* proxies);
+
+        // ======================================================================== //
+        // ================================= Rebuilds ============================= //
+        // ======================================================================== //
+        static constexpr int BUILD_BINS = 16;               // candidate split planes per axis
+        static constexpr float REBUILD_COST_RATIO = 1.25f;  // cost growth that triggers rebuildIfDegraded()
+
+        void rebuild();  // Build the hierarchy over every leaf again, top-down, O(n log n)
+        /* Rebuilds if leaves amounting to half the tree have changed since the last
+        rebuild and cost() has grown past REBUILD_COST_RATIO times its value then.
+        Checking the cost is O(n), but only happens once per half a tree of changes.*/
+        bool rebuildIfDegraded();
+        /* Surface area heuristic cost: the internal node perimeters summed and divided
+        by the root's, which tracks how many nodes a random query descends into.*/
+        float cost() const;
+
+        const Aabb& box(int proxy) const { return nodes[proxy].box; }
+        std::uint32_t userData(int proxy) const { return nodes[proxy].user_data; }
+        std::size_t size() const { return leaf_count; }
+        int height() const { return root == NULL_NODE ? 0 : nodes[root].height; }
+
+        // ======================================================================== //
+        // ================================= Queries ============================== //
+        // ======================================================================== //
+
+        /* Calls callback(proxy) for every leaf whose box overlaps region.
+        Returning false from the callback stops the query.*/
+        template<typename Callback>
+        void query(const Aabb& region, Callback&& callback) const {
+            if (root == NULL_NODE) {
+                return;
+            }
+            Stack stack;
+            stack.push(root);
+            while (!stack.empty()) {
+                const Node& node = nodes[stack.pop()];
+                if (!node.box.overlaps(region)) {
+                    continue;
+                }
+                if (node.isLeaf()) {
+                    if (!callback(static_cast<int>(&node - nodes.data()))) {
+                        return;
+                    }
+                } else {
+                    stack.push(node.child1);
+                    stack.push(node.child2);
+                }
+            }
+        }
+
+        /* Walks leaves whose box the ray origin + t * dir crosses for t in [0, max_t].
+        callback(proxy, max_t) returns the new max_t: return max_t to keep going,
+        a smaller value to clip the ray (e.g. at a hit) or 0 to stop.*/
+        template<typename Callback>
+        void rayCast(float origin_x, float origin_y, float dir_x, float dir_y, float max_t, Callback&& callback) const {
+            if (root == NULL_NODE) {
+                return;
+            }
+            Stack stack;
+            stack.push(root);
+            while (!stack.empty()) {
+                const Node& node = nodes[stack.pop()];
+                if (!rayHitsBox(node.box, origin_x, origin_y, dir_x, dir_y, max_t)) {
+                    continue;
+                }
+                if (node.isLeaf()) {
+                    max_t = callback(static_cast<int>(&node - nodes.data()), max_t);
+                    if (max_t <= 0.0f) {
+                        return;
+                    }
+                } else {
+                    stack.push(node.child1);
+                    stack.push(node.child2);
+                }
+            }
+        }
+
+        // Calls callback(proxy) for every leaf, depth first, so neighbouring leaves come one after another
+        template<typename Callback>
+        void forEachLeaf(Callback&& callback) const {
+            if (root == NULL_NODE) {
+                return;
+            }
+            Stack stack;
+            stack.push(root);
+            while (!stack.empty()) {
+                int index = stack.pop();
+                const Node& node = nodes[index];
+                if (node.isLeaf()) {
+                    callback(index);
+                } else {
+                    stack.push(node.child2);
+                    stack.push(node.child1);
+                }
+            }
+        }
+
+        // Slab test of the segment t in [0, max_t] against box
+        static bool rayHitsBox(const Aabb& box, float origin_x, float origin_y, float dir_x, float dir_y, float max_t);
+    };
+
+    // ======================================================================== //
+    // ============================ Tree Broad-phase ========================== //
+    // ======================================================================== //
+
+    /* Broad-phase built on two DynamicAabbTrees.
+    Every body is inserted once with a "fat" box, its bounding box grown by
+    margin * radius. Dynamic bodies are only re-inserted when their tight box
+    leaves the fat one, and static bodies live in a separate tree. A sync
+    only looks at the awake leaves of the dynamic tree and at the bodies in
+    the store's change log (created, destroyed or moved by setPosition), so
+    static and sleeping bodies cost nothing per step until a setter touches
+    them. The trees persist between steps, so region and
+    ray queries don't need a full scan. New bodies are inserted as one batch
+    per tree, so the first sync (and any large batch after it) builds a SAH
+    tree outright, and a tree that re-insertions have degraded is rebuilt.*/
+    class TreeBroadPhase : public BroadPhase {
+    private:
+        struct Proxy {
+            int node = DynamicAabbTree::NULL_NODE;
+            std::uint32_t generation = 0;
+            bool is_static = false;
+            std::uint64_t visited = 0;  // last sync that brought the proxy up to date
+        };
+
+        // Boxes and slots of the bodies a sync adds to a tree, inserted together
+        struct Batch {
+            std::vector<Aabb> boxes;
+            std::vector<std::uint32_t> slots;
+            std::vector<int> nodes;
+
+            void insertInto(DynamicAabbTree& tree, std::vector<Proxy>& proxies);
+        };
+
+        float margin;
+        DynamicAabbTree static_tree;
+        DynamicAabbTree dynamic_tree;
+        std::vector<Proxy> proxies;  // indexed by BodyHandle::index, tree user data is the same index
+        Batch static_batch;
+        Batch dynamic_batch;
+        std::vector<std::uint32_t> query_order;  // awake dynamic bodies in dynamic tree order
+        std::vector<std::uint32_t> moving;       // slots of awake dynamic bodies, checked by each sync
+        std::uint64_t syncs = 0;
+        std::uint64_t synced_to = 0;             // end of the store's change log at the last sync
+        std::uint64_t refits = 0;
+        std::uint64_t rebuilds = 0;
+
+        void sync(const world::BodyStore& bodies);  // Bring both trees up to date with the store
+        void syncBody(const world::BodyStore& bodies, world::BodyHandle handle);  // Bring one body's proxy up to date
+
+    public:
+        explicit TreeBroadPhase(float margin = 0.25f);
+
+        void findPairs(const world::BodyStore& bodies, std::vector<BodyPair>& pairs) override;
+        const char* name() const override { return "dynamic-aabb-tree"; }
+
+        void queryRegion(const world::BodyStore& bodies, const Aabb& region, std::vector<std::uint32_t>& found) override;
+        bool rayCast(const world::BodyStore& bodies, float origin_x, float origin_y, float dir_x, float dir_y, float max_t, RayHit& hit) override;
+
+        const DynamicAabbTree& staticTree() const { return static_tree; }
+        const DynamicAabbTree& dynamicTree() const { return dynamic_tree; }
+        std::uint64_t refitCount() const { return refits; }  // Proxies re-inserted since construction
+        std::uint64_t rebuildCount() const { return rebuilds; }  // Trees rebuilt because they had degraded
+    };
+
+} // namespace broadphase
+
+#endif
@@ -0,0 +1,141 @@
+#ifndef ALLOCATION_H // Inclusion guard
+#define ALLOCATION_H
+
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+#include <vector>
+
+namespace memory {
+
+    // ======================================================================== //
+    // ============================ Allocation Counter ======================== //
+    // ======================================================================== //
+
+    /* Number of global operator new calls made by the process so far.
+    The library leaves the allocation functions alone; a program opts in by
+    linking bench/support/count_allocations.cpp, whose replacements call
+    countHeapAllocation() before forwarding to malloc. Without it the count
+    stays 0. Taking the difference around a block of code tells whether it
+    touched the heap at all, e.g. that stepping a warmed-up World allocates
+    nothing.*/
+    std::uint64_t heapAllocations();
+    void countHeapAllocation();  // Called by counting allocation functions, once per allocation
+
+    // ======================================================================== //
+    // =============================== Frame Arena ============================ //
+    // ======================================================================== //
+
+    /* Linear allocator for data that only lives for one step.
+    allocate() bumps an offset into a block and reset() rewinds it, so the
+    transient arrays of a step cost a few adds instead of heap calls. When a
+    step needs more than the block holds, extra blocks are chained on and the
+    next reset() replaces them all with one block big enough for the peak,
+    after which a steady workload never allocates again.
+    Memory is uninitialised and nothing is destroyed, so only trivially
+    copyable types belong here. Not thread safe: allocate on the thread that
+    owns the arena, then hand the pointers to workers.*/
+    class FrameArena {
+    private:
+        struct Block {
+            unsigned char* data;
+            std::size_t size;
+        };
+
+        std::vector<Block> blocks;  // first block, then overflow blocks for this frame
+        std::size_t offset = 0;     // used bytes in blocks.back()
+        std::size_t used = 0;       // bytes handed out since the last reset, padding included
+        std::size_t peak = 0;       // most bytes any frame has used
+
+        void* allocateBytes(std::size_t bytes);
+        void release();
+
+    public:
+        static constexpr std::size_t ALIGNMENT = 64;  // every allocation starts on a cache line
+
+        explicit FrameArena(std::size_t initial_bytes = 0);
+        ~FrameArena();
+        FrameArena(const FrameArena&) = delete;
+        FrameArena& operator=(const FrameArena&) = delete;
+
+        template<typename T>
+        T* allocate(std::size_t count) {
+            static_assert(std::is_trivially_copyable<T>::value, "FrameArena never runs destructors");
+            return static_cast<T*>(allocateBytes(count * sizeof(T)));
+        }
+
+        void reset();  // Free everything allocated since the last reset
+
+        std::size_t bytesUsed() const { return used; }
+        std::size_t peakBytes() const { return peak; }
+        std::size_t capacity() const;  // Bytes available without growing
+    };
+
+    // ======================================================================== //
+    // =============================== Block Pool ============================= //
+    // ======================================================================== //
+
+    /* Fixed-size object pool addressed by 32-bit ids.
+    Objects live in blocks of BLOCK_SIZE that are never moved or freed until
+    clear(), so references stay valid while the pool grows, and released ids
+    are recycled before the pool grows again. A recycled object keeps whatever
+    it held when it was released (new blocks start value-initialised), which
+    lets callers keep data such as handle generations across reuse.*/
+    template<typename T, std::size_t BLOCK_SIZE = 256>
+    class BlockPool {
+        static_assert(std::is_trivially_copyable<T>::value, "BlockPool never runs constructors or destructors on reuse");
+
+    private:
+        std::vector<T*> blocks;
+        std::vector<std::uint32_t> free_ids;
+        std::uint32_t next_id = 0;  // ids below this have been handed out at least once
+
+        void addBlock() { blocks.push_back(new T[BLOCK_SIZE]()); }
+
+    public:
+        BlockPool() = default;
+        ~BlockPool() { clear(); }
+        BlockPool(const BlockPool&) = delete;
+        BlockPool& operator=(const BlockPool&) = delete;
+
+        std::uint32_t allocate() {
+            if (!free_ids.empty()) {
+                std::uint32_t id = free_ids.back();
+                free_ids.pop_back();
+                return id;
+            }
+            if (next_id == blocks.size() * BLOCK_SIZE) {
+                addBlock();
+            }
+            return next_id++;
+        }
+
+        // The object keeps its contents; free_ids only grows past its high water mark
+        void release(std::uint32_t id) { free_ids.push_back(id); }
+
+        void reserve(std::size_t count) {
+            while (blocks.size() * BLOCK_SIZE < count) {
+                addBlock();
+            }
+            free_ids.reserve(count);
+        }
+
+        void clear() {
+            for (T* block : blocks) {
+                delete[] block;
+            }
+            blocks.clear();
+            free_ids.clear();
+            next_id = 0;
+        }
+
+        T& operator[](std::uint32_t id) { return blocks[id / BLOCK_SIZE][id % BLOCK_SIZE]; }
+        const T& operator[](std::uint32_t id) const { return blocks[id / BLOCK_SIZE][id % BLOCK_SIZE]; }
+
+        std::uint32_t extent() const { return next_id; }  // Ids in [0, extent()) have been allocated at some point
+        std::size_t size() const { return next_id - free_ids.size(); }  // Ids currently allocated
+    };
+
+} // namespace memory
+
+#endif
@@ -0,0 +1,187 @@
+#ifndef BODY_STORE_H // Inclusion guard
+#define BODY_STORE_H
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <allocation.h>
+
+namespace world {
+
+    /* Stable reference to a body held in a BodyStore.
+    The store keeps its arrays densely packed, so a body's array index changes
+    whenever another body is destroyed. The handle instead names a slot in an
+    indirection table; the generation is bumped every time that slot is reused
+    so that stale handles can be detected rather than silently aliasing a new body.*/
+    struct BodyHandle {
+        std::uint32_t index = 0xFFFFFFFFu;  // slot in the handle table
+        std::uint32_t generation = 0;       // slot generation at creation time
+
+        bool operator==(const BodyHandle& other) const { return index == other.index && generation == other.generation; }
+        bool operator!=(const BodyHandle& other) const { return !(*this == other); }
+    };
+
+    // Per-body flag bits stored in BodyStore::flags()
+    enum BodyFlags : std::uint32_t {
+        BODY_STATIC = 1u << 0,      // immovable, never integrated
+        BODY_SLEEPING = 1u << 1,    // at rest, skipped until woken
+        BODY_INACTIVE = BODY_STATIC | BODY_SLEEPING,  // either of the above: not integrated
+    };
+
+    // Source arrays for BodyStore::assign, each holding one value per body
+    struct BodyArrays {
+        const float* x;
+        const float* y;
+        const float* vx;
+        const float* vy;
+        const float* fx;
+        const float* fy;
+        const float* inv_mass;
+        const float* mass;
+        const float* radius;
+        const float* restitution;
+        const std::uint32_t* flags;
+        const std::uint32_t* rest_steps;
+        const std::uint32_t* island_ids;
+    };
+
+    /* Structure-of-arrays storage for circle bodies.
+    Each property lives in its own contiguous array so that a pass over one
+    property (e.g. integrating positions) streams through memory instead of
+    hopping between scattered objects. Index i of every array refers to the
+    same body; indices are only valid until the next create/destroy call,
+    use a BodyHandle to refer to a body across those calls.*/
+    class BodyStore {
+    private:
+        std::vector<float> pos_x, pos_y;        // position
+        std::vector<float> vel_x, vel_y;        // velocity
+        std::vector<float> force_x, force_y;    // accumulated forces
+        std::vector<float> inv_masses;          // 1 / mass, 0 for static bodies
+        std::vector<float> masses;              // mass as given at creation
+        std::vector<float> radii;               // radius
+        std::vector<float> restitutions;        // elasticity
+        std::vector<std::uint32_t> body_flags;  // BodyFlags bits
+        std::vector<std::uint32_t> rest_steps;  // consecutive steps spent below the sleep velocity
+        std::vector<std::uint32_t> island_ids;  // island a sleeping body went to sleep with
+        std::vector<std::uint32_t> pending_wakes; // islands to wake at the start of the next step
+        std::vector<BodyHandle> changed;        // bodies created, destroyed or moved by a setter, see changes()
+        std::uint64_t changed_from = 0;         // number of changed[0] among every change made to the store
+        std::vector<std::uint64_t> serials;     // creation order, increasing with every create
+        std::uint64_t next_serial = 0;
+
+        struct Slot {
+            std::uint32_t dense;        // index into the arrays above
+            std::uint32_t generation;   // incremented on every destroy
+        };
+        std::uint64_t layout_version = 0;           // bumped whenever dense indices may have changed
+        memory::BlockPool<Slot> slots;              // handle index -> dense index; released slots keep their generation
+        std::vector<std::uint32_t> dense_to_slot;   // dense index -> handle index
+
+        // Scratch for restoreCreationOrder, kept to reuse capacity
+        std::vector<std::uint32_t> order_scratch;
+        std::vector<float> float_scratch;
+        std::vector<std::uint32_t> uint_scratch;
+        std::vector<std::uint64_t> serial_scratch;
+
+    public:
+        // ======================================================================== //
+        // ============================ Body Management =========================== //
+        // ======================================================================== //
+        BodyHandle create(float x, float y, float radius, float mass, bool is_static = false, float restitution = 1.0f);
+        void destroy(BodyHandle handle);  // Swap-removes the body, invalidating dense indices
+        bool isValid(BodyHandle handle) const;
+        void reserve(std::size_t count);
+        void clear();
+
+        /* Replaces every body with count bodies copied from arrays, body i taking
+        dense index i. One bulk copy per array, used to load snapshots. Existing
+        handles are invalidated as by clear(); use handleOf() for the new ones.*/
+        void assign(std::size_t count, const BodyArrays& arrays);
+
+        /* Sorts the bodies back into the order they were created in, undoing the
+        moves made by destroy(), so the layout depends only on which bodies
+        exist and not on the order they were destroyed in. Handles stay valid.
+        Returns false (and costs one pass) if the order was already right.*/
+        bool restoreCreationOrder();
+
+        std::size_t size() const { return pos_x.size(); }
+        std::uint64_t layoutVersion() const { return layout_version; }  // Changes on every create/destroy
+        // Dense index of a live body; a stale handle (its body destroyed) fails the assert
+        std::uint32_t indexOf(BodyHandle handle) const {
+            assert(isValid(handle) && "BodyHandle refers to a destroyed body");
+            return slots[handle.index].dense;
+        }
+        BodyHandle handleOf(std::uint32_t i) const { return BodyHandle{dense_to_slot[i], slots[dense_to_slot[i]].generation}; }
+
+        // ======================================================================== //
+        // ============================== Array Access ============================ //
+        // ======================================================================== //
+        float* x() { return pos_x.data(); }
+        float* y() { return pos_y.data(); }
+        float* vx() { return vel_x.data(); }
+        float* vy() { return vel_y.data(); }
+        float* fx() { return force_x.data(); }
+        float* fy() { return force_y.data(); }
+        float* invMass() { return inv_masses.data(); }
+        float* radius() { return radii.data(); }
+        float* restitution() { return restitutions.data(); }
+        std::uint32_t* flags() { return body_flags.data(); }
+
+        const float* x() const { return pos_x.data(); }
+        const float* y() const { return pos_y.data(); }
+        const float* vx() const { return vel_x.data(); }
+        const float* vy() const { return vel_y.data(); }
+        const float* fx() const { return force_x.data(); }
+        const float* fy() const { return force_y.data(); }
+        const float* invMass() const { return inv_masses.data(); }
+        const float* mass() const { return masses.data(); }
+        const float* radius() const { return radii.data(); }
+        const float* restitution() const { return restitutions.data(); }
+        const std::uint32_t* flags() const { return body_flags.data(); }
+        std::uint32_t* restSteps() { return rest_steps.data(); }
+        const std::uint32_t* restSteps() const { return rest_steps.data(); }
+        std::uint32_t* islandIds() { return island_ids.data(); }
+        const std::uint32_t* islandIds() const { return island_ids.data(); }
+
+        // ======================================================================== //
+        // ============================ Per-body Updates ========================== //
+        // ======================================================================== //
+        // Setters wake a sleeping body, and its island with it; setPosition is also logged in changes()
+        void setPosition(std::uint32_t i, float newX, float newY);
+        void setVelocity(std::uint32_t i, float newVx, float newVy);
+        void setForce(std::uint32_t i, float newFx, float newFy);      // No-op for static bodies
+        void applyForce(std::uint32_t i, float forceX, float forceY);  // No-op for static bodies
+
+        /* Zeroes the forces of bodies [begin, end). Forces only act on the step
+        after they were applied: World::step clears them once integrated.*/
+        void clearForces(std::size_t begin, std::size_t end);
+
+        // ======================================================================== //
+        // ================================ Change Log ============================ //
+        // ======================================================================== //
+        /* Bodies created, destroyed or moved by setPosition, in order, so a
+        broad-phase that keeps its own structure can update just those instead
+        of checking every body each step. Motion from integration isn't logged,
+        that only moves awake dynamic bodies. Entries are numbered over the
+        store's lifetime, changes() holding [changesFrom(), changesEnd());
+        a reader that last saw an entry before changesFrom() has missed some
+        and must check every body.*/
+        const std::vector<BodyHandle>& changes() const { return changed; }
+        std::uint64_t changesFrom() const { return changed_from; }
+        std::uint64_t changesEnd() const { return changed_from + changed.size(); }
+        void forgetChanges();       // Drop the entries read so far, World::step does so after the broad-phase
+        void invalidateChanges();   // Bodies were changed through the arrays, so every reader has to start over
+
+        // ======================================================================== //
+        // ================================= Sleeping ============================= //
+        // ======================================================================== //
+        bool isSleeping(std::uint32_t i) const { return (body_flags[i] & BODY_SLEEPING) != 0; }
+        void sleep(std::uint32_t i, std::uint32_t island);  // Freeze body i as part of island
+        void wake(std::uint32_t i);  // Wake body i now and queue the rest of its island
+        std::vector<std::uint32_t>& pendingWakes() { return pending_wakes; }
+    };
+
+} // namespace world
+
+#endif
@@ -0,0 +1,184 @@
+#ifndef BROADPHASE_H // Inclusion guard
+#define BROADPHASE_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <body_store.h>
+#include <thread_pool.h>
+
+namespace broadphase {
+
+    // Candidate collision pair, as dense BodyStore indices with a < b
+    struct BodyPair {
+        std::uint32_t a;
+        std::uint32_t b;
+    };
+
+    // Axis-aligned bounding box
+    struct Aabb {
+        float min_x, min_y, max_x, max_y;
+
+        bool overlaps(const Aabb& other) const {
+            return min_x <= other.max_x && other.min_x <= max_x && min_y <= other.max_y && other.min_y <= max_y;
+        }
+        bool contains(const Aabb& other) const {
+            return min_x <= other.min_x && min_y <= other.min_y && other.max_x <= max_x && other.max_y <= max_y;
+        }
+        float perimeter() const { return 2.0f * ((max_x - min_x) + (max_y - min_y)); }
+        static Aabb merge(const Aabb& a, const Aabb& b) {
+            return Aabb{a.min_x < b.min_x ? a.min_x : b.min_x, a.min_y < b.min_y ? a.min_y : b.min_y,
+                        a.max_x > b.max_x ? a.max_x : b.max_x, a.max_y > b.max_y ? a.max_y : b.max_y};
+        }
+    };
+
+    // Closest circle hit by a ray origin + t * direction
+    struct RayHit {
+        std::uint32_t body;         // dense BodyStore index
+        float t;                    // ray parameter of the hit point
+        float normal_x, normal_y;   // surface normal at the hit point
+    };
+
+    // Geometry helpers shared by the backends
+    bool circleOverlapsAabb(float cx, float cy, float radius, const Aabb& box);
+    bool rayCastCircle(float cx, float cy, float radius, float origin_x, float origin_y, float dir_x, float dir_y, float max_t, float& t);
+    void fillRayNormal(const world::BodyStore& bodies, float origin_x, float origin_y, float dir_x, float dir_y, RayHit& hit);
+
+    /* Sorts pairs by a then b with a radix sort (linear in the pair count),
+    so the order no longer depends on which backend found them or on what
+    it remembered from earlier queries. scratch is swapped with pairs.*/
+    void sortPairs(std::vector<BodyPair>& pairs, std::vector<BodyPair>& scratch);
+
+    /* Counters accumulated across findPairs calls.
+    The ratio of overlapping to tested pairs shows how well a backend culls
+    a given scene, which is what decides the right backend for it.*/
+    struct Stats {
+        std::uint64_t queries = 0;            // findPairs calls
+        std::uint64_t pairs_tested = 0;       // AABB overlap tests performed
+        std::uint64_t pairs_overlapping = 0;  // pairs emitted
+    };
+
+    /* Interface for broad-phase backends.
+    findPairs replaces the contents of pairs with every pair of bodies whose
+    bounding boxes overlap. Pairs where neither body is awake and dynamic
+    (static or sleeping) are never reported.
+    When a thread pool is set the pair search runs on it; the pairs come out
+    in the same order whatever the thread count.
+    queryRegion and rayCast scan every body by default; backends with a
+    spatial structure that persists between steps override them.*/
+    class BroadPhase {
+    protected:
+        Stats counters;
+        threading::ThreadPool* pool = nullptr;
+        std::vector<std::vector<BodyPair>> chunk_pairs;  // per-chunk output, kept to reuse capacity
+        std::size_t chunk_capacity = 0;                  // largest capacity any chunk has needed
+        std::vector<std::uint64_t> chunk_tested;
+
+        /* Runs emit(begin, end, out, tested) over [0, count) in chunks of grain items,
+        on the pool if there is one, then appends each chunk's pairs to pairs in chunk
+        order and adds up the tested counts. Every chunk is given the capacity the
+        busiest chunk has needed, so pairs drifting from chunk to chunk as bodies
+        move don't reallocate; only a new peak (doubling the capacity) does.*/
+        template<typename Emit>
+        void emitChunked(std::size_t count, std::size_t grain, std::vector<BodyPair>& pairs, Emit&& emit) {
+            const std::size_t chunk_count = (count + grain - 1) / grain;
+            if (chunk_pairs.size() < chunk_count) {
+                chunk_pairs.resize(chunk_count);
+            }
+            chunk_tested.assign(chunk_count, 0);
+            threading::parallelFor(pool, 0, count, grain, [&](std::size_t begin, std::size_t end, unsigned) {
+                std::size_t chunk = begin / grain;
+                chunk_pairs[chunk].clear();
+                chunk_pairs[chunk].reserve(chunk_capacity);
+                emit(begin, end, chunk_pairs[chunk], chunk_tested[chunk]);
+            });
+            for (std::size_t chunk = 0; chunk < chunk_count; chunk++) {
+                pairs.insert(pairs.end(), chunk_pairs[chunk].begin(), chunk_pairs[chunk].end());
+                counters.pairs_tested += chunk_tested[chunk];
+                chunk_capacity = std::max(chunk_capacity, chunk_pairs[chunk].capacity());
+            }
+        }
+
+    public:
+        virtual ~BroadPhase() = default;
+
+        virtual void findPairs(const world::BodyStore& bodies, std::vector<BodyPair>& pairs) = 0;
+        virtual const char* name() const = 0;
+
+        // Replace found with the bodies whose circle overlaps region
+        virtual void queryRegion(const world::BodyStore& bodies, const Aabb& region, std::vector<std::uint32_t>& found);
+        // Closest circle hit within t in [0, max_t]; a ray starting inside a circle hits it at t = 0
+        virtual bool rayCast(const world::BodyStore& bodies, float origin_x, float origin_y, float dir_x, float dir_y, float max_t, RayHit& hit);
+
+        const Stats& stats() const { return counters; }
+        void resetStats() { counters = Stats(); }
+        void setThreadPool(threading::ThreadPool* thread_pool) { pool = thread_pool; }  // null runs serially
+    };
+
+    // ======================================================================== //
+    // ================================ Brute Force =========================== //
+    // ======================================================================== //
+
+    // Tests every pair, O(n^2). Reference for validating the other backends.
+    class BruteForce : public BroadPhase {
+    public:
+        void findPairs(const world::BodyStore& bodies, std::vector<BodyPair>& pairs) override;
+        const char* name() const override { return "brute-force"; }
+    };
+
+    // ======================================================================== //
+    // ============================ Spatial Hash Grid ========================= //
+    // ======================================================================== //
+
+    /* Uniform grid hashed into a flat table, so the world needs no fixed bounds.
+    Each body is inserted into every cell its bounding box touches and only
+    bodies sharing a cell are tested. A pair sharing several cells is reported
+    once, from the cell holding the min corner of the two boxes' intersection.
+    With cell_size <= 0 the size is derived each query from the radius
+    distribution (twice the mean plus one standard deviation), so typical
+    bodies touch at most four cells.*/
+    class SpatialHashGrid : public BroadPhase {
+    private:
+        struct Entry {
+            std::uint32_t bucket;
+            std::int32_t cx, cy;
+            std::uint32_t body;
+        };
+
+        float fixed_cell_size;
+        float last_cell_size = 0.0f;
+        std::vector<Entry> entries;             // one per (body, cell) pair
+        std::vector<Entry> sorted;              // entries grouped by bucket
+        std::vector<std::uint32_t> bucket_start;
+
+    public:
+        explicit SpatialHashGrid(float cell_size = 0.0f);
+
+        void findPairs(const world::BodyStore& bodies, std::vector<BodyPair>& pairs) override;
+        const char* name() const override { return "spatial-hash-grid"; }
+
+        float cellSize() const { return last_cell_size; }  // Size used by the last query
+    };
+
+    // ======================================================================== //
+    // ============================== Sweep And Prune ========================= //
+    // ======================================================================== //
+
+    /* Sorts bodies by the left edge of their bounding box and sweeps along x,
+    only testing bodies whose x intervals overlap. The sorted order is kept
+    between queries and repaired with insertion sort, which is close to linear
+    when bodies move a little each step.*/
+    class SweepAndPrune : public BroadPhase {
+    private:
+        std::vector<std::uint32_t> order;  // body indices sorted by min x
+        std::vector<float> min_x;          // min x per body, refreshed each query
+
+    public:
+        void findPairs(const world::BodyStore& bodies, std::vector<BodyPair>& pairs) override;
+        const char* name() const override { return "sweep-and-prune"; }
+    };
+
+} // namespace broadphase
+
+#endif
@@ -0,0 +1,125 @@
+#ifndef FORCES_H // Inclusion guard
+#define FORCES_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <body_store.h>
+#include <thread_pool.h>
+
+namespace forces {
+
+    /* Interface for force generators.
+    apply adds each body's force for the coming step to BodyStore::fx()/fy(),
+    on top of whatever was already applied. Only dynamic, awake bodies
+    receive forces: static and sleeping ones are skipped, as they are by the
+    integrator, so their force stays zero. When pool is set the work runs on
+    it; results are the same whatever the thread count.*/
+    class ForceGenerator {
+    public:
+        virtual ~ForceGenerator() = default;
+
+        virtual void apply(world::BodyStore& bodies, threading::ThreadPool* pool) = 0;
+        virtual const char* name() const = 0;
+    };
+
+    // ======================================================================== //
+    // ================================== Gravity ============================= //
+    // ======================================================================== //
+
+    // Constant acceleration for every body, f = m * g. One SIMD pass over the mass array
+    class UniformGravity : public ForceGenerator {
+    private:
+        float gx, gy;
+
+    public:
+        explicit UniformGravity(float gx = 0.0f, float gy = -9.81f) : gx(gx), gy(gy) {}
+
+        void apply(world::BodyStore& bodies, threading::ThreadPool* pool) override;
+        const char* name() const override { return "uniform-gravity"; }
+
+        void setAcceleration(float newGx, float newGy) { gx = newGx; gy = newGy; }
+    };
+
+    // ======================================================================== //
+    // =================================== Drag =============================== //
+    // ======================================================================== //
+
+    /* Air resistance opposing each body's velocity, f = -(linear + quadratic * |v|) v:
+    the linear term dominates at low speeds (viscous drag), the quadratic one
+    at high speeds. One SIMD pass over the velocity arrays.*/
+    class Drag : public ForceGenerator {
+    private:
+        float linear, quadratic;
+
+    public:
+        explicit Drag(float linear = 0.1f, float quadratic = 0.0f) : linear(linear), quadratic(quadratic) {}
+
+        void apply(world::BodyStore& bodies, threading::ThreadPool* pool) override;
+        const char* name() const override { return "drag"; }
+
+        void setCoefficients(float newLinear, float newQuadratic) { linear = newLinear; quadratic = newQuadratic; }
+    };
+
+    // ======================================================================== //
+    // ============================== Mutual Gravity ========================== //
+    // ======================================================================== //
+
+    /* Newtonian attraction between every pair of bodies,
+        f_i = sum over j of G m_i m_j d / (|d|^2 + softening^2)^(3/2),  d = x_j - x_i
+    where the softening length keeps close encounters finite. Every body
+    with a positive mass attracts (static and sleeping ones included); only
+    dynamic, awake bodies are pulled.
+    BarnesHut builds a quadtree over the bodies each step, storing the mass
+    and centre of mass of every cell, and treats a cell as a single mass
+    when size / distance < opening_angle and the body is outside it:
+    O(n log n), with an error that shrinks as the angle does (0 gives the
+    exact sum, slowly). Bodies are sorted along a Morton curve first and
+    both inserted and pulled in that order, so neighbouring bodies walk
+    the same cells while they are still in cache. Exact sums
+    every pair in double precision, O(n^2), as the reference for measuring
+    that error.*/
+    class MutualGravity : public ForceGenerator {
+    public:
+        enum class Method { BarnesHut, Exact };
+
+        static constexpr int MAX_DEPTH = 32;  // deeper cells hold every body that reached them, e.g. coincident ones
+
+    private:
+        static constexpr std::int32_t EMPTY = -1;      // Node::body of an empty leaf
+        static constexpr std::int32_t SEVERAL = -2;    // Node::body of a leaf at MAX_DEPTH holding more than one body
+
+        struct Node {
+            float min_x, min_y, size;   // square cell
+            float mass;                 // total mass in the cell
+            float com_x, com_y;         // centre of mass (mass-weighted sums while building)
+            std::int32_t first_child;   // four consecutive children, -1 for a leaf
+            std::int32_t body;          // leaf body, EMPTY or SEVERAL
+        };
+
+        float constant, opening_angle, softening;
+        Method method;
+        std::vector<Node> nodes;        // root first, children always after their parent
+        std::vector<std::uint32_t> order;       // bodies by Morton code of their position
+        std::vector<std::uint32_t> keys;        // Morton code per entry of order
+        std::vector<std::uint32_t> order_scratch, key_scratch;
+        std::vector<std::size_t> digit_counts;  // radix sort buckets, kept to avoid reallocating each step
+
+        void build(const world::BodyStore& bodies);
+        void applyBarnesHut(world::BodyStore& bodies, threading::ThreadPool* pool) const;
+        void applyExact(world::BodyStore& bodies, threading::ThreadPool* pool) const;
+
+    public:
+        explicit MutualGravity(float constant = 1.0f, float opening_angle = 0.5f, float softening = 0.01f, Method method = Method::BarnesHut);
+
+        void apply(world::BodyStore& bodies, threading::ThreadPool* pool) override;
+        const char* name() const override { return "mutual-gravity"; }
+
+        void setMethod(Method newMethod) { method = newMethod; }
+        void setOpeningAngle(float angle) { opening_angle = angle; }
+        std::size_t nodeCount() const { return nodes.size(); }  // Quadtree cells built by the last Barnes-Hut apply
+    };
+
+} // namespace forces
+
+#endif
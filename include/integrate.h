@@ -0,0 +1,217 @@
+#ifndef INTEGRATE_H // Inclusion guard
+#define INTEGRATE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <body_store.h>
+
+namespace world {
+
+    /* Semi-implicit Euler step for bodies [begin, end) of the store:
+        v += f * inv_mass * dt
+        x += v * dt
+    Static and sleeping bodies are masked out and keep their state. The work is dispatched
+    to the widest ISA selected by simd::active(); every path performs the same
+    IEEE operations in the same order, so results are bit-identical to the
+    scalar reference (simd::setLevel(simd::Level::Scalar)).*/
+    void integrateRange(BodyStore& store, std::size_t begin, std::size_t end, float deltaTime);
+
+    // ======================================================================== //
+    // ============================ Integrator Policies ======================= //
+    // ======================================================================== //
+    /* Each policy advances one body's state by dt given an acceleration functor
+        accel(i, x, y, vx, vy, ax, ay)
+    that writes the acceleration of body i at the given state. The policy is a
+    template argument of integrateRange, so the whole step inlines into the
+    loop with no per-body virtual call or switch. Higher order policies
+    evaluate accel several times per step at intermediate states, which
+    only pays off when the acceleration depends on the state (e.g. gravity
+    towards a point). With a constant acceleration Verlet and RK4 both give
+    the exact parabola, x += v dt + a dt^2 / 2, while semi-implicit Euler
+    moves x by a dt^2, so its path differs by a dt^2 / 2 per step.
+    Every policy makes its first evaluation at the start of the step state.*/
+
+    // v += a(x) dt, x += v dt. One evaluation, first order, symplectic
+    struct SemiImplicitEuler {
+        static constexpr int evaluations = 1;
+
+        template<typename Acceleration>
+        static void advance(std::size_t i, float& x, float& y, float& vx, float& vy, float dt, const Acceleration& accel) {
+            float ax, ay;
+            accel(i, x, y, vx, vy, ax, ay);
+            vx = vx + ax * dt;
+            vy = vy + ay * dt;
+            x = x + vx * dt;
+            y = y + vy * dt;
+        }
+    };
+
+    /* x += v dt + a(x) dt^2 / 2, v += (a(x) + a(x')) dt / 2. Two evaluations, second
+    order, symplectic. The second evaluation sees the start-of-step velocity, so
+    velocity dependent forces (drag) are only first order.*/
+    struct VelocityVerlet {
+        static constexpr int evaluations = 2;
+
+        template<typename Acceleration>
+        static void advance(std::size_t i, float& x, float& y, float& vx, float& vy, float dt, const Acceleration& accel) {
+            float ax0, ay0, ax1, ay1;
+            accel(i, x, y, vx, vy, ax0, ay0);
+            x = x + vx * dt + 0.5f * ax0 * dt * dt;
+            y = y + vy * dt + 0.5f * ay0 * dt * dt;
+            accel(i, x, y, vx, vy, ax1, ay1);
+            vx = vx + 0.5f * (ax0 + ax1) * dt;
+            vy = vy + 0.5f * (ay0 + ay1) * dt;
+        }
+    };
+
+    const int MAX_EVALUATIONS = 4;  // most accel calls any policy makes per step
+
+    // Classic fourth order Runge-Kutta. Four evaluations, not symplectic (energy drifts slowly)
+    struct RungeKutta4 {
+        static constexpr int evaluations = 4;
+
+        template<typename Acceleration>
+        static void advance(std::size_t i, float& x, float& y, float& vx, float& vy, float dt, const Acceleration& accel) {
+            const float half = 0.5f * dt;
+            float ax1, ay1, ax2, ay2, ax3, ay3, ax4, ay4;
+
+            accel(i, x, y, vx, vy, ax1, ay1);
+            float vx2 = vx + ax1 * half, vy2 = vy + ay1 * half;
+            accel(i, x + vx * half, y + vy * half, vx2, vy2, ax2, ay2);
+            float vx3 = vx + ax2 * half, vy3 = vy + ay2 * half;
+            accel(i, x + vx2 * half, y + vy2 * half, vx3, vy3, ax3, ay3);
+            float vx4 = vx + ax3 * dt, vy4 = vy + ay3 * dt;
+            accel(i, x + vx3 * dt, y + vy3 * dt, vx4, vy4, ax4, ay4);
+
+            const float sixth = dt / 6.0f;
+            x = x + (vx + 2.0f * vx2 + 2.0f * vx3 + vx4) * sixth;
+            y = y + (vy + 2.0f * vy2 + 2.0f * vy3 + vy4) * sixth;
+            vx = vx + (ax1 + 2.0f * ax2 + 2.0f * ax3 + ax4) * sixth;
+            vy = vy + (ay1 + 2.0f * ay2 + 2.0f * ay3 + ay4) * sixth;
+        }
+    };
+
+    // ======================================================================== //
+    // ============================= Accelerations ============================ //
+    // ======================================================================== //
+
+    // Acceleration from the forces accumulated in the store, constant over the step
+    struct StoredForces {
+        const float* fx;
+        const float* fy;
+        const float* inv_mass;
+
+        explicit StoredForces(const BodyStore& store) : fx(store.fx()), fy(store.fy()), inv_mass(store.invMass()) {}
+
+        void operator()(std::size_t i, float, float, float, float, float& ax, float& ay) const {
+            ax = fx[i] * inv_mass[i];
+            ay = fy[i] * inv_mass[i];
+        }
+    };
+
+    /* Steps bodies [begin, end) with the given policy and acceleration. Static and
+    sleeping bodies are stepped too and then have their old state selected back,
+    which keeps the loop free of branches the compiler can't turn into blends.*/
+    template<typename Integrator, typename Acceleration>
+    void integrateRange(BodyStore& store, std::size_t begin, std::size_t end, float deltaTime, const Acceleration& accel) {
+        float* px = store.x();
+        float* py = store.y();
+        float* pvx = store.vx();
+        float* pvy = store.vy();
+        const std::uint32_t* flags = store.flags();
+        for (std::size_t i = begin; i < end; i++) {
+            float x = px[i], y = py[i], vx = pvx[i], vy = pvy[i];
+            Integrator::advance(i, x, y, vx, vy, deltaTime, accel);
+            const bool active = (flags[i] & BODY_INACTIVE) == 0;
+            px[i] = active ? x : px[i];
+            py[i] = active ? y : py[i];
+            pvx[i] = active ? vx : pvx[i];
+            pvy[i] = active ? vy : pvy[i];
+        }
+    }
+
+    // integrateRange with StoredForces, the signature World::step calls per chunk
+    template<typename Integrator>
+    void integrateStoredForces(BodyStore& store, std::size_t begin, std::size_t end, float deltaTime) {
+        integrateRange<Integrator>(store, begin, end, deltaTime, StoredForces(store));
+    }
+
+    // Semi-implicit Euler on stored forces has SIMD kernels, and gives the same results
+    template<>
+    inline void integrateStoredForces<SemiImplicitEuler>(BodyStore& store, std::size_t begin, std::size_t end, float deltaTime) {
+        integrateRange(store, begin, end, deltaTime);
+    }
+
+    // ======================================================================== //
+    // ============================ Staged Evaluation ========================= //
+    // ======================================================================== //
+
+    /* Accelerations that come from a pass over every body at once (force
+    generators, e.g. a Barnes-Hut tree) can't be evaluated one body at a
+    time inside a policy. A staged step instead runs the policy once per
+    evaluation: pass s replays the accelerations already found for
+    evaluations 0 .. s-1 and writes the state evaluation s asks about into
+    the store, where the caller evaluates the forces to fill in ax[s]/ay[s].
+    Pass Integrator::evaluations writes the end of step state. Evaluation 0
+    is at the start state, so it needs no pass.*/
+    struct StagedState {
+        const float* x0;    // start of step state of every body
+        const float* y0;
+        const float* vx0;
+        const float* vy0;
+        const float* ax[MAX_EVALUATIONS];  // acceleration of every body at each evaluation found so far
+        const float* ay[MAX_EVALUATIONS];
+    };
+
+    // Acceleration functor for one body in pass stage of a staged step
+    struct StagedProbe {
+        const StagedState& staged;
+        int stage;
+        mutable int next = 0;               // evaluations are asked for in order
+        mutable float x = 0.0f, y = 0.0f, vx = 0.0f, vy = 0.0f;  // state of evaluation stage
+
+        void operator()(std::size_t i, float px, float py, float pvx, float pvy, float& ax, float& ay) const {
+            int evaluation = next++;
+            if (evaluation < stage) {
+                ax = staged.ax[evaluation][i];
+                ay = staged.ay[evaluation][i];
+                return;
+            }
+            if (evaluation == stage) {
+                x = px;
+                y = py;
+                vx = pvx;
+                vy = pvy;
+            }
+            ax = 0.0f;  // evaluations after this pass's are discarded
+            ay = 0.0f;
+        }
+    };
+
+    /* Pass stage of a staged step over bodies [begin, end), advancing from the
+    start state in staged. Static and sleeping bodies keep their state.*/
+    template<typename Integrator>
+    void integrateStaged(BodyStore& store, std::size_t begin, std::size_t end, float deltaTime, const StagedState& staged, int stage) {
+        float* px = store.x();
+        float* py = store.y();
+        float* pvx = store.vx();
+        float* pvy = store.vy();
+        const std::uint32_t* flags = store.flags();
+        for (std::size_t i = begin; i < end; i++) {
+            if (flags[i] & BODY_INACTIVE) {
+                continue;
+            }
+            float x = staged.x0[i], y = staged.y0[i], vx = staged.vx0[i], vy = staged.vy0[i];
+            StagedProbe probe{staged, stage};
+            Integrator::advance(i, x, y, vx, vy, deltaTime, probe);
+            const bool done = stage >= Integrator::evaluations;
+            px[i] = done ? x : probe.x;
+            py[i] = done ? y : probe.y;
+            pvx[i] = done ? vx : probe.vx;
+            pvy[i] = done ? vy : probe.vy;
+        }
+    }
+
+} // namespace world
+
+#endif
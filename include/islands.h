@@ -0,0 +1,57 @@
+#ifndef ISLANDS_H // Inclusion guard
+#define ISLANDS_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <allocation.h>
+#include <body_store.h>
+#include <narrowphase.h>
+
+namespace world {
+
+    struct SleepSettings {
+        bool enabled = true;
+        float velocity = 0.05f;     // speed a body moves with over a step (before contacts) below which it counts as resting
+        std::uint32_t steps = 60;   // steps an island must rest before it sleeps
+    };
+
+    // Body counts after the last step
+    struct IslandStats {
+        std::size_t islands = 0;        // islands of awake dynamic bodies
+        std::size_t awake_bodies = 0;   // dynamic bodies that were simulated
+        std::size_t asleep_bodies = 0;  // bodies skipped by the integrator and broad-phase
+    };
+
+    /* Groups touching dynamic bodies into islands and puts resting islands to sleep.
+    Islands are built each step with union-find over the contact pairs (static
+    bodies don't join islands, so everything resting on the same floor isn't
+    one island). An island sleeps once every body in it has stayed below the
+    sleep velocity for the configured number of steps. The speed is taken
+    after integration and before the solver: a body resting on the ground
+    leaves the solver with the bias velocity that holds it out of the floor
+    (about |g| dt), which gravity cancels before it moves. A sleeping island wakes
+    as a whole when one of its bodies is changed through a BodyStore setter or
+    destroyed, or when an awake body touches it.*/
+    class IslandManager {
+    private:
+        SleepSettings config;
+        IslandStats counts;
+        std::uint32_t* parent = nullptr;        // union-find forest over dense indices, from the frame arena
+
+        std::uint32_t find(std::uint32_t i);
+        void unite(std::uint32_t a, std::uint32_t b);
+
+    public:
+        void wakePending(BodyStore& bodies);  // Wake islands queued since the last call
+        void countResting(BodyStore& bodies);  // Count rest steps from the integrated velocities, before contacts
+        void wakeTouched(BodyStore& bodies, const std::vector<narrowphase::Contact>& contacts);  // Wake sleepers an awake body touched
+        void update(BodyStore& bodies, const std::vector<narrowphase::Contact>& contacts, memory::FrameArena& arena);  // Build islands and sleep resting ones
+
+        SleepSettings& settings() { return config; }
+        const IslandStats& stats() const { return counts; }
+    };
+
+} // namespace world
+
+#endif
@@ -0,0 +1,37 @@
+#ifndef NARROWPHASE_H // Inclusion guard
+#define NARROWPHASE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <body_store.h>
+#include <broadphase.h>
+#include <thread_pool.h>
+
+namespace narrowphase {
+
+    // Touching pair of circles
+    struct Contact {
+        std::uint32_t a, b;             // dense BodyStore indices, as in the broad-phase pair
+        float normal_x, normal_y;       // unit normal pointing from a to b
+        float penetration;              // overlap depth, > 0
+        float point_x, point_y;         // midway between the two surfaces along the normal
+    };
+
+    /* Turns broad-phase pairs into contacts for the circles that actually overlap.
+    Pairs are processed in fixed-size chunks, on the thread pool if one is given,
+    and contacts keep the order of the pairs they came from. Within a chunk,
+    4, 8 or 16 pairs are tested at once with SSE2, AVX2 or AVX-512 (following
+    simd::active()); every level produces bit-identical contacts.*/
+    class NarrowPhase {
+    private:
+        std::vector<std::vector<Contact>> chunk_contacts;  // per-chunk output, kept to reuse capacity
+
+    public:
+        void collide(const world::BodyStore& bodies, const std::vector<broadphase::BodyPair>& pairs,
+                     std::vector<Contact>& contacts, threading::ThreadPool* pool = nullptr);
+    };
+
+} // namespace narrowphase
+
+#endif
@@ -2,6 +2,8 @@
 #define OBJECT_H 
 
 #include <vector.h>
+#include <body_store.h>
+#include <integrate.h>
 
 namespace objects {
 
@@ -15,11 +17,17 @@ namespace objects {
         vector::Vector<float, 2> velocity;  // velocity vector
         vector::Vector<float, 2>  force;    // accumulated forces vector
 
+        /* When store is set the circle is a view onto a body held in a BodyStore
+        (e.g. one created by world::World) and the fields above are unused. */
+        world::BodyStore* store = nullptr;
+        world::BodyHandle handle;
+
     public:
         // ======================================================================== //
         // =============================== Constructors =========================== //
         // ======================================================================== //
         Circle(vector::Vector<float, 2> pos , float radius, float mass, bool is_static = false, float restitution = 1.0f);
+        Circle(world::BodyStore& store, world::BodyHandle handle);  // View onto a stored body
 
         // ======================================================================== //
         // ================================== Getters ============================= //
@@ -30,6 +38,10 @@ namespace objects {
         float getMass() const;
         bool isStatic() const;
         float getRestitution() const;
+        world::BodyHandle getHandle() const;   // Only meaningful for views
+        bool isView() const;
+        bool isValid() const;                  // False for a view whose body was destroyed; using one asserts
+        bool isSleeping() const;               // Only views can sleep, see world::IslandManager
 
         // ======================================================================== //
         // ================================== Setters ============================= //
@@ -38,14 +50,34 @@ namespace objects {
         void setPosition(const vector::Vector<float, 2>& newPos);
         void setVelocity(float newVx, float newVy);
         void setVelocity(const vector::Vector<float, 2>& newVel);
+        // Forces are ignored by static circles and act on the next update only
         void setForce(float newFx, float newFy);
         void setForce(const vector::Vector<float, 2>& newForce);
         void applyForce(float forceX, float forceY);    // To apply additional forces
         void applyForce(const vector::Vector<float, 2>& appliedForce);    
 
-        // Update position based on velocity and forces
+        // Update position based on velocity and forces, then clear the forces
         void update(float deltaTime);
 
+        // Same, with an integrator policy from integrate.h, e.g. update<world::VelocityVerlet>(dt)
+        template<typename Integrator>
+        void update(float deltaTime) {
+            if (store) {
+                std::uint32_t i = store->indexOf(handle);
+                world::integrateRange<Integrator>(*store, i, i + 1, deltaTime, world::StoredForces(*store));
+                store->clearForces(i, i + 1);
+                return;
+            }
+            if (is_static) {
+                return;
+            }
+            float ax = force[0] / mass;
+            float ay = force[1] / mass;
+            auto accel = [ax, ay](std::size_t, float, float, float, float, float& out_x, float& out_y) { out_x = ax; out_y = ay; };
+            Integrator::advance(0, position[0], position[1], velocity[0], velocity[1], deltaTime, accel);
+            force = vector::Vector<float, 2>();
+        }
+
     };
 
 } // namespace objects
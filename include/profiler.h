@@ -0,0 +1,168 @@
+#ifndef PROFILER_H // Inclusion guard
+#define PROFILER_H
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <simd.h>
+
+#if SIMD_X86
+#include <x86intrin.h>
+#endif
+
+// Stage timers are compiled in unless built with -DPROFILING=0 (make PROFILING=0),
+// which removes every scope; the per-frame counters are kept either way
+#ifndef PROFILING
+#define PROFILING 1
+#endif
+
+namespace profiling {
+
+    // Stages of World::step, in the order they run
+    enum class Stage : std::uint8_t {
+        Wake = 0,       // waking islands queued by setters and destroyed bodies
+        Forces,         // force generators
+        Integrate,
+        BroadPhase,
+        NarrowPhase,
+        Solve,
+        Islands,        // island building and sleeping
+        Hash,           // state hash, when enabled in World::determinismSettings()
+        Count
+    };
+    const std::size_t STAGE_COUNT = static_cast<std::size_t>(Stage::Count);
+
+    const char* stageName(Stage stage);
+
+    // Raw timestamp: the time stamp counter on x86, steady_clock nanoseconds elsewhere
+    inline std::uint64_t ticks() {
+#if SIMD_X86
+        return __rdtsc();
+#else
+        return static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count());
+#endif
+    }
+
+    // What one step did and how long each stage took
+    struct FrameStats {
+        std::uint64_t frame = 0;                    // step number, counting from 1
+        double stage_seconds[STAGE_COUNT] = {};     // wall time per stage on the stepping thread, zero if compiled out
+        double step_seconds = 0.0;                  // whole step, zero if compiled out
+        std::uint32_t bodies = 0;
+        std::uint32_t awake_bodies = 0;             // dynamic bodies that were simulated
+        std::uint32_t pairs = 0;                    // broad-phase candidate pairs
+        std::uint32_t contacts = 0;                 // narrow-phase contacts
+        std::uint32_t solver_iterations = 0;
+        std::uint64_t state_hash = 0;               // hash of the bodies after the step (hashing::hashBodies), zero if not enabled
+
+        double stageSeconds(Stage stage) const { return stage_seconds[static_cast<std::size_t>(stage)]; }
+    };
+
+    /* Collects stage timings and counters for World::step.
+    Timed spans go into one fixed-size ring buffer per pool thread, each
+    written only by its own thread, so recording a span is two timestamp
+    reads and a store with no locking or allocation; the oldest spans are
+    overwritten once a ring is full. Spans marked as stages (on the stepping
+    thread) are also summed into the FrameStats of the step, which is kept
+    for the last FRAME_HISTORY steps. Timestamps are converted to seconds
+    with a tick rate found once per process when the first Profiler is
+    constructed, so converting never waits on a clock.*/
+    class Profiler {
+    public:
+        static constexpr std::size_t EVENTS_PER_THREAD = 8192;
+        static constexpr std::size_t FRAME_HISTORY = 256;
+
+    private:
+        struct Event {
+            std::uint64_t start;
+            std::uint64_t end;
+            std::uint32_t frame;
+            Stage stage;
+            bool chunk;             // part of a stage run on a pool thread, trace only
+        };
+
+        // Padded to a cache line so threads writing neighbouring rings don't contend
+        struct alignas(64) Ring {
+            std::vector<Event> events;
+            std::uint64_t written = 0;
+        };
+
+        std::vector<Ring> rings;                // one per pool thread, 0 is the stepping thread
+        std::vector<FrameStats> history;        // ring of the last FRAME_HISTORY steps
+        std::vector<std::uint64_t> history_end; // tick each of those steps ended at
+        std::uint64_t frames = 0;
+        std::uint64_t frame_start = 0;
+        std::uint64_t stage_ticks[STAGE_COUNT] = {};  // summed stage spans of the step in progress
+
+        std::uint64_t origin_ticks;     // tick at construction, time zero of the trace
+        double seconds_per_tick;
+
+    public:
+        explicit Profiler(unsigned thread_count = 1);
+
+        void setThreadCount(unsigned thread_count);  // Clears the recorded spans
+
+        // Called by World::step around each step
+        void beginFrame();
+        void endFrame(std::uint32_t bodies, std::uint32_t awake_bodies, std::uint32_t pairs, std::uint32_t contacts, std::uint32_t solver_iterations,
+                      std::uint64_t state_hash = 0);
+
+        void record(unsigned worker, Stage stage, std::uint64_t start, std::uint64_t end, bool chunk) {
+            Ring& ring = rings[worker];
+            ring.events[ring.written % EVENTS_PER_THREAD] = Event{start, end, static_cast<std::uint32_t>(frames), stage, chunk};
+            ring.written++;
+            if (!chunk) {
+                stage_ticks[static_cast<std::size_t>(stage)] += end - start;
+            }
+        }
+
+        // ======================================================================== //
+        // ================================== Results ============================= //
+        // ======================================================================== //
+        const FrameStats& lastFrame() const;                  // The most recent step, empty before the first
+        std::size_t frameCount() const;                       // Steps held in the history
+        const FrameStats& frameAt(std::size_t index) const;   // 0 is the oldest step held
+        double toSeconds(std::uint64_t tick_count) const { return static_cast<double>(tick_count) * seconds_per_tick; }
+
+        /* Writes the recorded spans and per-step counters as Chrome trace event
+        JSON, viewable in chrome://tracing or Perfetto. Returns false if the
+        file couldn't be written.*/
+        bool writeChromeTrace(const char* path) const;
+        void clear();
+    };
+
+    /* Records the span from construction to destruction on the given pool
+    thread. Use through the macros below so it disappears with PROFILING=0.*/
+    class Scope {
+    private:
+        Profiler& target;
+        std::uint64_t start;
+        unsigned worker;
+        Stage stage;
+        bool chunk;
+
+    public:
+        Scope(Profiler& profiler, Stage scope_stage, unsigned thread, bool is_chunk)
+            : target(profiler), start(ticks()), worker(thread), stage(scope_stage), chunk(is_chunk) {}
+        ~Scope() { target.record(worker, stage, start, ticks(), chunk); }
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+    };
+
+} // namespace profiling
+
+#define PROFILE_CONCAT_INNER(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_INNER(a, b)
+
+#if PROFILING
+// A whole stage on the stepping thread, counted in FrameStats
+#define PROFILE_STAGE(profiler, stage) profiling::Scope PROFILE_CONCAT(profile_scope_, __LINE__)(profiler, stage, 0, false)
+// One chunk of a stage on pool thread worker, only shown in the trace
+#define PROFILE_CHUNK(profiler, stage, worker) profiling::Scope PROFILE_CONCAT(profile_scope_, __LINE__)(profiler, stage, worker, true)
+#else
+#define PROFILE_STAGE(profiler, stage) ((void)0)
+#define PROFILE_CHUNK(profiler, stage, worker) ((void)(worker))
+#endif
+
+#endif
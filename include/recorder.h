@@ -0,0 +1,153 @@
+#ifndef RECORDER_H // Inclusion guard
+#define RECORDER_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <body_store.h>
+
+namespace recording {
+
+    /* Recording file layout:
+        FileHeader
+        frames, each a FrameHeader followed by payload_bytes of encoded channels
+    Positions and velocities are quantised to integer multiples of the steps
+    in the file header. Keyframes store the quantised values, delta frames
+    the difference from the previous frame in the file, so bodies at rest
+    cost almost nothing. Each of the four channels (x, y, vx, vy) is
+    encoded body by body as zigzag varints, with a run of zeros written as a
+    zero followed by the run length minus one.*/
+    const std::uint32_t VERSION = 1;
+
+    struct FileHeader {
+        char magic[8];                  // "PHYSREC1"
+        std::uint32_t version;
+        std::uint32_t keyframe_interval;
+        float position_step;
+        float velocity_step;
+        std::uint8_t reserved[8];
+    };
+
+    struct FrameHeader {
+        std::uint32_t keyframe;         // 1 for a keyframe, 0 for a delta frame
+        std::uint32_t body_count;
+        std::uint64_t frame;            // capture number, gaps mark dropped frames
+        std::uint64_t payload_bytes;
+    };
+
+    // Frames of more bodies aren't captured, and a Reader takes a header claiming more as corrupt
+    const std::uint32_t MAX_FRAME_BODIES = 1u << 24;
+
+    static_assert(sizeof(FileHeader) == 32, "FileHeader layout is part of the file format");
+    static_assert(sizeof(FrameHeader) == 24, "FrameHeader layout is part of the file format");
+
+    struct RecorderSettings {
+        float position_step = 1.0f / 4096.0f;   // quantisation of positions, the error is at most half a step
+        float velocity_step = 1.0f / 1024.0f;   // quantisation of velocities
+        std::uint32_t keyframe_interval = 120;  // frames between keyframes, also forced when bodies are created or destroyed
+        std::size_t queue_frames = 4;           // captures that can wait for the I/O thread before new ones are dropped
+    };
+
+    /* Streams quantised body positions and velocities to a file for replay
+    and offline analysis.
+    capture() only copies the four arrays into a free capture buffer and
+    queues it; quantising, encoding and writing happen on a background I/O
+    thread. If the I/O thread falls behind and every buffer is queued, the
+    frame is dropped rather than making the step loop wait. Only call
+    capture() from one thread.*/
+    class Recorder {
+    private:
+        struct Capture {
+            std::uint64_t frame = 0;
+            std::uint64_t layout = 0;   // BodyStore::layoutVersion() when captured
+            std::vector<float> x, y, vx, vy;
+        };
+
+        RecorderSettings config;
+        std::FILE* file = nullptr;
+        std::thread io_thread;
+
+        std::mutex lock;
+        std::condition_variable ready_signal;
+        std::vector<Capture> captures;
+        std::vector<std::size_t> free_captures;     // indices into captures
+        std::vector<std::size_t> ready_captures;    // waiting for the I/O thread, oldest first
+        bool stopping = false;
+
+        std::uint64_t next_frame = 0;
+        std::atomic<std::uint64_t> dropped{0};
+        std::atomic<std::uint64_t> written{0};       // bytes
+        std::atomic<bool> failed{false};
+
+        // Encoder state, only touched by the I/O thread
+        std::vector<std::int32_t> previous[4];      // quantised channels of the last frame written
+        std::uint64_t previous_layout = 0;
+        std::uint32_t since_keyframe = 0;
+        bool have_previous = false;
+        std::vector<std::int32_t> quantised;        // channel being encoded, swapped into previous afterwards
+        std::vector<unsigned char> payload;
+
+        void ioLoop();
+        void writeFrame(const Capture& capture);
+
+    public:
+        Recorder() = default;
+        ~Recorder() { close(); }
+        Recorder(const Recorder&) = delete;
+        Recorder& operator=(const Recorder&) = delete;
+
+        bool open(const char* path, const RecorderSettings& settings = RecorderSettings());  // False if the file can't be created
+        void close();  // Writes every queued frame, then closes the file
+        bool isOpen() const { return file != nullptr; }
+
+        bool capture(const world::BodyStore& bodies);  // False if the frame was dropped (queue full, write failed, or over MAX_FRAME_BODIES)
+
+        std::uint64_t framesCaptured() const { return next_frame; }
+        std::uint64_t framesDropped() const { return dropped.load(); }
+        std::uint64_t bytesWritten() const { return written.load(); }
+        bool writeFailed() const { return failed.load(); }  // A write error stopped the recording
+    };
+
+    // One decoded frame, values are the quantised ones the recorder stored
+    struct Frame {
+        std::uint64_t frame = 0;
+        bool keyframe = false;
+        std::vector<float> x, y, vx, vy;
+    };
+
+    // Reads a recording back frame by frame
+    class Reader {
+    private:
+        std::FILE* file = nullptr;
+        FileHeader header = {};
+        std::vector<std::int32_t> previous[4];
+        std::vector<unsigned char> payload;
+        std::uint64_t remaining = 0;    // bytes of the file not read yet, frame sizes are checked against it
+
+    public:
+        Reader() = default;
+        ~Reader() { close(); }
+        Reader(const Reader&) = delete;
+        Reader& operator=(const Reader&) = delete;
+
+        bool open(const char* path);  // False if the file is missing or not a recording of this version
+        void close();
+
+        float positionStep() const { return header.position_step; }
+        float velocityStep() const { return header.velocity_step; }
+
+        /* Decodes the next frame into frame. False at the end of the file, or if
+        the frame is truncated, claims more bytes than the file has left or more
+        than MAX_FRAME_BODIES bodies, or is a delta frame that doesn't match the
+        one before it.*/
+        bool next(Frame& frame);
+    };
+
+} // namespace recording
+
+#endif
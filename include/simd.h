@@ -0,0 +1,29 @@
+#ifndef SIMD_H // Inclusion guard
+#define SIMD_H
+
+namespace simd {
+
+    /* Instruction set levels a batched kernel can be dispatched to.
+    Ordered from narrowest to widest so levels can be compared directly.*/
+    enum class Level {
+        Scalar = 0,  // plain C++ reference path, also used for tails
+        SSE2,        // 4 float lanes
+        AVX2,        // 8 float lanes
+        AVX512,      // 16 float lanes
+    };
+
+    Level detect();                 // Widest level this CPU supports (queried once via CPUID)
+    Level active();                 // Level batched kernels currently dispatch to
+    void setLevel(Level level);     // Select a level, clamped to detect(); Scalar selects the reference path
+    const char* name(Level level);
+
+} // namespace simd
+
+// Kernels are compiled per-function for each ISA, so the build itself needs no -m flags
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#define SIMD_X86 1
+#else
+#define SIMD_X86 0
+#endif
+
+#endif
@@ -0,0 +1,115 @@
+#ifndef SNAPSHOT_H // Inclusion guard
+#define SNAPSHOT_H
+
+#include <cstddef>
+#include <cstdint>
+#include <body_store.h>
+
+namespace snapshot {
+
+    /* File layout, all little-endian as written by the saving machine:
+        Header                      64 bytes
+        ArrayEntry[array_count]     where each array is and how big it is
+        arrays                      each starting on a 64-byte boundary
+    Every array is a plain dump of one BodyStore array, so a mapped file can
+    be used in place: loading is a header check plus one copy per array.
+    Readers skip array ids they don't know, so arrays can be added without
+    breaking older readers; VERSION changes only when existing data changes
+    meaning.*/
+    const std::uint32_t VERSION = 1;
+    const std::size_t ALIGNMENT = 64;
+
+    enum ArrayId : std::uint32_t {
+        ARRAY_X = 0,
+        ARRAY_Y,
+        ARRAY_VX,
+        ARRAY_VY,
+        ARRAY_FX,
+        ARRAY_FY,
+        ARRAY_INV_MASS,
+        ARRAY_MASS,
+        ARRAY_RADIUS,
+        ARRAY_RESTITUTION,
+        ARRAY_FLAGS,        // world::BodyFlags bits, static and sleeping
+        ARRAY_REST_STEPS,
+        ARRAY_ISLAND_IDS,
+        ARRAY_COUNT
+    };
+
+    struct Header {
+        char magic[8];                  // "PHYSSNAP"
+        std::uint32_t version;
+        std::uint32_t byte_order;       // 0x01020304 as the writer stored it
+        std::uint64_t body_count;
+        std::uint64_t file_size;
+        std::uint64_t table_offset;     // first ArrayEntry
+        std::uint32_t array_count;
+        std::uint32_t alignment;
+        std::uint8_t reserved[16];
+    };
+
+    struct ArrayEntry {
+        std::uint32_t id;               // ArrayId
+        std::uint32_t element_size;
+        std::uint64_t offset;           // from the start of the file, a multiple of ALIGNMENT
+        std::uint64_t bytes;
+    };
+
+    static_assert(sizeof(Header) == 64, "Header layout is part of the file format");
+    static_assert(sizeof(ArrayEntry) == 24, "ArrayEntry layout is part of the file format");
+
+    // Writes every body in bodies to path, false if the file couldn't be written
+    bool save(const world::BodyStore& bodies, const char* path);
+
+    /* Read-only memory mapping of a snapshot file.
+    open() maps the file and checks the header and array table; nothing else
+    is read until the arrays are used, so opening is near-instant whatever
+    the size and pages are only loaded as they are touched. The arrays point
+    straight into the mapping and stay valid until close().*/
+    class View {
+    private:
+        const unsigned char* data = nullptr;
+        std::size_t length = 0;
+        void* mapping = nullptr;        // platform handle kept for close()
+        std::size_t count = 0;
+        const void* arrays[ARRAY_COUNT] = {};
+
+    public:
+        View() = default;
+        ~View() { close(); }
+        View(const View&) = delete;
+        View& operator=(const View&) = delete;
+
+        bool open(const char* path);    // False if the file is missing, truncated or not a snapshot of this version
+        void close();
+        bool isOpen() const { return data != nullptr; }
+
+        std::size_t size() const { return count; }  // Bodies in the snapshot
+        const float* x() const { return static_cast<const float*>(arrays[ARRAY_X]); }
+        const float* y() const { return static_cast<const float*>(arrays[ARRAY_Y]); }
+        const float* vx() const { return static_cast<const float*>(arrays[ARRAY_VX]); }
+        const float* vy() const { return static_cast<const float*>(arrays[ARRAY_VY]); }
+        const float* fx() const { return static_cast<const float*>(arrays[ARRAY_FX]); }
+        const float* fy() const { return static_cast<const float*>(arrays[ARRAY_FY]); }
+        const float* invMass() const { return static_cast<const float*>(arrays[ARRAY_INV_MASS]); }
+        const float* mass() const { return static_cast<const float*>(arrays[ARRAY_MASS]); }
+        const float* radius() const { return static_cast<const float*>(arrays[ARRAY_RADIUS]); }
+        const float* restitution() const { return static_cast<const float*>(arrays[ARRAY_RESTITUTION]); }
+        const std::uint32_t* flags() const { return static_cast<const std::uint32_t*>(arrays[ARRAY_FLAGS]); }
+        const std::uint32_t* restSteps() const { return static_cast<const std::uint32_t*>(arrays[ARRAY_REST_STEPS]); }
+        const std::uint32_t* islandIds() const { return static_cast<const std::uint32_t*>(arrays[ARRAY_ISLAND_IDS]); }
+    };
+
+    /* Replaces the bodies in bodies with the snapshot at path, in the saved
+    order. Handles from before the load are invalidated; false (leaving
+    bodies untouched) if the file can't be opened as a snapshot.
+    Nothing is parsed, but the arrays are copied out of the mapping: the
+    store owns arrays that create() and destroy() resize, so it can't run on
+    read-only mapped pages. That is one memcpy of 52 bytes per body (about
+    40 ms for a million bodies, against well under a millisecond to map);
+    use a View to read a snapshot without copying it.*/
+    bool load(world::BodyStore& bodies, const char* path);
+
+} // namespace snapshot
+
+#endif
@@ -0,0 +1,95 @@
+#ifndef SOLVER_H // Inclusion guard
+#define SOLVER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <allocation.h>
+#include <body_store.h>
+#include <narrowphase.h>
+#include <thread_pool.h>
+
+namespace solver {
+
+    struct Settings {
+        int iterations = 10;                // most velocity iterations per step
+        float tolerance = 1e-4f;            // stop early once no impulse changes by more than this
+        float baumgarte = 0.2f;             // fraction of the penetration pushed out per step
+        float slop = 0.01f;                 // penetration left alone to avoid jitter
+        float restitution_threshold = 0.5f; // approach speed below which contacts don't bounce
+        bool warm_starting = true;          // start from last step's impulses
+    };
+
+    /* Sequential impulse contact solver with warm starting.
+    Every contact accumulates a non-negative normal impulse over several
+    iterations; the total is cached under the pair's body handles (slots and
+    generations, so a recycled slot starts from zero) and applied
+    up front the next step, so a resting stack starts close to its solution
+    and settles in a few iterations. Penetration is removed with a Baumgarte
+    bias velocity and restitution with a velocity target.
+    Contacts are graph coloured first: no two contacts of the same colour
+    share a dynamic body, so every contact in a colour can be solved in
+    parallel without races, and colours are solved one after another in a
+    fixed order. The result therefore doesn't depend on the thread count.*/
+    class ContactSolver {
+    private:
+        static constexpr std::uint32_t NO_ENTRY = 0xFFFFFFFFu;
+
+        // Per-contact data prepared once per step
+        struct Constraint {
+            std::uint32_t a, b;
+            float normal_x, normal_y;
+            float inv_mass_a, inv_mass_b;
+            float normal_mass;      // 1 / (inv_mass_a + inv_mass_b)
+            float bias;             // target separating velocity
+            float impulse;          // accumulated normal impulse
+            std::uint32_t entry;    // warm starting cache entry, NO_ENTRY for a new pair
+            std::uint64_t key;      // body pair id for the warm starting cache
+            std::uint64_t generations;  // handle generations of the pair, ordered like key
+        };
+
+        // Warm starting cache entry, chained per hash bucket
+        struct CacheEntry {
+            std::uint64_t key;
+            std::uint64_t generations;  // impulse only applies to the bodies holding these slots when it was stored
+            float impulse;
+            std::uint32_t next;     // next entry in the bucket, NO_ENTRY at the end
+            std::uint32_t stamp;    // step the entry was last touched
+        };
+
+        Settings config;
+        int last_iterations = 0;
+        std::size_t colour_count = 0;
+
+        // Persistent cache of last step's impulses, entries live in a block pool
+        memory::BlockPool<CacheEntry> cache_entries;
+        std::vector<std::uint32_t> cache_buckets;   // first entry per bucket, power of two sized
+        std::uint32_t cache_stamp = 0;
+
+        // Step scratch, carved from the frame arena passed to solve()
+        Constraint* constraints = nullptr;
+        std::uint32_t* colour_start = nullptr;      // offsets into ordered, one per colour plus one
+        std::uint32_t* ordered = nullptr;           // contact indices grouped by colour
+        float* worker_change = nullptr;             // largest impulse change seen by each worker this iteration
+
+        void colour(const world::BodyStore& bodies, const std::vector<narrowphase::Contact>& contacts, memory::FrameArena& arena);
+        std::uint32_t findCached(std::uint64_t key) const;
+        void storeImpulses(std::size_t count, memory::FrameArena& arena);  // Update the cache and evict pairs that stopped touching
+
+    public:
+        explicit ContactSolver(const Settings& settings = Settings());
+
+        /* Scratch memory for the step comes from arena and stays in use until it is
+        reset; the warm starting cache persists in the solver.*/
+        void solve(world::BodyStore& bodies, const std::vector<narrowphase::Contact>& contacts, float deltaTime,
+                   memory::FrameArena& arena, threading::ThreadPool* pool = nullptr);
+
+        Settings& settings() { return config; }
+        void clearCache();  // Forget all warm starting impulses, e.g. after the bodies were replaced
+        std::size_t colourCount() const { return colour_count; }
+        int iterationsUsed() const { return last_iterations; }  // Velocity iterations run by the last solve
+    };
+
+} // namespace solver
+
+#endif
@@ -0,0 +1,31 @@
+#ifndef STATE_HASH_H // Inclusion guard
+#define STATE_HASH_H
+
+#include <cstddef>
+#include <cstdint>
+#include <allocation.h>
+#include <body_store.h>
+#include <thread_pool.h>
+
+namespace hashing {
+
+    /* 64-bit xxHash (XXH64) of bytes bytes at data.
+    Reads the input as little-endian words, so the value matches the
+    reference implementation on little-endian machines.*/
+    std::uint64_t xxh64(const void* data, std::size_t bytes, std::uint64_t seed = 0);
+
+    // Bodies hashed per chunk, fixed so the hash never depends on the thread count
+    const std::size_t HASH_CHUNK_BODIES = 16384;
+
+    /* Hash of every array in bodies, the same ones a snapshot saves, so a
+    world loaded from a snapshot hashes the same as the one that saved it.
+    Each chunk of HASH_CHUNK_BODIES bodies is hashed on its own (on pool if
+    given) into a table allocated from arena, and the table is then hashed
+    in chunk order. Two stores hash equal only if every value matches bit
+    for bit, so comparing the hash of each step between runs finds the
+    exact step they diverged at.*/
+    std::uint64_t hashBodies(const world::BodyStore& bodies, memory::FrameArena& arena, threading::ThreadPool* pool = nullptr);
+
+} // namespace hashing
+
+#endif
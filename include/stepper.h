@@ -0,0 +1,71 @@
+#ifndef STEPPER_H // Inclusion guard
+#define STEPPER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <vector.h>
+#include <world.h>
+
+namespace world {
+
+    struct StepperSettings {
+        float fixed_dt = 1.0f / 60.0f;  // simulation step, independent of the frame rate
+        int max_substeps = 8;           // most fixed steps one advance() call may run
+        float max_frame_time = 0.25f;   // frame times above this are clamped before being accumulated
+    };
+
+    /* Drives a World at a fixed timestep from variable frame times.
+    advance() adds the elapsed wall-clock time to an accumulator and runs
+    World::step(fixed_dt) while at least one fixed step fits, so the
+    simulation only ever sees one dt and gives the same result whatever the
+    frame rate. The time left over is reported as alpha(), the fraction of a
+    step the display is ahead of the simulation, and renderX()/renderY() hold
+    every body's position blended between the last two steps by that amount,
+    so motion looks smooth without simulating at the display rate.
+    A slow frame would otherwise ask for ever more substeps, making the next
+    frame slower still; the frame time is clamped and at most max_substeps
+    steps run per call, any time beyond that is dropped (the simulation
+    briefly runs slower than real time instead).*/
+    class FixedStepper {
+    private:
+        World& target;
+        StepperSettings config;
+        double accumulator = 0.0;       // unsimulated time, in [0, fixed_dt) after advance()
+        double dropped = 0.0;           // total time discarded by the caps
+        std::uint64_t steps = 0;
+        int last_substeps = 0;
+
+        std::vector<float> prev_x, prev_y;      // positions before the last step, in dense order
+        std::uint64_t prev_layout = 0;          // store layout the previous positions belong to
+        std::vector<float> render_x, render_y;  // interpolated positions, in dense order
+        std::uint64_t render_layout = 0;        // store layout the interpolated positions belong to
+
+        void interpolate();
+
+    public:
+        explicit FixedStepper(World& world, const StepperSettings& settings = StepperSettings());
+
+        /* Consumes frameTime seconds of wall-clock time and returns the number of
+        fixed steps run, then refreshes the interpolated positions. Negative and
+        non-finite frame times count as zero.*/
+        int advance(float frameTime);
+
+        StepperSettings& settings() { return config; }
+        float alpha() const { return static_cast<float>(accumulator / config.fixed_dt); }
+        int lastSubsteps() const { return last_substeps; }
+        std::uint64_t stepCount() const { return steps; }   // Fixed steps run since construction
+        double droppedTime() const { return dropped; }      // Seconds discarded to avoid a spiral of death
+
+        /* Interpolated positions as of the last advance(), indexed like the
+        BodyStore arrays. If bodies were created or destroyed since the last
+        step every body shows its current position until the next step.*/
+        const float* renderX() const { return render_x.data(); }
+        const float* renderY() const { return render_y.data(); }
+        // One body's interpolated position, or its current one if bodies were created or destroyed since the last advance()
+        vector::Vector<float, 2> renderPosition(BodyHandle handle) const;
+    };
+
+} // namespace world
+
+#endif
@@ -0,0 +1,105 @@
+#ifndef THREAD_POOL_H // Inclusion guard
+#define THREAD_POOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace threading {
+
+    /* Persistent pool of worker threads with work-stealing.
+    parallelFor splits a range into fixed-size chunks and deals contiguous
+    runs of them out to per-thread queues. Each thread pops from the back of
+    its own queue and, once that is empty, steals from the front of the
+    others, so uneven chunks still keep every thread busy. The calling thread
+    takes part as worker 0, and threads sleep between calls rather than being
+    created per call.
+    parallelFor must only be called from the thread that owns the pool and
+    must not be nested.*/
+    class ThreadPool {
+    private:
+        struct Job {
+            void (*run)(void* context, std::size_t begin, std::size_t end, unsigned worker);
+            void* context;
+        };
+
+        struct Chunk {
+            std::size_t begin;
+            std::size_t end;
+            const Job* job;
+        };
+
+        // Owner takes from the back, thieves from the front (head)
+        struct alignas(64) Queue {
+            std::mutex lock;
+            std::vector<Chunk> chunks;
+            std::size_t head = 0;
+        };
+
+        unsigned participants;
+        std::unique_ptr<Queue[]> queues;    // one per participant, 0 is the calling thread
+        std::vector<std::thread> threads;
+
+        std::mutex sleep_lock;
+        std::condition_variable wake;
+        std::uint64_t epoch = 0;            // bumped every time work is posted
+        bool stopping = false;
+        std::atomic<std::size_t> remaining{0};
+
+        bool runOne(unsigned worker);       // Pop or steal one chunk and run it, false if none found
+        void workerLoop(unsigned worker);
+        void run(std::size_t begin, std::size_t end, std::size_t grain, const Job& job);
+
+    public:
+        // ======================================================================== //
+        // =============================== Constructors =========================== //
+        // ======================================================================== //
+        explicit ThreadPool(unsigned thread_count = std::thread::hardware_concurrency());  // Includes the calling thread
+        ~ThreadPool();
+        ThreadPool(const ThreadPool&) = delete;
+        ThreadPool& operator=(const ThreadPool&) = delete;
+
+        unsigned size() const { return participants; }
+
+        // ======================================================================== //
+        // ================================ Scheduling ============================ //
+        // ======================================================================== //
+
+        /* Calls body(chunk_begin, chunk_end, worker) for consecutive chunks of at most
+        grain items covering [begin, end), and returns once all of them have run.
+        Chunk boundaries depend only on grain, never on the thread count; worker
+        is the index (< size()) of the thread running the chunk.*/
+        template<typename Body>
+        void parallelFor(std::size_t begin, std::size_t end, std::size_t grain, Body&& body) {
+            using Function = typename std::remove_reference<Body>::type;
+            Job job{[](void* context, std::size_t b, std::size_t e, unsigned worker) { (*static_cast<Function*>(context))(b, e, worker); },
+                    const_cast<void*>(static_cast<const void*>(&body))};
+            run(begin, end, grain, job);
+        }
+    };
+
+    /* parallelFor on pool, or a plain serial loop over the same chunks when pool
+    is null. Lets stages take an optional pool without duplicating their loops.*/
+    template<typename Body>
+    void parallelFor(ThreadPool* pool, std::size_t begin, std::size_t end, std::size_t grain, Body&& body) {
+        if (pool) {
+            pool->parallelFor(begin, end, grain, body);
+            return;
+        }
+        if (grain == 0) {
+            grain = 1;
+        }
+        for (std::size_t b = begin; b < end; b += grain) {
+            body(b, end - b < grain ? end : b + grain, 0u);
+        }
+    }
+
+} // namespace threading
+
+#endif
@@ -3,34 +3,332 @@
 
 // Includes
 #include <cmath> // For math functions
+#include <cstdint> // For the fixed width integer used by the scalar fast inverse square root
+#include <cstring> // For std::memcpy
+#include <type_traits> // For std::enable_if, std::is_same etc.
+#include <utility> // For std::index_sequence
+
+/* SSE2 is part of every x86-64 CPU, so the compiler always defines __SSE2__
+there and the intrinsics below need no extra compiler flags. On any other
+architecture the specialisations are skipped and the generic template is used.*/
+#if defined(__SSE2__)
+#include <immintrin.h>
+#define VECTOR_SSE 1
+#else
+#define VECTOR_SSE 0
+#endif
 
 namespace vector{
 
+    /* Forward declaration of the Vector class. The helper classes below need to
+    name Vector (e.g. as the return type of normalised()) before it is defined.*/
+    template<typename T, int Dimension>
+    class Vector;
+
+    namespace detail {
+
+        /* `__builtin_is_constant_evaluated()` is true while the compiler is evaluating
+        an expression at compile time (e.g. to initialise a constexpr variable) and
+        false when the same code runs normally. Intrinsics can't be evaluated at
+        compile time, so the SIMD code paths check this and fall back to plain
+        arithmetic inside constant expressions. (C++20 names this
+        std::is_constant_evaluated; GCC and Clang offer the builtin in C++17 too.)*/
+        constexpr bool constantEvaluated() {
+#if defined(__GNUC__) || defined(__clang__)
+            return __builtin_is_constant_evaluated();
+#else
+            return false;
+#endif
+        }
+
+        /* `Identity<T>::type` is just T, but naming it this way stops the compiler from
+        deducing T from that argument. Without it, `vec * 2` with a float vector would
+        fail to compile as T would be deduced as both float (from vec) and int (from 2).*/
+        template<typename T>
+        struct Identity {
+            using type = T;
+        };
+
+    } // namespace detail
+
+    // ======================================================================== //
+    // ======================== Fast Inverse Square Root ====================== //
+    // ======================================================================== //
+
+    /* Approximate 1 / sqrt(x), used by the fast normalisation functions.
+    The SSE `rsqrtss` instruction gives a 12 bit accurate estimate in a few cycles
+    (compared to ~20 for a sqrt followed by a divide). One step of Newton-Raphson,
+    y = y * (1.5 - 0.5 * x * y * y), then roughly doubles the number of correct
+    bits: measured over normal floats the relative error is at most 3e-7, about
+    two float ulps. Without SSE the estimate comes from the well known integer
+    "magic number" trick on the bit pattern of x, which is only good to about 3%,
+    so it takes two steps and stays within 5e-6.*/
+    inline float fastInverseSqrt(float x) {
+#if VECTOR_SSE
+        float estimate = _mm_cvtss_f32(_mm_rsqrt_ss(_mm_set_ss(x)));
+#else
+        std::uint32_t bits;
+        std::memcpy(&bits, &x, sizeof(bits)); // memcpy is the defined way to reinterpret the bits
+        bits = 0x5F375A86u - (bits >> 1);
+        float estimate;
+        std::memcpy(&estimate, &bits, sizeof(estimate));
+        estimate = estimate * (1.5f - 0.5f * x * estimate * estimate);
+#endif
+        return estimate * (1.5f - 0.5f * x * estimate * estimate);
+    }
+
+    /* Double version: start from the float estimate and refine twice in double,
+    each step doubling the correct bits (12 -> 24 -> 48).*/
+    inline double fastInverseSqrt(double x) {
+        double estimate = fastInverseSqrt(static_cast<float>(x));
+        estimate = estimate * (1.5 - 0.5 * x * estimate * estimate);
+        return estimate * (1.5 - 0.5 * x * estimate * estimate);
+    }
+
+    // Any other type (e.g. int vectors) just uses the exact calculation
+    template<typename T>
+    T fastInverseSqrt(T x) {
+        return T(1) / std::sqrt(x);
+    }
+
+    // ======================================================================== //
+    // ============================ Vector Expressions ======================== //
+    // ======================================================================== //
+
+    /* Expression templates
+    Written the obvious way, `a + b * dt - c` creates a temporary vector for
+    `b * dt`, another for `a + (b * dt)` and a third for the final subtraction,
+    looping over the components three times. Instead, the operators below return
+    small "expression" objects that only remember what was asked for (e.g. "the sum
+    of these two things"). Nothing is calculated until the expression is assigned
+    to a Vector, at which point a single loop evaluates every component with
+    result[i] = a[i] + b[i] * dt - c[i], with no temporaries at all.
+
+    VectorExpression is the base of every expression (and of Vector itself). It uses
+    the "Curiously Recurring Template Pattern" (CRTP): each derived class passes
+    itself as the template parameter E, so the base can cast itself to the derived
+    type and call its operator[] without needing virtual functions. Everything is
+    therefore resolved at compile time and inlined away.
+
+    !!! Expressions hold references to the vectors they were built from, so an
+    expression must be turned into a Vector before those vectors go out of scope.
+    Writing `auto sum = a + b;` stores the expression, not the result, so always
+    spell out the type: `Vector<float, 3> sum = a + b;` !!!*/
+    template<typename E, typename T, int Dimension>
+    class VectorExpression {
+        public:
+            // Access the derived class (the actual expression or vector)
+            constexpr const E& derived() const {
+                return static_cast<const E&>(*this);
+            }
+
+            // Component index of the expression, calculated on demand
+            constexpr T operator[](int index) const {
+                return derived()[index];
+            }
+
+            // Force evaluation into a concrete vector
+            constexpr Vector<T, Dimension> eval() const {
+                return Vector<T, Dimension>(*this);
+            }
+    };
+
+    /* How an expression stores one of its operands. Vectors are stored by reference
+    (copying them would defeat the point), while nested expressions are tiny objects
+    that are usually temporaries, so they are stored by value.*/
+    template<typename E>
+    struct Operand {
+        using type = const E;
+    };
+
+    template<typename T, int Dimension>
+    struct Operand<Vector<T, Dimension>> {
+        using type = const Vector<T, Dimension>&;
+    };
+
+    // a + b
+    template<typename L, typename R, typename T, int Dimension>
+    class VectorSum : public VectorExpression<VectorSum<L, R, T, Dimension>, T, Dimension> {
+        private:
+            typename Operand<L>::type left;
+            typename Operand<R>::type right;
+
+        public:
+            constexpr VectorSum(const L& l, const R& r) : left(l), right(r) {}
+            constexpr T operator[](int index) const {
+                return left[index] + right[index];
+            }
+    };
+
+    // a - b
+    template<typename L, typename R, typename T, int Dimension>
+    class VectorDifference : public VectorExpression<VectorDifference<L, R, T, Dimension>, T, Dimension> {
+        private:
+            typename Operand<L>::type left;
+            typename Operand<R>::type right;
+
+        public:
+            constexpr VectorDifference(const L& l, const R& r) : left(l), right(r) {}
+            constexpr T operator[](int index) const {
+                return left[index] - right[index];
+            }
+    };
+
+    // a * scalar
+    template<typename E, typename T, int Dimension>
+    class VectorScaled : public VectorExpression<VectorScaled<E, T, Dimension>, T, Dimension> {
+        private:
+            typename Operand<E>::type operand;
+            T scalar;
+
+        public:
+            constexpr VectorScaled(const E& e, T s) : operand(e), scalar(s) {}
+            constexpr T operator[](int index) const {
+                return operand[index] * scalar;
+            }
+    };
+
+    /* The operators build the expression objects. They accept anything derived from
+    VectorExpression, so both vectors and other expressions can be combined, and the
+    matching T and Dimension parameters mean only like vectors can be combined.*/
+    template<typename L, typename R, typename T, int Dimension>
+    constexpr VectorSum<L, R, T, Dimension> operator+(const VectorExpression<L, T, Dimension>& left, const VectorExpression<R, T, Dimension>& right) {
+        return VectorSum<L, R, T, Dimension>(left.derived(), right.derived());
+    }
+
+    template<typename L, typename R, typename T, int Dimension>
+    constexpr VectorDifference<L, R, T, Dimension> operator-(const VectorExpression<L, T, Dimension>& left, const VectorExpression<R, T, Dimension>& right) {
+        return VectorDifference<L, R, T, Dimension>(left.derived(), right.derived());
+    }
+
+    /* Multiplication by scalar, in both orders. As these are non-member functions
+    Scalar * Vector works as well as Vector * Scalar.*/
+    template<typename E, typename T, int Dimension>
+    constexpr VectorScaled<E, T, Dimension> operator*(const VectorExpression<E, T, Dimension>& vec, typename detail::Identity<T>::type scalar) {
+        return VectorScaled<E, T, Dimension>(vec.derived(), scalar);
+    }
+
+    template<typename E, typename T, int Dimension>
+    constexpr VectorScaled<E, T, Dimension> operator*(typename detail::Identity<T>::type scalar, const VectorExpression<E, T, Dimension>& vec) {
+        return VectorScaled<E, T, Dimension>(vec.derived(), scalar);
+    }
+
+    // ======================================================================== //
+    // =========================== Shared Vector Functions ==================== //
+    // ======================================================================== //
+
+    /* Functions that only need dot() and scalar multiplication, shared between the
+    generic Vector and the SIMD specialisations further down (again using CRTP, so
+    `self()` is the actual vector type). Each vector type then only has to
+    implement its arithmetic and dot product.*/
+    template<typename Derived, typename T, int Dimension>
+    class VectorFunctions {
+        private:
+            constexpr const Derived& self() const {
+                return static_cast<const Derived&>(*this);
+            }
+
+        public:
+            // Squared magnitude, cheaper than magnitude() as no square root is needed
+            constexpr T magnitudeSquared() const {
+                return self().dot(self());
+            }
+
+            // Magnitude
+            T magnitude() const {
+                return std::sqrt(magnitudeSquared());
+            }
+
+            // Angle between 2 Vectors
+            double angle(const Derived& other) const {
+                return std::acos(self().dot(other) / (magnitude() * other.magnitude()));
+            }
+
+            /* Normalisation
+            Returns a vector pointing the same way with a magnitude of 1. A zero
+            vector has no direction, so it is returned unchanged instead of dividing
+            by zero and producing NaNs.*/
+            Vector<T, Dimension> normalised() const {
+                T length = magnitude();
+                if (length == T(0)) {
+                    return Vector<T, Dimension>();
+                }
+                return Vector<T, Dimension>(self() * (T(1) / length));
+            }
+
+            /* Same as normalised() but multiplies by the approximate fastInverseSqrt
+            of the squared magnitude, trading a tiny error (about 3e-7 relative
+            for float with SSE, 5e-6 without) for speed.*/
+            Vector<T, Dimension> fastNormalised() const {
+                T length_squared = magnitudeSquared();
+                if (length_squared == T(0)) {
+                    return Vector<T, Dimension>();
+                }
+                return Vector<T, Dimension>(self() * fastInverseSqrt(length_squared));
+            }
+
+            /* Projection
+            The component of this vector that points along `onto`:
+                (this . onto / onto . onto) * onto
+            Projecting onto a zero vector gives a zero vector.*/
+            constexpr Vector<T, Dimension> projectOnto(const Derived& onto) const {
+                T length_squared = onto.dot(onto);
+                if (length_squared == T(0)) {
+                    return Vector<T, Dimension>();
+                }
+                return Vector<T, Dimension>(onto * (self().dot(onto) / length_squared));
+            }
+
+            /* Projection onto a direction that is already normalised, which skips the
+            division: (this . direction) * direction*/
+            constexpr Vector<T, Dimension> projectOntoUnit(const Derived& direction) const {
+                return Vector<T, Dimension>(direction * self().dot(direction));
+            }
+
+            /* Rejection
+            The part of this vector perpendicular to `onto`, i.e. what is left after
+            removing the projection. this == projectOnto(x) + rejectFrom(x).*/
+            constexpr Vector<T, Dimension> rejectFrom(const Derived& onto) const {
+                return Vector<T, Dimension>(self() - projectOnto(onto));
+            }
+    };
+
     /* Create vector class with variable dimension sizing
     Template will cause the compiler to create the class as necessary
-    for different values of Dimension, allowing for multiple vectors 
+    for different values of Dimension, allowing for multiple vectors
     of different dimensions to be created with this single class.
     This is also why the implementation is defined in the header file:
-    the compiler will need to create a new class each time a new 
+    the compiler will need to create a new class each time a new
     instance of the class is created with different template parameters.
     Therefore the compiler needs to see the full template and not just what is
     in the implementation file, otherwise linker errors will occur.
     T = type template parameter, allowing for different data types
     Dimension = non-type template parameter.
     Vector<int, 2> will create a 2D vector of integers
-    Vector<std::string, 3> will create a 3D vector of strings etc.*/
+    Vector<double, 3> will create a 3D vector of doubles etc.
+
+    The class is "trivially copyable": it has no user-written copy constructor,
+    copy assignment or destructor, so the compiler generates them and they are
+    just a copy of the bytes. That means vectors can be memcpy'd, stored in arrays
+    that are copied in bulk, and kept in registers, which the compiler can't do
+    once a hand-written copy loop (with a self-assignment check) is involved.
+    Every function that can be is also `constexpr`, so vectors can be created and
+    combined at compile time, e.g. `constexpr Vector<float, 2> gravity(0.0f, -9.81f);`*/
     template<typename T, int Dimension>
-    class Vector {
+    class Vector : public VectorExpression<Vector<T, Dimension>, T, Dimension>, public VectorFunctions<Vector<T, Dimension>, T, Dimension> {
         // private parameters that will not be changed
         private:
-            
+
             // ======================================================================== //
             // ========================== Private Member Variables ==================== //
             // ======================================================================== //
 
-            T components[Dimension]; // Define array to store the components of the vector
+            /* Define array to store the components of the vector. The `{}` value-initialises
+            it (all zeros), which a constexpr constructor requires as every member must be
+            initialised before the constructor body runs.*/
+            T components[Dimension]{};
+
 
-            
             // ======================================================================== //
             // ========================= Private Helper Functions  ==================== //
             // ======================================================================== //
@@ -39,24 +337,36 @@ namespace vector{
             `size_t... Indices` is a parameter pack of compile-time integer indices
             (i.e. from 0 to Dimension - 1 when implemented)*/
             template<typename... Args, size_t... Indices>
-            /*`setComponents` is needed due to using a pack and not a real container 
+            /*`setComponents` is needed due to using a pack and not a real container
              (i.e. this is where the array analogy breaks down). We can't just get args[0] etc.
              Therefore we need to create this private member function to assign the arguments
              to the indices of the vector.
              `std::index_sequence<Indices...>` is a template type, which encodes a sequence
              of integers into the type itself. i.e. 0 to elements-1 is part of the type so
-             that only like sized index sequences can interact. It carries no runtime data 
+             that only like sized index sequences can interact. It carries no runtime data
              and is primarily used to enable compile-time index-based operations*/
-             void setComponents(std::index_sequence<Indices...>, Args... args){
+             constexpr void setComponents(std::index_sequence<Indices...>, Args... args){
 
                 /*`static_cast<T>` converts each argument to type T if possible
-                `...` is the fold operator which causes the expression to be repeated for 
+                `...` is the fold operator which causes the expression to be repeated for
                 each instance in the pair (args and Indices). The full expression therefore
                 sets each argument equal to its corresponding index pair, which results in
                 the argument order matching the vector component order*/
                 ((components[Indices] = static_cast<T>(args)), ...);
              }
 
+            /* Evaluate an expression into this vector. The same fold trick writes out one
+            statement per component, so there is no loop left for the compiler to
+            (maybe) unroll. Every component is calculated into `values` before any is
+            stored: the expression may read this very vector (`a = b + a`), and if the
+            components were written one at a time the compiler would have to re-read
+            every operand after each write instead of keeping them in registers.*/
+            template<typename E, size_t... Indices>
+            constexpr void evaluate(const VectorExpression<E, T, Dimension>& expression, std::index_sequence<Indices...>){
+                const T values[Dimension] = {expression[static_cast<int>(Indices)]...};
+                ((components[Indices] = values[Indices]), ...);
+            }
+
         // public accessible parameters
         public:
             // ======================================================================== //
@@ -64,38 +374,34 @@ namespace vector{
             // ======================================================================== //
 
             /*Note that the Vector function is defined multiple times. As all instances of
-            this function require different inputs, the compiler is still able to 
-            differentiate between each of these functions. This is called overloading 
+            this function require different inputs, the compiler is still able to
+            differentiate between each of these functions. This is called overloading
             the function.*/
 
             /* Default Constructor
-            Allows for Vector command with no input variables to create a 
-            default vector of zeros*/
-            Vector(){
-                for(int i = 0; i < Dimension; i++){
-                    components[i] = T(0);
-                };
-            };
+            Allows for Vector command with no input variables to create a
+            default vector of zeros (the zeros come from the `{}` on components)*/
+            constexpr Vector() = default;
+
 
-            
-            /* Variadic Constructor 
-            Allow for values to be directly implemented into the vector creation 
+            /* Variadic Constructor
+            Allow for values to be directly implemented into the vector creation
             i.e. vector::Vector<int, 3>(int 19, int 3, int 42); (aka variadic constructor).
             New template here is to allow the constructor to handle multiple input arguments
-            `typename... Args` is a typename parameter pack, stating that any number of 
-            arguments can be accepted in and that the types can vary. Varying types are 
+            `typename... Args` is a typename parameter pack, stating that any number of
+            arguments can be accepted in and that the types can vary. Varying types are
             removed later. The Args parameter pack can be considered similar to an array of
             varying input arguments that (may) have different data types.
             `typename = ` is expecting a typename output for the next set of commands
-            `std::enable_if<...>::type` will return a type if the conditions are met (default type 
+            `std::enable_if<...>::type` will return a type if the conditions are met (default type
             void) and nothing if the conditions are not met. Combine this with `typename =`
-            means if the condition in the enable_if statement is not met, this template 
+            means if the condition in the enable_if statement is not met, this template
             will cause a compile time error.
             `sizeof...(Args) == Dimension` is checking that the number of arguments passed
             into the constructor is the same as the requested vector size Dimension.
-            `std::is_same<T, Args>::value` checks if a single input argument is the same 
+            `std::is_same<T, Args>::value` checks if a single input argument is the same
             type as requested from the vector T
-            `&& ...` is a fold experesion, which causes the previous check to be performed on 
+            `&& ...` is a fold experesion, which causes the previous check to be performed on
             everything in the Args pack. The above 2 expressions combine to essentially loop
             over the arguments and ensure they are all of type T.*/
             template<typename... Args, typename = typename std::enable_if<sizeof...(Args) == Dimension && (std::is_same<T, Args>::value && ...)>::type>
@@ -104,34 +410,37 @@ namespace vector{
              in the above template. We then call these variable arguments args.
              `setComponents` is defined in the private section.
              */
-            Vector(Args... args) {
-                /*`std::make_index_sequence<Dimension>` creates an empty object of type 
+            constexpr Vector(Args... args) {
+                /*`std::make_index_sequence<Dimension>` creates an empty object of type
                 index_sequence<0,1, ... , Dimension-1>*/
                 setComponents(std::make_index_sequence<Dimension>(), args...);
             }
 
-            
 
 
-            /* Allows for Vector command to parse Dimension number of type T input 
+
+            /* Allows for Vector command to parse Dimension number of type T input
             variables from an array to create the vector of desired length.
-            Const prevents the function from altering the values of the input 
+            Const prevents the function from altering the values of the input
             array during the execution*/
-            explicit Vector(const T values[Dimension]){
+            explicit constexpr Vector(const T values[Dimension]){
                 for(int i = 0; i < Dimension; i++){
                     components[i] = values[i];
                 };
             };
-            
-            /*Allow Vector command to create a new vector by copying all values 
-            from an existing vector of the same type and dimension, without 
-            altering the original.*/
-            Vector(const Vector<T, Dimension>& other){
-                for(int i = 0; i < Dimension; i++){
-                    components[i] = other[i];
-                }
-            };
-            
+
+            /* Evaluate an expression (see VectorExpression above) into a new vector.
+            This is the single loop that does all of the work for a chain such as
+            `a + b * dt - c`. It isn't `explicit`, so an expression can be passed
+            anywhere a Vector is expected.
+            There is deliberately no copy constructor here any more: the one the
+            compiler generates copies the array directly and keeps the class
+            trivially copyable.*/
+            template<typename E>
+            constexpr Vector(const VectorExpression<E, T, Dimension>& expression){
+                evaluate(expression, std::make_index_sequence<Dimension>());
+            }
+
             // ======================================================================== //
             // ================================ Operators ============================= //
             // ======================================================================== //
@@ -140,124 +449,64 @@ namespace vector{
             i.e. if we have an int vector vec, we could store the 1st value of that
             vector by running: int x = vec[0];
             Similarly we can alter the values of vec by running vec[0] = int(10);
-            This is because we used the & operator, which tells the operator that we 
+            This is because we used the & operator, which tells the operator that we
             are calling a reference to the actual value of the return value.
             In other words, [] will return the address where the variable is stored
             opposed to making a new parameter with the same value.*/
-            T& operator[](int index){
+            constexpr T& operator[](int index){
                 return components[index];
             }
 
-            /* As the above allows for direct editing of a vector, it cannot be used 
-            when a vector is defined as a const. This is why we need the following 
+            /* As the above allows for direct editing of a vector, it cannot be used
+            when a vector is defined as a const. This is why we need the following
             version of the operator definintion to allow for pulling a specific index
             from a const vector. The first const allows for viewing of the reference
-            but prevents editing (i.e protects the vector element). The second const 
+            but prevents editing (i.e protects the vector element). The second const
             tells the compiler that the method of this operator will not edit the vector
             that the operator is called on (i.e. protects the vector as a whole).*/
-            const T& operator[](int index) const {
+            constexpr const T& operator[](int index) const {
                 return components[index];
             }
 
-            /* Assignment operator*/
-            Vector<T, Dimension>& operator=(const Vector<T, Dimension>& other){
-                if (this != &other) {
-                    for (int i=0; i < Dimension; i++){
-                        components[i] = other[i];
-                    }
-                }
+            /* Assignment from an expression, evaluated straight into this vector.
+            Plain Vector = Vector assignment uses the compiler generated operator.*/
+            template<typename E>
+            constexpr Vector<T, Dimension>& operator=(const VectorExpression<E, T, Dimension>& expression){
+                evaluate(expression, std::make_index_sequence<Dimension>());
                 return *this;
             }
 
-            /* Vector addition operators
-            Will return a Vector with the same dimensions and internal data type of the
-            objects used in the addition.
-            `vector<T,Dimension>&` returns a reference to the same vector opposed to a 
+            /* Compound assignment operators
+            `vector<T,Dimension>&` returns a reference to the same vector opposed to a
             newly defined vector (via the &) which is inline with the standard definition
-            of += in C++
-            `const Vector<T, Dimension>& other` allows + to take in a reference (&) to 
-            a second vector on the right hand side of the operator while ensuring that 
-            vector is not edited (const).
-            The const before the function implementation (within the {}) ensures the 
-            initial vector cannot itself be edited*/
-
-            Vector<T, Dimension>& operator+=(const Vector<T, Dimension>& other){
-                for(int i=0; i < Dimension; i++){
-                    components[i] += other[i];
-                }
-                return *this;
+            of += in C++.
+            They accept any expression, so `a += b * dt` doesn't create a temporary either.
+            The non-compound operators (+, -, *) are non-member functions defined above
+            with the expression templates.*/
+            template<typename E>
+            constexpr Vector<T, Dimension>& operator+=(const VectorExpression<E, T, Dimension>& other){
+                return *this = *this + other;
             }
 
-            Vector<T, Dimension> operator+(const Vector<T, Dimension>& other) const{
-                // Copy of the object being acted upon using the above defined constructor
-                Vector<T, Dimension> result(*this);
-                // add input vector to the copied version of the initial vector
-                result += other;
-                return result;
+            template<typename E>
+            constexpr Vector<T, Dimension>& operator-=(const VectorExpression<E, T, Dimension>& other){
+                return *this = *this - other;
             }
 
-            // Vector subtraction
-
-            Vector<T, Dimension>& operator-=(const Vector<T, Dimension>& other){
-                for(int i=0; i < Dimension; i++){
-                    components[i] -= other[i];
-                }
-                return *this;
-            }
-
-            Vector<T, Dimension> operator-(const Vector<T, Dimension>& other) const{
-                Vector<T, Dimension> result(*this);
-                result -= other;
-                return result;
-            }
-
-            /* Multiplication by scalar
-            Note that due to the way c++ works this will only allow for 
-            Vector * Scalar and will not allow Scalar * Vector !!!
-            This is because the operator keyword assumes that the left side operand is 
-            an instance of the class. We get around this by overloading the * operator 
-            again outside the class definition. We can then call this function and 
-            reverse the order manually to prevent duplicate code*/
-            Vector<T, Dimension> operator*(T scalar) const {
-                Vector<T, Dimension> result;
-                for(int i=0; i< Dimension; i++){
-                    result[i] = components[i] * scalar;
-                }
-                return result;
+            constexpr Vector<T, Dimension>& operator*=(T scalar){
+                return *this = *this * scalar;
             }
 
-           
-
             // ======================================================================== //
             // ========================== Vector Math Functions ======================= //
             // ======================================================================== //
 
-            // Magnitude
-            
-            T magnitude() const {
-                T result = 0;
-                for(int i=0; i < Dimension; i++){
-                    result += components[i] * components[i];
-                }
-
-                result = std::sqrt(result);
-                return result;
-            }
-            
-            // Angle between 2 Vectors
-            double angle(const Vector<T, Dimension>& other) const {
-                double result;
-
-                /* this is the pointer to the current instance of the class 
-                the arrow operator (->) is used for calling a method on the object a 
-                pointer is referring to (opposed to the dot (.) operator)*/
-                result = std::acos((this->dot(other)) / (this->magnitude() * other.magnitude()));
-
-                return result;
-            }
+            /* magnitude(), angle(), normalised(), projectOnto() etc. are inherited from
+            VectorFunctions above, which builds them on dot().*/
 
             // Dot product
-            T dot(const Vector<T, Dimension>& other) const {
+            template<typename E>
+            constexpr T dot(const VectorExpression<E, T, Dimension>& other) const {
                 T result = 0;
                 for(int i=0; i < Dimension; i++){
                     result += components[i] * other[i];
@@ -266,9 +515,9 @@ namespace vector{
             }
 
             // Cross product
-            Vector<T, Dimension> cross(const Vector<T, Dimension>& other) const {
-                /* static_assert creates a compile time error with the given message when the 
-                condition specified is not met static_assert is evaluated at compilation and 
+            constexpr Vector<T, Dimension> cross(const Vector<T, Dimension>& other) const {
+                /* static_assert creates a compile time error with the given message when the
+                condition specified is not met static_assert is evaluated at compilation and
                 not during runtime, saving on runtime resources.*/
                 static_assert(Dimension == 3, "Cross product is only defined for 3D vectors!");
                 // Calculation of elements
@@ -280,19 +529,228 @@ namespace vector{
                 return result;
             }
 
+            // Normalise this vector in place (see normalised())
+            Vector<T, Dimension>& normalise(){
+                *this = this->normalised();
+                return *this;
+            }
+
     };
 
+#if VECTOR_SSE
     // ================================================================================ //
-    // =========================== Non-member Utility Functions ======================= //
+    // ============================== SIMD Specialisations ============================ //
     // ================================================================================ //
 
-    // Multiplication by scalar (reversed)
-    template<typename T, int Dimension>
-    Vector<T, Dimension> operator*(T scalar, const Vector<T, Dimension>& vec) {
-        return vec * scalar;
-    }
+    /* Explicit (full) specialisations
+    `template<>` followed by a class with all template parameters filled in tells the
+    compiler "whenever Vector<float, 4> is used, use this class instead of the generic
+    one". Here they replace the component loops with SSE instructions, which operate
+    on all the components at once (SIMD: single instruction, multiple data).
+    Each of these 128-bit types fits in one SSE register, so their arithmetic is
+    evaluated immediately rather than through expression templates: `a + b * dt - c`
+    becomes three instructions with everything kept in registers, which is already
+    what the expression templates achieve for the generic class.
+    The public interface matches the generic Vector (apart from returning
+    vectors instead of expressions), so code using them doesn't need to change.
+    Results match the generic class except dot() (and everything built on it) for
+    Vector<float, 4>, which adds the products in pairs and may round differently
+    in the last bit.
+    AVX registers are 256 bits wide, twice the size of any of these vectors, so
+    SSE is the right fit; with -mavx (or -march=native) the compiler emits the
+    same operations using the AVX (VEX) encodings anyway.*/
+
+    // ======================================================================== //
+    // ============================= Vector<float, 4> ========================= //
+    // ======================================================================== //
+    template<>
+    class alignas(16) Vector<float, 4> : public VectorFunctions<Vector<float, 4>, float, 4> {
+        private:
+            float components[4]{};
+
+            // Load all four components into one register, and back (alignas(16) allows the aligned forms)
+            static __m128 load(const Vector& v) { return _mm_load_ps(v.components); }
+            static Vector store(__m128 value) {
+                Vector result;
+                _mm_store_ps(result.components, value);
+                return result;
+            }
+
+        public:
+            constexpr Vector() = default;
+            constexpr Vector(float x, float y, float z, float w) : components{x, y, z, w} {}
+            explicit constexpr Vector(const float values[4]) : components{values[0], values[1], values[2], values[3]} {}
+
+            constexpr float& operator[](int index) { return components[index]; }
+            constexpr const float& operator[](int index) const { return components[index]; }
+
+            friend constexpr Vector operator+(const Vector& a, const Vector& b) {
+                if (detail::constantEvaluated()) {
+                    return Vector(a[0] + b[0], a[1] + b[1], a[2] + b[2], a[3] + b[3]);
+                }
+                return store(_mm_add_ps(load(a), load(b)));
+            }
+
+            friend constexpr Vector operator-(const Vector& a, const Vector& b) {
+                if (detail::constantEvaluated()) {
+                    return Vector(a[0] - b[0], a[1] - b[1], a[2] - b[2], a[3] - b[3]);
+                }
+                return store(_mm_sub_ps(load(a), load(b)));
+            }
+
+            friend constexpr Vector operator*(const Vector& v, float scalar) {
+                if (detail::constantEvaluated()) {
+                    return Vector(v[0] * scalar, v[1] * scalar, v[2] * scalar, v[3] * scalar);
+                }
+                // _mm_set1_ps copies the scalar into all four lanes
+                return store(_mm_mul_ps(load(v), _mm_set1_ps(scalar)));
+            }
+
+            friend constexpr Vector operator*(float scalar, const Vector& v) { return v * scalar; }
+
+            constexpr Vector& operator+=(const Vector& other) { return *this = *this + other; }
+            constexpr Vector& operator-=(const Vector& other) { return *this = *this - other; }
+            constexpr Vector& operator*=(float scalar) { return *this = *this * scalar; }
+
+            constexpr float dot(const Vector& other) const {
+                if (detail::constantEvaluated()) {
+                    return (components[0] * other[0] + components[1] * other[1]) + (components[2] * other[2] + components[3] * other[3]);
+                }
+                // Multiply lane-wise, then add the upper pair onto the lower pair and the two results together
+                __m128 products = _mm_mul_ps(load(*this), load(other));
+                __m128 pairs = _mm_add_ps(products, _mm_movehl_ps(products, products));
+                return _mm_cvtss_f32(_mm_add_ss(pairs, _mm_shuffle_ps(pairs, pairs, _MM_SHUFFLE(1, 1, 1, 1))));
+            }
+
+            Vector& normalise() { return *this = normalised(); }
+    };
+
+    // ======================================================================== //
+    // ============================= Vector<float, 2> ========================= //
+    // ======================================================================== //
+    /* Two floats are only 64 bits, so they are moved in and out of the low half of
+    an SSE register with 64-bit load and store instructions.
+    The size (8 bytes) is unchanged from the generic class.*/
+    template<>
+    class alignas(8) Vector<float, 2> : public VectorFunctions<Vector<float, 2>, float, 2> {
+        private:
+            float components[2]{};
+
+            // __m128i pointers may alias anything, unlike double*, so the 64-bit integer forms are used
+            static __m128 load(const Vector& v) { return _mm_castsi128_ps(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(v.components))); }
+            static Vector store(__m128 value) {
+                Vector result;
+                _mm_storel_epi64(reinterpret_cast<__m128i*>(result.components), _mm_castps_si128(value));
+                return result;
+            }
+
+        public:
+            constexpr Vector() = default;
+            constexpr Vector(float x, float y) : components{x, y} {}
+            explicit constexpr Vector(const float values[2]) : components{values[0], values[1]} {}
+
+            constexpr float& operator[](int index) { return components[index]; }
+            constexpr const float& operator[](int index) const { return components[index]; }
+
+            friend constexpr Vector operator+(const Vector& a, const Vector& b) {
+                if (detail::constantEvaluated()) {
+                    return Vector(a[0] + b[0], a[1] + b[1]);
+                }
+                return store(_mm_add_ps(load(a), load(b)));
+            }
+
+            friend constexpr Vector operator-(const Vector& a, const Vector& b) {
+                if (detail::constantEvaluated()) {
+                    return Vector(a[0] - b[0], a[1] - b[1]);
+                }
+                return store(_mm_sub_ps(load(a), load(b)));
+            }
+
+            friend constexpr Vector operator*(const Vector& v, float scalar) {
+                if (detail::constantEvaluated()) {
+                    return Vector(v[0] * scalar, v[1] * scalar);
+                }
+                return store(_mm_mul_ps(load(v), _mm_set1_ps(scalar)));
+            }
+
+            friend constexpr Vector operator*(float scalar, const Vector& v) { return v * scalar; }
+
+            constexpr Vector& operator+=(const Vector& other) { return *this = *this + other; }
+            constexpr Vector& operator-=(const Vector& other) { return *this = *this - other; }
+            constexpr Vector& operator*=(float scalar) { return *this = *this * scalar; }
+
+            // Only two products to add, a horizontal SSE sum would cost more than it saves
+            constexpr float dot(const Vector& other) const {
+                return components[0] * other[0] + components[1] * other[1];
+            }
+
+            Vector& normalise() { return *this = normalised(); }
+    };
+
+    // ======================================================================== //
+    // ============================ Vector<double, 2> ========================= //
+    // ======================================================================== //
+    template<>
+    class alignas(16) Vector<double, 2> : public VectorFunctions<Vector<double, 2>, double, 2> {
+        private:
+            double components[2]{};
+
+            static __m128d load(const Vector& v) { return _mm_load_pd(v.components); }
+            static Vector store(__m128d value) {
+                Vector result;
+                _mm_store_pd(result.components, value);
+                return result;
+            }
+
+        public:
+            constexpr Vector() = default;
+            constexpr Vector(double x, double y) : components{x, y} {}
+            explicit constexpr Vector(const double values[2]) : components{values[0], values[1]} {}
+
+            constexpr double& operator[](int index) { return components[index]; }
+            constexpr const double& operator[](int index) const { return components[index]; }
+
+            friend constexpr Vector operator+(const Vector& a, const Vector& b) {
+                if (detail::constantEvaluated()) {
+                    return Vector(a[0] + b[0], a[1] + b[1]);
+                }
+                return store(_mm_add_pd(load(a), load(b)));
+            }
+
+            friend constexpr Vector operator-(const Vector& a, const Vector& b) {
+                if (detail::constantEvaluated()) {
+                    return Vector(a[0] - b[0], a[1] - b[1]);
+                }
+                return store(_mm_sub_pd(load(a), load(b)));
+            }
+
+            friend constexpr Vector operator*(const Vector& v, double scalar) {
+                if (detail::constantEvaluated()) {
+                    return Vector(v[0] * scalar, v[1] * scalar);
+                }
+                return store(_mm_mul_pd(load(v), _mm_set1_pd(scalar)));
+            }
+
+            friend constexpr Vector operator*(double scalar, const Vector& v) { return v * scalar; }
+
+            constexpr Vector& operator+=(const Vector& other) { return *this = *this + other; }
+            constexpr Vector& operator-=(const Vector& other) { return *this = *this - other; }
+            constexpr Vector& operator*=(double scalar) { return *this = *this * scalar; }
+
+            constexpr double dot(const Vector& other) const {
+                return components[0] * other[0] + components[1] * other[1];
+            }
+
+            Vector& normalise() { return *this = normalised(); }
+    };
+#endif
 
+    // Check the promise made in the class description at compile time
+    static_assert(std::is_trivially_copyable<Vector<float, 2>>::value, "Vector must stay trivially copyable");
+    static_assert(std::is_trivially_copyable<Vector<float, 3>>::value, "Vector must stay trivially copyable");
+    static_assert(std::is_trivially_copyable<Vector<double, 2>>::value, "Vector must stay trivially copyable");
+    static_assert(sizeof(Vector<float, 3>) == 3 * sizeof(float), "Expression base classes must not add any size");
 
 
 } // namespace vector
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,184 @@
+#ifndef WORLD_H // Inclusion guard
+#define WORLD_H
+
+#include <vector.h>
+#include <allocation.h>
+#include <objects.h>
+#include <body_store.h>
+#include <broadphase.h>
+#include <narrowphase.h>
+#include <solver.h>
+#include <islands.h>
+#include <integrate.h>
+#include <forces.h>
+#include <thread_pool.h>
+#include <profiler.h>
+#include <state_hash.h>
+#include <memory>
+#include <vector>
+
+namespace world {
+
+    /* Options for lockstep simulation, where separate runs must stay identical
+    bit for bit. Results never depend on the thread count or SIMD level and
+    the build keeps FMA contraction off (see the makefile), so what is left
+    is the order bodies and pairs are processed in.*/
+    struct DeterminismSettings {
+        bool creation_order = false;    // Before a step, sort bodies back into creation order if destroy() moved some
+        bool ordered_pairs = false;     // Sort candidate pairs by body index, whatever the broad-phase backend
+        bool state_hash = false;        // Hash every body array after each step into FrameStats::state_hash
+    };
+
+    /* Owns every simulated circle and advances them together.
+    Bodies live in a BodyStore (structure-of-arrays) and are handed out as
+    objects::Circle views, so code written against the Circle API keeps
+    working while step() integrates all bodies in a single pass.
+    Each stage of step() is split into chunks and run on a persistent
+    thread pool; results are identical whatever the thread count.
+    Circle views hold a pointer to the store, so a World is neither
+    copyable nor movable.*/
+    class World {
+    private:
+        BodyStore store;
+        std::unique_ptr<threading::ThreadPool> pool;
+        std::unique_ptr<broadphase::BroadPhase> broad_phase;
+        std::vector<std::unique_ptr<forces::ForceGenerator>> force_generators;
+        narrowphase::NarrowPhase narrow_phase;
+        solver::ContactSolver contact_solver;
+        IslandManager islands;
+        void (*integrate_range)(BodyStore&, std::size_t, std::size_t, float) = &integrateStoredForces<SemiImplicitEuler>;
+        void (*integrate_staged)(BodyStore&, std::size_t, std::size_t, float, const StagedState&, int) = &integrateStaged<SemiImplicitEuler>;
+        int integrator_evaluations = SemiImplicitEuler::evaluations;
+        memory::FrameArena frame_arena;                 // scratch for one step, reset when the next one starts
+        std::vector<broadphase::BodyPair> pair_list;   // broad-phase output of the last step
+        std::vector<broadphase::BodyPair> pair_scratch; // sorting buffer for ordered pairs
+        std::vector<narrowphase::Contact> contact_list; // narrow-phase output of the last step
+        std::vector<std::uint32_t> query_results;      // scratch for spatial queries
+        profiling::Profiler step_profiler;
+        DeterminismSettings determinism;
+        std::uint64_t ordered_layout = 0;              // store layout last put in creation order
+
+        // Integrates with a higher order policy, evaluating the generators at each of its intermediate states
+        void integrateWithGenerators(float deltaTime, const float* applied_x, const float* applied_y);
+
+    public:
+        // ======================================================================== //
+        // =============================== Constructors =========================== //
+        // ======================================================================== //
+        explicit World(unsigned thread_count = std::thread::hardware_concurrency());  // Uses a SpatialHashGrid broad-phase
+        World(const World&) = delete;
+        World& operator=(const World&) = delete;
+
+        // ======================================================================== //
+        // ============================ Body Management =========================== //
+        // ======================================================================== //
+        objects::Circle createCircle(vector::Vector<float, 2> pos, float radius, float mass, bool is_static = false, float restitution = 1.0f);
+        void destroyCircle(const objects::Circle& circle);
+        objects::Circle getCircle(BodyHandle handle);
+
+        BodyStore& bodies();
+        const BodyStore& bodies() const;
+
+        /* Save or replace every body with a binary snapshot (see snapshot.h).
+        Loading maps the file and copies each array in one go, so even a
+        million bodies load in milliseconds. Circles and handles from before a
+        load are invalidated, and the solver starts again without warm
+        starting. Both return false if the file can't be written or read.*/
+        bool saveSnapshot(const char* path) const;
+        bool loadSnapshot(const char* path);
+
+        /* Integrator policy used by step() (SemiImplicitEuler, VelocityVerlet or
+        RungeKutta4). The choice costs one indirect call per chunk of bodies; the
+        loop inside is instantiated for the policy. With force generators, the
+        higher order policies run them again at every intermediate state they
+        evaluate (see integrateStaged), so a step costs that many generator
+        passes and gains the policy's accuracy for forces that depend on the
+        state, such as MutualGravity or Drag. Forces from applyForce() are held
+        constant over the step.*/
+        template<typename Integrator>
+        void setIntegrator() {
+            integrate_range = &integrateStoredForces<Integrator>;
+            integrate_staged = &integrateStaged<Integrator>;
+            integrator_evaluations = Integrator::evaluations;
+        }
+
+        // ======================================================================== //
+        // ================================== Forces ============================== //
+        // ======================================================================== //
+        /* Generators run at the start of every step, in the order they were added,
+        on top of the forces applied since the last step. Every body's force is
+        cleared once the step has integrated it, so applyForce() acts for one
+        step and a generator is the way to keep a force acting. Higher order
+        integrators run the generators again at their intermediate states (see
+        setIntegrator()).*/
+        forces::ForceGenerator& addForceGenerator(std::unique_ptr<forces::ForceGenerator> generator);
+        void clearForceGenerators();
+
+        // ======================================================================== //
+        // =============================== Broad-phase ============================ //
+        // ======================================================================== //
+        void setBroadPhase(std::unique_ptr<broadphase::BroadPhase> backend);
+        broadphase::BroadPhase& broadPhase();
+        const std::vector<broadphase::BodyPair>& pairs() const;  // Candidate pairs found by the last step
+
+        // ======================================================================== //
+        // ============================= Contacts & Threads ======================= //
+        // ======================================================================== //
+        const std::vector<narrowphase::Contact>& contacts() const;  // Contacts resolved by the last step
+        solver::Settings& solverSettings();
+        int solverIterations() const;  // Velocity iterations the last step's solve needed
+        void setThreadCount(unsigned thread_count);  // Includes the calling thread
+        unsigned threadCount() const;
+
+        // ======================================================================== //
+        // ================================= Profiling ============================ //
+        // ======================================================================== //
+        /* Stage timings and counters of the last step. Stage times are zero when
+        built with PROFILING=0; the counters are always filled in.*/
+        const profiling::FrameStats& frameStats() const;
+        profiling::Profiler& profiler();  // History of recent steps and Chrome trace export
+
+        // ======================================================================== //
+        // =============================== Determinism ============================ //
+        // ======================================================================== //
+        /* Lockstep options, all off by default. Runs that create the same bodies
+        in the same order and make the same calls between steps then match
+        whatever the thread count, SIMD level, broad-phase backend or the order
+        bodies were destroyed in; frameStats().state_hash tells two runs apart
+        at the first step they differ.*/
+        DeterminismSettings& determinismSettings();
+
+        // ======================================================================== //
+        // ================================= Sleeping ============================= //
+        // ======================================================================== //
+        SleepSettings& sleepSettings();
+        const IslandStats& islandStats() const;  // Awake/asleep counts after the last step
+
+        // ======================================================================== //
+        // ============================= Spatial Queries ========================== //
+        // ======================================================================== //
+        /* Answered by the broad-phase, so a backend that keeps a structure between
+        steps (broadphase::TreeBroadPhase) avoids scanning every body.*/
+        std::vector<objects::Circle> queryRegion(const vector::Vector<float, 2>& min, const vector::Vector<float, 2>& max);
+        std::vector<objects::Circle> queryRadius(const vector::Vector<float, 2>& point, float distance);  // Circles within distance of point
+        bool rayCast(const vector::Vector<float, 2>& origin, const vector::Vector<float, 2>& direction, float max_t, broadphase::RayHit& hit);
+
+        // ======================================================================== //
+        // ============================== Update Functions ======================== //
+        // ======================================================================== //
+        /* Advances the simulation by deltaTime:
+            forces -> integrate -> broad-phase -> narrow-phase -> contact resolution -> islands/sleep -> state hash
+        Each stage is timed into profiler() (see profiling::Stage).
+        Sleeping bodies are skipped by integration and the broad-phase.
+        Once the scene has stopped growing and its buffers have reached their
+        peak (most pairs, contacts, islands), a step makes no heap allocations:
+        per-step scratch comes from a frame arena and everything else reuses
+        its capacity. bench_scaling fails if its steps after a warm-up allocate
+        (see memory::heapAllocations()).*/
+        void step(float deltaTime);
+        const memory::FrameArena& frameArena() const { return frame_arena; }
+    };
+
+} // namespace world
+
+#endif
@@ -0,0 +1,708 @@
+// Python bindings, built with make python into build/physics<suffix> (build/<config>/... for other configs).
+// A World whose body arrays are exposed as buffers NumPy wraps without copying, with bulk
+// create/destroy/apply_force calls taking arrays and a step(dt, n) that runs n steps with the GIL released:
+//
+//     import numpy as np, physics
+//     world = physics.World()
+//     handles = world.create(np.random.rand(1000000) * 1000, np.random.rand(1000000) * 1000, 0.5, 1.0)
+//     world.add_gravity()
+//     world.step(1 / 60, 600)
+//     x = np.asarray(world.x)   # float32 view of every body's x position
+//
+// Written against the CPython C API (3.10+) and the buffer protocol only, so it needs no binding
+// library or NumPy at build time; without NumPy the arrays work with memoryview.
+#define PY_SSIZE_T_CLEAN
+#include <Python.h>
+#include <world.h>
+#include <forces.h>
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <thread>
+#include <vector>
+
+namespace {
+
+    // ======================================================================== //
+    // ================================== Objects ============================= //
+    // ======================================================================== //
+
+    // Body arrays exposed as World attributes, in the order of FIELD_NAMES
+    enum Field { FIELD_X, FIELD_Y, FIELD_VX, FIELD_VY, FIELD_FX, FIELD_FY, FIELD_MASS, FIELD_RADIUS };
+    const char* const FIELD_NAMES[] = {"x", "y", "vx", "vy", "fx", "fy", "mass", "radius"};
+    const bool FIELD_WRITABLE[] = {true, true, true, true, true, true, false, false};  // inv_mass is derived from mass, broad-phases cache bounds from radius
+
+    PyObject* world_type = nullptr;
+    PyObject* array_type = nullptr;
+
+    /* World.exports counts the buffers handed out over the body arrays. While
+    any exist, calls that could reallocate the arrays (create, destroy,
+    load_snapshot) raise BufferError, as resizing a bytearray does, so a view
+    can never point at freed memory. step() only writes values in place.*/
+    struct PyWorld {
+        PyObject_HEAD
+        world::World* world;
+        Py_ssize_t exports;
+        bool stepping;      // step() is running with the GIL released
+    };
+
+    // A body array of one World, exporting the buffer protocol
+    struct PyBodyArray {
+        PyObject_HEAD
+        PyWorld* owner;
+        int field;
+        Py_ssize_t shape;   // length of the last buffer exported, constant while any are
+    };
+
+    Py_ssize_t FLOAT_STRIDE = sizeof(float);
+    float EMPTY_ARRAY[1];   // data for buffers over an empty store, whose vectors hold no pointer
+
+    inline std::uint64_t packHandle(world::BodyHandle handle) { return static_cast<std::uint64_t>(handle.generation) << 32 | handle.index; }
+    inline world::BodyHandle unpackHandle(std::uint64_t value) { return world::BodyHandle{static_cast<std::uint32_t>(value), static_cast<std::uint32_t>(value >> 32)}; }
+
+    float* fieldData(world::BodyStore& store, int field) {
+        switch (field) {
+        case FIELD_X: return store.x();
+        case FIELD_Y: return store.y();
+        case FIELD_VX: return store.vx();
+        case FIELD_VY: return store.vy();
+        case FIELD_FX: return store.fx();
+        case FIELD_FY: return store.fy();
+        case FIELD_MASS: return const_cast<float*>(static_cast<const world::BodyStore&>(store).mass());
+        default: return store.radius();
+        }
+    }
+
+    // Sets an exception and returns false if another thread is stepping the world, or if views would be left dangling
+    bool checkIdle(PyWorld* self, bool resizes) {
+        if (self->stepping) {
+            PyErr_SetString(PyExc_RuntimeError, "World is being stepped by another thread");
+            return false;
+        }
+        if (resizes && self->exports > 0) {
+            PyErr_SetString(PyExc_BufferError, "World has exported views of its body arrays; release them before creating or destroying bodies");
+            return false;
+        }
+        return true;
+    }
+
+    // ======================================================================== //
+    // ================================== Inputs ============================== //
+    // ======================================================================== //
+
+    // Format character of a native buffer, with the byte order prefix ('@', '=' or '<' on little endian hosts) removed
+    char formatCode(const Py_buffer& view) {
+        const char* format = view.format ? view.format : "B";
+        if (*format == '@' || *format == '=' || (*format == '<' && PY_LITTLE_ENDIAN)) {
+            format++;
+        }
+        return format[0] != '\0' && format[1] == '\0' ? format[0] : '\0';
+    }
+
+    // Element count of a 1-D buffer or sequence, or -1 for a single number
+    Py_ssize_t inputLength(PyObject* object) {
+        if (PyObject_CheckBuffer(object)) {
+            Py_buffer view;
+            if (PyObject_GetBuffer(object, &view, PyBUF_RECORDS_RO) < 0) {
+                PyErr_Clear();
+                return -1;
+            }
+            Py_ssize_t length = view.ndim == 1 ? view.shape[0] : -1;
+            PyBuffer_Release(&view);
+            return length;
+        }
+        if (PySequence_Check(object) && !PyUnicode_Check(object)) {
+            Py_ssize_t length = PySequence_Size(object);
+            if (length < 0) {
+                PyErr_Clear();  // Reported when the values are read
+            }
+            return length;
+        }
+        return -1;
+    }
+
+    /* Reads count floats from a 1-D float32, float64 or bool buffer (e.g. a
+    NumPy array, strided ones included), a sequence of numbers, or a single number
+    repeated count times. Sets an exception and returns false otherwise.*/
+    bool readFloats(PyObject* object, const char* name, Py_ssize_t count, std::vector<float>& out) {
+        out.resize(count);
+        if (PyObject_CheckBuffer(object)) {
+            Py_buffer view;
+            if (PyObject_GetBuffer(object, &view, PyBUF_RECORDS_RO) < 0) {
+                return false;
+            }
+            char code = formatCode(view);
+            bool ok = view.ndim == 1 && view.shape[0] == count && (code == 'f' || code == 'd' || code == '?');
+            if (!ok) {
+                PyErr_Format(PyExc_ValueError, "%s must be a 1-D float32, float64 or bool array of %zd values", name, count);
+            } else {
+                const char* data = static_cast<const char*>(view.buf);
+                for (Py_ssize_t i = 0; i < count; i++) {
+                    const char* item = data + i * view.strides[0];
+                    if (code == 'f') {
+                        out[i] = *reinterpret_cast<const float*>(item);
+                    } else if (code == 'd') {
+                        out[i] = static_cast<float>(*reinterpret_cast<const double*>(item));
+                    } else {
+                        out[i] = *item ? 1.0f : 0.0f;
+                    }
+                }
+            }
+            PyBuffer_Release(&view);
+            return ok;
+        }
+        if (PySequence_Check(object) && !PyUnicode_Check(object)) {
+            PyObject* sequence = PySequence_Fast(object, name);
+            if (!sequence) {
+                return false;
+            }
+            bool ok = PySequence_Fast_GET_SIZE(sequence) == count;
+            if (!ok) {
+                PyErr_Format(PyExc_ValueError, "%s must hold %zd values", name, count);
+            }
+            PyObject** items = PySequence_Fast_ITEMS(sequence);
+            for (Py_ssize_t i = 0; ok && i < count; i++) {
+                out[i] = static_cast<float>(PyFloat_AsDouble(items[i]));
+                ok = !(out[i] == -1.0f && PyErr_Occurred());
+            }
+            Py_DECREF(sequence);
+            return ok;
+        }
+        float value = static_cast<float>(PyFloat_AsDouble(object));
+        if (value == -1.0f && PyErr_Occurred()) {
+            return false;
+        }
+        std::fill(out.begin(), out.end(), value);
+        return true;
+    }
+
+    // Reads handles from a 1-D buffer of 64-bit integers (as returned by create) or a sequence of ints
+    bool readHandles(PyObject* object, std::vector<world::BodyHandle>& out) {
+        if (PyObject_CheckBuffer(object)) {
+            Py_buffer view;
+            if (PyObject_GetBuffer(object, &view, PyBUF_RECORDS_RO) < 0) {
+                return false;
+            }
+            char code = formatCode(view);
+            bool ok = view.ndim == 1 && view.itemsize == 8 && (code == 'Q' || code == 'q' || code == 'L' || code == 'l');
+            if (!ok) {
+                PyErr_SetString(PyExc_ValueError, "handles must be a 1-D array of 64-bit integers");
+            } else {
+                out.resize(view.shape[0]);
+                const char* data = static_cast<const char*>(view.buf);
+                for (Py_ssize_t i = 0; i < view.shape[0]; i++) {
+                    out[i] = unpackHandle(*reinterpret_cast<const std::uint64_t*>(data + i * view.strides[0]));
+                }
+            }
+            PyBuffer_Release(&view);
+            return ok;
+        }
+        PyObject* sequence = PySequence_Fast(object, "handles must be an array or sequence of handles");
+        if (!sequence) {
+            return false;
+        }
+        Py_ssize_t count = PySequence_Fast_GET_SIZE(sequence);
+        PyObject** items = PySequence_Fast_ITEMS(sequence);
+        out.resize(count);
+        bool ok = true;
+        for (Py_ssize_t i = 0; ok && i < count; i++) {
+            unsigned long long value = PyLong_AsUnsignedLongLong(items[i]);
+            ok = !(value == static_cast<unsigned long long>(-1) && PyErr_Occurred());
+            out[i] = unpackHandle(value);
+        }
+        Py_DECREF(sequence);
+        return ok;
+    }
+
+    // Sets ValueError and returns false unless every handle names a live body of store
+    bool checkHandles(const world::BodyStore& store, const std::vector<world::BodyHandle>& handles) {
+        for (std::size_t k = 0; k < handles.size(); k++) {
+            if (!store.isValid(handles[k])) {
+                PyErr_Format(PyExc_ValueError, "handle %zu (%llu) does not refer to a live body", k, static_cast<unsigned long long>(packHandle(handles[k])));
+                return false;
+            }
+        }
+        return true;
+    }
+
+    /* A new 1-D memoryview of count values of the given format, over its own
+    bytearray. NumPy wraps it with np.asarray without copying.*/
+    PyObject* newArray(Py_ssize_t count, std::size_t item_size, const char* format, void** data) {
+        PyObject* bytes = PyByteArray_FromStringAndSize(nullptr, count * static_cast<Py_ssize_t>(item_size));
+        if (!bytes) {
+            return nullptr;
+        }
+        *data = PyByteArray_AS_STRING(bytes);
+        PyObject* raw = PyMemoryView_FromObject(bytes);
+        Py_DECREF(bytes);
+        if (!raw) {
+            return nullptr;
+        }
+        PyObject* typed = PyObject_CallMethod(raw, "cast", "s", format);
+        Py_DECREF(raw);
+        return typed;
+    }
+
+    // ======================================================================== //
+    // ================================= BodyArray ============================ //
+    // ======================================================================== //
+
+    int arrayGetBuffer(PyObject* object, Py_buffer* view, int flags) {
+        PyBodyArray* self = reinterpret_cast<PyBodyArray*>(object);
+        bool writable = FIELD_WRITABLE[self->field];
+        if ((flags & PyBUF_WRITABLE) && !writable) {
+            PyErr_Format(PyExc_BufferError, "World.%s is read-only", FIELD_NAMES[self->field]);
+            return -1;
+        }
+        world::BodyStore& store = self->owner->world->bodies();
+        float* data = fieldData(store, self->field);
+        self->shape = static_cast<Py_ssize_t>(store.size());
+
+        Py_INCREF(object);
+        view->obj = object;
+        view->buf = data ? data : EMPTY_ARRAY;
+        view->len = self->shape * FLOAT_STRIDE;
+        view->readonly = !writable;
+        view->itemsize = FLOAT_STRIDE;
+        view->format = (flags & PyBUF_FORMAT) ? const_cast<char*>("f") : nullptr;
+        view->ndim = 1;
+        view->shape = (flags & PyBUF_ND) ? &self->shape : nullptr;
+        view->strides = (flags & PyBUF_STRIDES) == PyBUF_STRIDES ? &FLOAT_STRIDE : nullptr;
+        view->suboffsets = nullptr;
+        view->internal = nullptr;
+        self->owner->exports++;
+        return 0;
+    }
+
+    void arrayReleaseBuffer(PyObject* object, Py_buffer*) { reinterpret_cast<PyBodyArray*>(object)->owner->exports--; }
+
+    Py_ssize_t arrayLength(PyObject* object) { return static_cast<Py_ssize_t>(reinterpret_cast<PyBodyArray*>(object)->owner->world->bodies().size()); }
+
+    PyObject* arrayRepr(PyObject* object) {
+        PyBodyArray* self = reinterpret_cast<PyBodyArray*>(object);
+        return PyUnicode_FromFormat("<physics.BodyArray World.%s, %zd float32%s>", FIELD_NAMES[self->field], arrayLength(object),
+                                    FIELD_WRITABLE[self->field] ? "" : ", read-only");
+    }
+
+    void arrayDealloc(PyObject* object) {
+        PyTypeObject* type = Py_TYPE(object);
+        Py_DECREF(reinterpret_cast<PyBodyArray*>(object)->owner);
+        type->tp_free(object);
+        Py_DECREF(type);
+    }
+
+    PyType_Slot array_slots[] = {
+        {Py_tp_doc, const_cast<char*>("One body array of a World, e.g. World.x, exported through the buffer protocol without copying.\n"
+                                      "Wrap it with numpy.asarray or memoryview. Views stay valid across steps, and creating or\n"
+                                      "destroying bodies raises BufferError until they are released.")},
+        {Py_tp_dealloc, reinterpret_cast<void*>(arrayDealloc)},
+        {Py_tp_repr, reinterpret_cast<void*>(arrayRepr)},
+        {Py_sq_length, reinterpret_cast<void*>(arrayLength)},
+        {Py_bf_getbuffer, reinterpret_cast<void*>(arrayGetBuffer)},
+        {Py_bf_releasebuffer, reinterpret_cast<void*>(arrayReleaseBuffer)},
+        {0, nullptr},
+    };
+
+    PyType_Spec array_spec = {"physics.BodyArray", sizeof(PyBodyArray), 0, Py_TPFLAGS_DEFAULT, array_slots};
+
+    // ======================================================================== //
+    // =================================== World ============================== //
+    // ======================================================================== //
+
+    PyObject* worldNew(PyTypeObject* type, PyObject* args, PyObject* kwargs) {
+        static const char* keywords[] = {"threads", nullptr};
+        unsigned threads = 0;
+        if (!PyArg_ParseTupleAndKeywords(args, kwargs, "|I:World", const_cast<char**>(keywords), &threads)) {
+            return nullptr;
+        }
+        PyWorld* self = reinterpret_cast<PyWorld*>(type->tp_alloc(type, 0));
+        if (!self) {
+            return nullptr;
+        }
+        self->world = new (std::nothrow) world::World(threads ? threads : std::thread::hardware_concurrency());
+        self->exports = 0;
+        self->stepping = false;
+        if (!self->world) {
+            Py_DECREF(self);
+            return PyErr_NoMemory();
+        }
+        return reinterpret_cast<PyObject*>(self);
+    }
+
+    void worldDealloc(PyObject* object) {
+        PyTypeObject* type = Py_TYPE(object);
+        delete reinterpret_cast<PyWorld*>(object)->world;
+        type->tp_free(object);
+        Py_DECREF(type);
+    }
+
+    Py_ssize_t worldLength(PyObject* object) { return static_cast<Py_ssize_t>(reinterpret_cast<PyWorld*>(object)->world->bodies().size()); }
+
+    PyObject* worldCreate(PyObject* object, PyObject* args, PyObject* kwargs) {
+        static const char* keywords[] = {"x", "y", "radius", "mass", "static", "restitution", nullptr};
+        PyWorld* self = reinterpret_cast<PyWorld*>(object);
+        PyObject *x, *y, *radius, *mass;
+        PyObject* is_static = Py_False;
+        PyObject* restitution = nullptr;
+        if (!PyArg_ParseTupleAndKeywords(args, kwargs, "OOOO|OO:create", const_cast<char**>(keywords), &x, &y, &radius, &mass, &is_static, &restitution)) {
+            return nullptr;
+        }
+        if (!checkIdle(self, true)) {
+            return nullptr;
+        }
+
+        // The first array sets the count, numbers are repeated for every body
+        PyObject* inputs[] = {x, y, radius, mass, is_static, restitution ? restitution : Py_None};
+        Py_ssize_t count = -1;
+        for (PyObject* input : inputs) {
+            if (input != Py_None && count < 0) {
+                count = inputLength(input);
+            }
+        }
+        count = count < 0 ? 1 : count;
+
+        std::vector<float> xs, ys, radii, masses, statics, restitutions;
+        if (!readFloats(x, "x", count, xs) || !readFloats(y, "y", count, ys) || !readFloats(radius, "radius", count, radii) ||
+            !readFloats(mass, "mass", count, masses) || !readFloats(is_static, "static", count, statics)) {
+            return nullptr;
+        }
+        if (restitution) {
+            if (!readFloats(restitution, "restitution", count, restitutions)) {
+                return nullptr;
+            }
+        } else {
+            restitutions.assign(count, 1.0f);
+        }
+
+        std::uint64_t* handles;
+        PyObject* result = newArray(count, sizeof(std::uint64_t), "Q", reinterpret_cast<void**>(&handles));
+        if (!result) {
+            return nullptr;
+        }
+        world::BodyStore& store = self->world->bodies();
+        store.reserve(store.size() + count);
+        for (Py_ssize_t i = 0; i < count; i++) {
+            handles[i] = packHandle(store.create(xs[i], ys[i], radii[i], masses[i], statics[i] != 0.0f, restitutions[i]));
+        }
+        return result;
+    }
+
+    PyObject* worldDestroy(PyObject* object, PyObject* handles_object) {
+        PyWorld* self = reinterpret_cast<PyWorld*>(object);
+        std::vector<world::BodyHandle> handles;
+        if (!checkIdle(self, true) || !readHandles(handles_object, handles)) {
+            return nullptr;
+        }
+        world::BodyStore& store = self->world->bodies();
+        if (!checkHandles(store, handles)) {
+            return nullptr;
+        }
+        for (world::BodyHandle handle : handles) {
+            if (store.isValid(handle)) {  // Repeated handles are destroyed once
+                store.destroy(handle);
+            }
+        }
+        Py_RETURN_NONE;
+    }
+
+    PyObject* worldApplyForce(PyObject* object, PyObject* args, PyObject* kwargs) {
+        static const char* keywords[] = {"fx", "fy", "handles", nullptr};
+        PyWorld* self = reinterpret_cast<PyWorld*>(object);
+        PyObject *fx, *fy;
+        PyObject* handles_object = Py_None;
+        if (!PyArg_ParseTupleAndKeywords(args, kwargs, "OO|O:apply_force", const_cast<char**>(keywords), &fx, &fy, &handles_object)) {
+            return nullptr;
+        }
+        if (!checkIdle(self, false)) {
+            return nullptr;
+        }
+        world::BodyStore& store = self->world->bodies();
+        std::vector<world::BodyHandle> handles;
+        if (handles_object != Py_None && (!readHandles(handles_object, handles) || !checkHandles(store, handles))) {
+            return nullptr;
+        }
+        Py_ssize_t count = handles_object != Py_None ? static_cast<Py_ssize_t>(handles.size()) : static_cast<Py_ssize_t>(store.size());
+        std::vector<float> fxs, fys;
+        if (!readFloats(fx, "fx", count, fxs) || !readFloats(fy, "fy", count, fys)) {
+            return nullptr;
+        }
+        for (Py_ssize_t k = 0; k < count; k++) {
+            std::uint32_t i = handles_object != Py_None ? store.indexOf(handles[k]) : static_cast<std::uint32_t>(k);
+            store.applyForce(i, fxs[k], fys[k]);
+        }
+        Py_RETURN_NONE;
+    }
+
+    PyObject* worldStep(PyObject* object, PyObject* args, PyObject* kwargs) {
+        static const char* keywords[] = {"dt", "n", nullptr};
+        PyWorld* self = reinterpret_cast<PyWorld*>(object);
+        float dt;
+        int steps = 1;
+        if (!PyArg_ParseTupleAndKeywords(args, kwargs, "f|i:step", const_cast<char**>(keywords), &dt, &steps)) {
+            return nullptr;
+        }
+        if (!checkIdle(self, false)) {
+            return nullptr;
+        }
+        // Other threads may run Python meanwhile; stepping blocks them from this world's other calls
+        self->stepping = true;
+        world::World* simulation = self->world;
+        // Views write the arrays directly, so the store's change log can't say which bodies they moved
+        if (self->exports > 0) {
+            simulation->bodies().invalidateChanges();
+        }
+        Py_BEGIN_ALLOW_THREADS
+        for (int s = 0; s < steps; s++) {
+            simulation->step(dt);
+        }
+        Py_END_ALLOW_THREADS
+        self->stepping = false;
+        Py_RETURN_NONE;
+    }
+
+    PyObject* worldIndices(PyObject* object, PyObject* handles_object) {
+        PyWorld* self = reinterpret_cast<PyWorld*>(object);
+        std::vector<world::BodyHandle> handles;
+        if (!checkIdle(self, false) || !readHandles(handles_object, handles)) {
+            return nullptr;
+        }
+        const world::BodyStore& store = self->world->bodies();
+        if (!checkHandles(store, handles)) {
+            return nullptr;
+        }
+        std::uint32_t* indices;
+        PyObject* result = newArray(static_cast<Py_ssize_t>(handles.size()), sizeof(std::uint32_t), "I", reinterpret_cast<void**>(&indices));
+        for (std::size_t k = 0; result && k < handles.size(); k++) {
+            indices[k] = store.indexOf(handles[k]);
+        }
+        return result;
+    }
+
+    PyObject* worldHandles(PyObject* object, PyObject*) {
+        PyWorld* self = reinterpret_cast<PyWorld*>(object);
+        if (!checkIdle(self, false)) {
+            return nullptr;
+        }
+        const world::BodyStore& store = self->world->bodies();
+        std::uint64_t* handles;
+        PyObject* result = newArray(static_cast<Py_ssize_t>(store.size()), sizeof(std::uint64_t), "Q", reinterpret_cast<void**>(&handles));
+        for (std::size_t i = 0; result && i < store.size(); i++) {
+            handles[i] = packHandle(store.handleOf(static_cast<std::uint32_t>(i)));
+        }
+        return result;
+    }
+
+    // Adds generator to the world, returning None
+    PyObject* addGenerator(PyWorld* self, forces::ForceGenerator* generator) {
+        if (!checkIdle(self, false)) {
+            delete generator;
+            return nullptr;
+        }
+        self->world->addForceGenerator(std::unique_ptr<forces::ForceGenerator>(generator));
+        Py_RETURN_NONE;
+    }
+
+    PyObject* worldAddGravity(PyObject* object, PyObject* args, PyObject* kwargs) {
+        static const char* keywords[] = {"gx", "gy", nullptr};
+        float gx = 0.0f, gy = -9.81f;
+        if (!PyArg_ParseTupleAndKeywords(args, kwargs, "|ff:add_gravity", const_cast<char**>(keywords), &gx, &gy)) {
+            return nullptr;
+        }
+        return addGenerator(reinterpret_cast<PyWorld*>(object), new forces::UniformGravity(gx, gy));
+    }
+
+    PyObject* worldAddDrag(PyObject* object, PyObject* args, PyObject* kwargs) {
+        static const char* keywords[] = {"linear", "quadratic", nullptr};
+        float linear = 0.1f, quadratic = 0.0f;
+        if (!PyArg_ParseTupleAndKeywords(args, kwargs, "|ff:add_drag", const_cast<char**>(keywords), &linear, &quadratic)) {
+            return nullptr;
+        }
+        return addGenerator(reinterpret_cast<PyWorld*>(object), new forces::Drag(linear, quadratic));
+    }
+
+    PyObject* worldAddMutualGravity(PyObject* object, PyObject* args, PyObject* kwargs) {
+        static const char* keywords[] = {"constant", "opening_angle", "softening", "exact", nullptr};
+        float constant = 1.0f, opening_angle = 0.5f, softening = 0.01f;
+        int exact = 0;
+        if (!PyArg_ParseTupleAndKeywords(args, kwargs, "|fffp:add_mutual_gravity", const_cast<char**>(keywords), &constant, &opening_angle, &softening, &exact)) {
+            return nullptr;
+        }
+        forces::MutualGravity::Method method = exact ? forces::MutualGravity::Method::Exact : forces::MutualGravity::Method::BarnesHut;
+        return addGenerator(reinterpret_cast<PyWorld*>(object), new forces::MutualGravity(constant, opening_angle, softening, method));
+    }
+
+    PyObject* worldClearForceGenerators(PyObject* object, PyObject*) {
+        PyWorld* self = reinterpret_cast<PyWorld*>(object);
+        if (!checkIdle(self, false)) {
+            return nullptr;
+        }
+        self->world->clearForceGenerators();
+        Py_RETURN_NONE;
+    }
+
+    PyObject* worldSaveSnapshot(PyObject* object, PyObject* args) {
+        PyWorld* self = reinterpret_cast<PyWorld*>(object);
+        PyObject* path;
+        if (!PyArg_ParseTuple(args, "O&:save_snapshot", PyUnicode_FSConverter, &path)) {
+            return nullptr;
+        }
+        bool saved = checkIdle(self, false) && self->world->saveSnapshot(PyBytes_AS_STRING(path));
+        Py_DECREF(path);
+        if (!saved && !PyErr_Occurred()) {
+            PyErr_SetString(PyExc_OSError, "could not write the snapshot");
+        }
+        return saved ? Py_NewRef(Py_None) : nullptr;
+    }
+
+    PyObject* worldLoadSnapshot(PyObject* object, PyObject* args) {
+        PyWorld* self = reinterpret_cast<PyWorld*>(object);
+        PyObject* path;
+        if (!PyArg_ParseTuple(args, "O&:load_snapshot", PyUnicode_FSConverter, &path)) {
+            return nullptr;
+        }
+        bool loaded = checkIdle(self, true) && self->world->loadSnapshot(PyBytes_AS_STRING(path));
+        Py_DECREF(path);
+        if (!loaded && !PyErr_Occurred()) {
+            PyErr_SetString(PyExc_OSError, "could not read the snapshot, or it is not a valid one");
+        }
+        return loaded ? Py_NewRef(Py_None) : nullptr;
+    }
+
+    PyObject* worldGetArray(PyObject* object, void* closure) {
+        PyBodyArray* array = PyObject_New(PyBodyArray, reinterpret_cast<PyTypeObject*>(array_type));
+        if (!array) {
+            return nullptr;
+        }
+        Py_INCREF(object);
+        array->owner = reinterpret_cast<PyWorld*>(object);
+        array->field = static_cast<int>(reinterpret_cast<std::intptr_t>(closure));
+        array->shape = 0;
+        return reinterpret_cast<PyObject*>(array);
+    }
+
+    PyObject* worldGetThreads(PyObject* object, void*) { return PyLong_FromUnsignedLong(reinterpret_cast<PyWorld*>(object)->world->threadCount()); }
+
+    int worldSetThreads(PyObject* object, PyObject* value, void*) {
+        PyWorld* self = reinterpret_cast<PyWorld*>(object);
+        unsigned long threads = value ? PyLong_AsUnsignedLong(value) : 0;
+        if (!value || (threads == static_cast<unsigned long>(-1) && PyErr_Occurred()) || threads == 0) {
+            PyErr_Clear();
+            PyErr_SetString(PyExc_ValueError, "threads must be a positive integer");
+            return -1;
+        }
+        if (!checkIdle(self, false)) {
+            return -1;
+        }
+        self->world->setThreadCount(static_cast<unsigned>(threads));
+        return 0;
+    }
+
+    PyObject* worldGetSleeping(PyObject* object, void*) { return PyBool_FromLong(reinterpret_cast<PyWorld*>(object)->world->sleepSettings().enabled); }
+
+    int worldSetSleeping(PyObject* object, PyObject* value, void*) {
+        PyWorld* self = reinterpret_cast<PyWorld*>(object);
+        int enabled = value ? PyObject_IsTrue(value) : -1;
+        if (enabled < 0) {
+            if (!value) {
+                PyErr_SetString(PyExc_AttributeError, "sleeping can't be deleted");
+            }
+            return -1;
+        }
+        if (!checkIdle(self, false)) {
+            return -1;
+        }
+        self->world->sleepSettings().enabled = enabled != 0;
+        return 0;
+    }
+
+    PyMethodDef world_methods[] = {
+        {"create", reinterpret_cast<PyCFunction>(reinterpret_cast<void (*)()>(worldCreate)), METH_VARARGS | METH_KEYWORDS,
+         "create(x, y, radius, mass, static=False, restitution=1.0)\n--\n\n"
+         "Creates one body per element and returns their handles as a uint64 array. Each argument is a\n"
+         "float32/float64 array, a sequence, or a number used for every body."},
+        {"destroy", worldDestroy, METH_O,
+         "destroy(handles)\n--\n\n"
+         "Destroys the bodies of handles. Raises ValueError, destroying nothing, if any is stale.\n"
+         "Moves other bodies to new indices."},
+        {"apply_force", reinterpret_cast<PyCFunction>(reinterpret_cast<void (*)()>(worldApplyForce)), METH_VARARGS | METH_KEYWORDS,
+         "apply_force(fx, fy, handles=None)\n--\n\n"
+         "Adds force to each body of handles, or to every body in index order when handles is None,\n"
+         "for the next step only. Wakes sleeping bodies; static ones are left alone."},
+        {"step", reinterpret_cast<PyCFunction>(reinterpret_cast<void (*)()>(worldStep)), METH_VARARGS | METH_KEYWORDS,
+         "step(dt, n=1)\n--\n\n"
+         "Runs n steps of dt seconds natively, with the GIL released."},
+        {"indices", worldIndices, METH_O,
+         "indices(handles)\n--\n\n"
+         "Current array index of each handle as a uint32 array, for indexing the body arrays."},
+        {"handles", worldHandles, METH_NOARGS,
+         "handles()\n--\n\n"
+         "Handle of every body in index order as a uint64 array."},
+        {"add_gravity", reinterpret_cast<PyCFunction>(reinterpret_cast<void (*)()>(worldAddGravity)), METH_VARARGS | METH_KEYWORDS,
+         "add_gravity(gx=0.0, gy=-9.81)\n--\n\nAdds a uniform gravity force generator."},
+        {"add_drag", reinterpret_cast<PyCFunction>(reinterpret_cast<void (*)()>(worldAddDrag)), METH_VARARGS | METH_KEYWORDS,
+         "add_drag(linear=0.1, quadratic=0.0)\n--\n\nAdds a drag force generator, f = -(linear + quadratic * |v|) v."},
+        {"add_mutual_gravity", reinterpret_cast<PyCFunction>(reinterpret_cast<void (*)()>(worldAddMutualGravity)), METH_VARARGS | METH_KEYWORDS,
+         "add_mutual_gravity(constant=1.0, opening_angle=0.5, softening=0.01, exact=False)\n--\n\n"
+         "Adds N-body attraction, Barnes-Hut unless exact."},
+        {"clear_force_generators", worldClearForceGenerators, METH_NOARGS, "Removes every force generator."},
+        {"save_snapshot", worldSaveSnapshot, METH_VARARGS, "save_snapshot(path)\n--\n\nWrites every body to a binary snapshot."},
+        {"load_snapshot", worldLoadSnapshot, METH_VARARGS,
+         "load_snapshot(path)\n--\n\nReplaces every body with those of a snapshot, invalidating earlier handles."},
+        {nullptr, nullptr, 0, nullptr},
+    };
+
+    // Closures carry the Field of each array attribute
+    #define BODY_ARRAY(name, field, doc) {name, worldGetArray, nullptr, const_cast<char*>(doc), reinterpret_cast<void*>(field)}
+    PyGetSetDef world_getset[] = {
+        BODY_ARRAY("x", FIELD_X, "Position x of every body, a writable float32 BodyArray."),
+        BODY_ARRAY("y", FIELD_Y, "Position y of every body, a writable float32 BodyArray."),
+        BODY_ARRAY("vx", FIELD_VX, "Velocity x of every body, a writable float32 BodyArray."),
+        BODY_ARRAY("vy", FIELD_VY, "Velocity y of every body, a writable float32 BodyArray."),
+        BODY_ARRAY("fx", FIELD_FX, "Force x applied for the next step, a writable float32 BodyArray."),
+        BODY_ARRAY("fy", FIELD_FY, "Force y applied for the next step, a writable float32 BodyArray."),
+        BODY_ARRAY("mass", FIELD_MASS, "Mass of every body, a read-only float32 BodyArray."),
+        BODY_ARRAY("radius", FIELD_RADIUS, "Radius of every body, a read-only float32 BodyArray."),
+        {"threads", worldGetThreads, worldSetThreads, const_cast<char*>("Threads used by step, including the calling one."), nullptr},
+        {"sleeping", worldGetSleeping, worldSetSleeping,
+         const_cast<char*>("Whether resting islands go to sleep. Writes through the arrays don't wake bodies,\n"
+                           "so turn it off when moving bodies that way."), nullptr},
+        {nullptr, nullptr, nullptr, nullptr, nullptr},
+    };
+    #undef BODY_ARRAY
+
+    PyType_Slot world_slots[] = {
+        {Py_tp_doc, const_cast<char*>("World(threads=0)\n--\n\n"
+                                      "A physics world stepped natively on the given number of threads (0 for one per core), whose\n"
+                                      "body arrays are exposed without copying as x, y, vx, vy, fx, fy, mass and radius.")},
+        {Py_tp_new, reinterpret_cast<void*>(worldNew)},
+        {Py_tp_dealloc, reinterpret_cast<void*>(worldDealloc)},
+        {Py_tp_methods, world_methods},
+        {Py_tp_getset, world_getset},
+        {Py_sq_length, reinterpret_cast<void*>(worldLength)},
+        {0, nullptr},
+    };
+
+    PyType_Spec world_spec = {"physics.World", sizeof(PyWorld), 0, Py_TPFLAGS_DEFAULT, world_slots};
+
+    PyModuleDef module_def = {
+        PyModuleDef_HEAD_INIT, "physics", "Bindings to the physics engine: a World with zero-copy views of its body arrays.",
+        -1, nullptr, nullptr, nullptr, nullptr, nullptr,
+    };
+
+}
+
+PyMODINIT_FUNC PyInit_physics() {
+    PyObject* module = PyModule_Create(&module_def);
+    if (!module) {
+        return nullptr;
+    }
+    world_type = PyType_FromSpec(&world_spec);
+    array_type = PyType_FromSpec(&array_spec);
+    if (!world_type || !array_type || PyModule_AddObjectRef(module, "World", world_type) < 0 ||
+        PyModule_AddObjectRef(module, "BodyArray", array_type) < 0) {
+        Py_DECREF(module);
+        return nullptr;
+    }
+    return module;
+}
@@ -0,0 +1,687 @@
+#include "aabb_tree.h"
+#include <algorithm>
+#include <cmath>
+
+namespace broadphase {
+
+    // ======================================================================== //
+    // ============================= Node Management ========================== //
+    // ======================================================================== //
+    int DynamicAabbTree::allocateNode() {
+        int node;
+        if (free_list != NULL_NODE) {
+            node = free_list;
+            free_list = nodes[node].parent;
+        } else {
+            node = static_cast<int>(nodes.size());
+            nodes.push_back(Node());
+        }
+        nodes[node].parent = NULL_NODE;
+        nodes[node].child1 = NULL_NODE;
+        nodes[node].child2 = NULL_NODE;
+        nodes[node].height = 0;
+        nodes[node].user_data = 0;
+        return node;
+    }
+
+    void DynamicAabbTree::freeNode(int node) {
+        nodes[node].parent = free_list;
+        nodes[node].height = -1;
+        free_list = node;
+    }
+
+    // ======================================================================== //
+    // ============================= Proxy Management ========================= //
+    // ======================================================================== //
+    int DynamicAabbTree::insert(const Aabb& box, std::uint32_t user_data) {
+        int proxy = allocateNode();
+        nodes[proxy].box = box;
+        nodes[proxy].user_data = user_data;
+        insertLeaf(proxy);
+        leaf_count++;
+        changes++;
+        return proxy;
+    }
+
+    void DynamicAabbTree::insert(const Aabb* boxes, const std::uint32_t* user_data, std::size_t count, int* proxies) {
+        if (count < (leaf_count + 3) / 4) {
+            for (std::size_t i = 0; i < count; i++) {
+                proxies[i] = insert(boxes[i], user_data[i]);
+            }
+            return;
+        }
+        // Leaves are left unlinked, the rebuild places them with the rest
+        for (std::size_t i = 0; i < count; i++) {
+            int proxy = allocateNode();
+            nodes[proxy].box = boxes[i];
+            nodes[proxy].user_data = user_data[i];
+            proxies[i] = proxy;
+        }
+        leaf_count += count;
+        rebuild();
+    }
+
+    void DynamicAabbTree::remove(int proxy) {
+        removeLeaf(proxy);
+        freeNode(proxy);
+        leaf_count--;
+        changes++;
+    }
+
+    void DynamicAabbTree::update(int proxy, const Aabb& box) {
+        removeLeaf(proxy);
+        nodes[proxy].box = box;
+        insertLeaf(proxy);
+        changes++;
+    }
+
+    void DynamicAabbTree::clear() {
+        nodes.clear();
+        root = NULL_NODE;
+        free_list = NULL_NODE;
+        leaf_count = 0;
+        built_cost = 0.0f;
+        changes = 0;
+    }
+
+    void DynamicAabbTree::insertLeaf(int leaf) {
+        if (root == NULL_NODE) {
+            root = leaf;
+            nodes[root].parent = NULL_NODE;
+            return;
+        }
+
+        /* Descend towards the cheapest sibling. Cost is measured in perimeter:
+        pairing the leaf with a node creates a parent covering both, and every
+        ancestor above grows ("inheritance") by the same amount.*/
+        const Aabb leaf_box = nodes[leaf].box;
+        int index = root;
+        while (!nodes[index].isLeaf()) {
+            const Node& node = nodes[index];
+            float area = node.box.perimeter();
+            float combined = Aabb::merge(node.box, leaf_box).perimeter();
+            float cost = 2.0f * combined;
+            float inheritance = 2.0f * (combined - area);
+
+            float child_cost[2];
+            int children[2] = {node.child1, node.child2};
+            for (int c = 0; c < 2; c++) {
+                const Node& child = nodes[children[c]];
+                float merged = Aabb::merge(leaf_box, child.box).perimeter();
+                child_cost[c] = child.isLeaf() ? merged + inheritance : (merged - child.box.perimeter()) + inheritance;
+            }
+
+            if (cost < child_cost[0] && cost < child_cost[1]) {
+                break;
+            }
+            index = child_cost[0] < child_cost[1] ? children[0] : children[1];
+        }
+        int sibling = index;
+
+        // Create a new parent for the leaf and its sibling
+        int old_parent = nodes[sibling].parent;
+        int new_parent = allocateNode();
+        nodes[new_parent].parent = old_parent;
+        nodes[new_parent].box = Aabb::merge(leaf_box, nodes[sibling].box);
+        nodes[new_parent].height = nodes[sibling].height + 1;
+        nodes[new_parent].child1 = sibling;
+        nodes[new_parent].child2 = leaf;
+        nodes[sibling].parent = new_parent;
+        nodes[leaf].parent = new_parent;
+
+        if (old_parent != NULL_NODE) {
+            if (nodes[old_parent].child1 == sibling) {
+                nodes[old_parent].child1 = new_parent;
+            } else {
+                nodes[old_parent].child2 = new_parent;
+            }
+        } else {
+            root = new_parent;
+        }
+
+        // Walk back up fixing heights and boxes, rebalancing as we go
+        index = nodes[leaf].parent;
+        while (index != NULL_NODE) {
+            index = balance(index);
+            Node& node = nodes[index];
+            node.height = 1 + std::max(nodes[node.child1].height, nodes[node.child2].height);
+            node.box = Aabb::merge(nodes[node.child1].box, nodes[node.child2].box);
+            index = node.parent;
+        }
+    }
+
+    void DynamicAabbTree::removeLeaf(int leaf) {
+        if (leaf == root) {
+            root = NULL_NODE;
+            return;
+        }
+
+        int parent = nodes[leaf].parent;
+        int grand_parent = nodes[parent].parent;
+        int sibling = nodes[parent].child1 == leaf ? nodes[parent].child2 : nodes[parent].child1;
+
+        if (grand_parent != NULL_NODE) {
+            // Splice the sibling into the parent's place
+            if (nodes[grand_parent].child1 == parent) {
+                nodes[grand_parent].child1 = sibling;
+            } else {
+                nodes[grand_parent].child2 = sibling;
+            }
+            nodes[sibling].parent = grand_parent;
+            freeNode(parent);
+
+            int index = grand_parent;
+            while (index != NULL_NODE) {
+                index = balance(index);
+                Node& node = nodes[index];
+                node.height = 1 + std::max(nodes[node.child1].height, nodes[node.child2].height);
+                node.box = Aabb::merge(nodes[node.child1].box, nodes[node.child2].box);
+                index = node.parent;
+            }
+        } else {
+            root = sibling;
+            nodes[sibling].parent = NULL_NODE;
+            freeNode(parent);
+        }
+    }
+
+    /* Rotate the taller grandchild of a into a's place if a's subtrees differ in
+    height by more than one. Returns the index of the subtree root afterwards.
+          a                c
+         / \              / \
+        b   c     ->     a   f   (or g, whichever is taller)
+           / \          / \
+          f   g        b   g
+    */
+    int DynamicAabbTree::balance(int a_index) {
+        Node& a = nodes[a_index];
+        if (a.isLeaf() || a.height < 2) {
+            return a_index;
+        }
+
+        int b_index = a.child1;
+        int c_index = a.child2;
+        Node& b = nodes[b_index];
+        Node& c = nodes[c_index];
+        int difference = c.height - b.height;
+
+        if (difference > 1) {
+            // Rotate c up
+            int f_index = c.child1;
+            int g_index = c.child2;
+            Node& f = nodes[f_index];
+            Node& g = nodes[g_index];
+
+            c.child1 = a_index;
+            c.parent = a.parent;
+            a.parent = c_index;
+            if (c.parent != NULL_NODE) {
+                if (nodes[c.parent].child1 == a_index) {
+                    nodes[c.parent].child1 = c_index;
+                } else {
+                    nodes[c.parent].child2 = c_index;
+                }
+            } else {
+                root = c_index;
+            }
+
+            if (f.height > g.height) {
+                c.child2 = f_index;
+                a.child2 = g_index;
+                g.parent = a_index;
+                a.box = Aabb::merge(b.box, g.box);
+                c.box = Aabb::merge(a.box, f.box);
+                a.height = 1 + std::max(b.height, g.height);
+                c.height = 1 + std::max(a.height, f.height);
+            } else {
+                c.child2 = g_index;
+                a.child2 = f_index;
+                f.parent = a_index;
+                a.box = Aabb::merge(b.box, f.box);
+                c.box = Aabb::merge(a.box, g.box);
+                a.height = 1 + std::max(b.height, f.height);
+                c.height = 1 + std::max(a.height, g.height);
+            }
+            return c_index;
+        }
+
+        if (difference < -1) {
+            // Rotate b up
+            int d_index = b.child1;
+            int e_index = b.child2;
+            Node& d = nodes[d_index];
+            Node& e = nodes[e_index];
+
+            b.child1 = a_index;
+            b.parent = a.parent;
+            a.parent = b_index;
+            if (b.parent != NULL_NODE) {
+                if (nodes[b.parent].child1 == a_index) {
+                    nodes[b.parent].child1 = b_index;
+                } else {
+                    nodes[b.parent].child2 = b_index;
+                }
+            } else {
+                root = b_index;
+            }
+
+            if (d.height > e.height) {
+                b.child2 = d_index;
+                a.child1 = e_index;
+                e.parent = a_index;
+                a.box = Aabb::merge(c.box, e.box);
+                b.box = Aabb::merge(a.box, d.box);
+                a.height = 1 + std::max(c.height, e.height);
+                b.height = 1 + std::max(a.height, d.height);
+            } else {
+                b.child2 = e_index;
+                a.child1 = d_index;
+                d.parent = a_index;
+                a.box = Aabb::merge(c.box, d.box);
+                b.box = Aabb::merge(a.box, e.box);
+                a.height = 1 + std::max(c.height, d.height);
+                b.height = 1 + std::max(a.height, e.height);
+            }
+            return b_index;
+        }
+
+        return a_index;
+    }
+
+    // ======================================================================== //
+    // ================================= Rebuilds ============================= //
+    // ======================================================================== //
+    void DynamicAabbTree::rebuild() {
+        // Keep the leaves (their ids are the proxies) and free every internal node
+        build_leaves.clear();
+        for (std::size_t i = 0; i < nodes.size(); i++) {
+            if (nodes[i].height == 0) {
+                build_leaves.push_back(static_cast<int>(i));
+            } else if (nodes[i].height > 0) {
+                freeNode(static_cast<int>(i));
+            }
+        }
+        changes = 0;
+        if (build_leaves.empty()) {
+            root = NULL_NODE;
+            built_cost = 0.0f;
+            return;
+        }
+
+        /* Split ranges of leaves top-down. Each internal node is allocated before
+        its children, so walking build_order backwards visits children first.*/
+        build_order.clear();
+        build_tasks.clear();
+        build_tasks.push_back(BuildTask{0, static_cast<std::uint32_t>(build_leaves.size()), NULL_NODE});
+        while (!build_tasks.empty()) {
+            BuildTask task = build_tasks.back();
+            build_tasks.pop_back();
+
+            int node;
+            if (task.end - task.begin == 1) {
+                node = build_leaves[task.begin];
+            } else {
+                node = allocateNode();
+                build_order.push_back(node);
+                std::uint32_t middle = split(task.begin, task.end);
+                build_tasks.push_back(BuildTask{middle, task.end, node});
+                build_tasks.push_back(BuildTask{task.begin, middle, node});
+            }
+
+            // Children are created child1 first (the task pushed last), then child2
+            nodes[node].parent = task.node;
+            if (task.node == NULL_NODE) {
+                root = node;
+            } else if (nodes[task.node].child1 == NULL_NODE) {
+                nodes[task.node].child1 = node;
+            } else {
+                nodes[task.node].child2 = node;
+            }
+        }
+
+        for (std::size_t i = build_order.size(); i-- > 0;) {
+            Node& node = nodes[build_order[i]];
+            node.height = 1 + std::max(nodes[node.child1].height, nodes[node.child2].height);
+            node.box = Aabb::merge(nodes[node.child1].box, nodes[node.child2].box);
+        }
+        built_cost = cost();
+    }
+
+    /* Binned SAH split along the axis where the box centres spread the most: the
+    centres are dropped into BUILD_BINS equal slices and the plane between two
+    slices with the least (left perimeter * left count + right perimeter *
+    right count) wins. Falls back to halving by count when every centre is in
+    one slice, so a range always shrinks.*/
+    std::uint32_t DynamicAabbTree::split(std::uint32_t begin, std::uint32_t end) {
+        float lower[2] = {INFINITY, INFINITY};
+        float upper[2] = {-INFINITY, -INFINITY};
+        for (std::uint32_t i = begin; i < end; i++) {
+            const Aabb& box = nodes[build_leaves[i]].box;
+            float centre[2] = {box.min_x + box.max_x, box.min_y + box.max_y};  // doubled, only compared
+            for (int axis = 0; axis < 2; axis++) {
+                lower[axis] = std::min(lower[axis], centre[axis]);
+                upper[axis] = std::max(upper[axis], centre[axis]);
+            }
+        }
+        const int axis = upper[0] - lower[0] >= upper[1] - lower[1] ? 0 : 1;
+        const float extent = upper[axis] - lower[axis];
+        auto centreOf = [&](int leaf) {
+            const Aabb& box = nodes[leaf].box;
+            return axis == 0 ? box.min_x + box.max_x : box.min_y + box.max_y;
+        };
+
+        std::uint32_t middle = begin + (end - begin) / 2;
+        if (extent > 0.0f) {
+            const float scale = BUILD_BINS / extent;
+            auto binOf = [&](int leaf) { return std::min(BUILD_BINS - 1, static_cast<int>((centreOf(leaf) - lower[axis]) * scale)); };
+
+            Aabb bin_box[BUILD_BINS];
+            std::uint32_t bin_count[BUILD_BINS] = {};
+            for (std::uint32_t i = begin; i < end; i++) {
+                int bin = binOf(build_leaves[i]);
+                const Aabb& box = nodes[build_leaves[i]].box;
+                bin_box[bin] = bin_count[bin]++ == 0 ? box : Aabb::merge(bin_box[bin], box);
+            }
+
+            // Cost of everything left of each plane, then sweep from the right to compare
+            float left_cost[BUILD_BINS];
+            Aabb running;
+            std::uint32_t running_count = 0;
+            for (int bin = 0; bin < BUILD_BINS - 1; bin++) {
+                if (bin_count[bin] > 0) {
+                    running = running_count == 0 ? bin_box[bin] : Aabb::merge(running, bin_box[bin]);
+                    running_count += bin_count[bin];
+                }
+                left_cost[bin] = running_count == 0 ? INFINITY : running.perimeter() * running_count;
+            }
+            int best_plane = -1;
+            float best_cost = INFINITY;
+            running_count = 0;
+            for (int bin = BUILD_BINS - 1; bin > 0; bin--) {
+                if (bin_count[bin] > 0) {
+                    running = running_count == 0 ? bin_box[bin] : Aabb::merge(running, bin_box[bin]);
+                    running_count += bin_count[bin];
+                }
+                float plane_cost = running_count == 0 ? INFINITY : left_cost[bin - 1] + running.perimeter() * running_count;
+                if (plane_cost < best_cost) {
+                    best_cost = plane_cost;
+                    best_plane = bin;
+                }
+            }
+
+            if (best_plane > 0) {
+                int* first = build_leaves.data() + begin;
+                int* partitioned = std::partition(first, build_leaves.data() + end, [&](int leaf) { return binOf(leaf) < best_plane; });
+                std::uint32_t candidate = static_cast<std::uint32_t>(partitioned - build_leaves.data());
+                if (candidate > begin && candidate < end) {
+                    return candidate;
+                }
+            }
+        }
+
+        // Coincident centres (or no useful plane): median by count
+        std::nth_element(build_leaves.data() + begin, build_leaves.data() + middle, build_leaves.data() + end,
+                         [&](int a, int b) { return centreOf(a) < centreOf(b); });
+        return middle;
+    }
+
+    bool DynamicAabbTree::rebuildIfDegraded() {
+        if (root == NULL_NODE || changes < leaf_count / 2) {
+            return false;
+        }
+        float current = cost();
+        if (current <= built_cost * REBUILD_COST_RATIO) {
+            changes = 0;  // still good, check again after another half tree of changes
+            return false;
+        }
+        rebuild();
+        return true;
+    }
+
+    float DynamicAabbTree::cost() const {
+        if (root == NULL_NODE || nodes[root].isLeaf()) {
+            return 0.0f;
+        }
+        double total = 0.0;
+        for (const Node& node : nodes) {
+            if (node.height > 0) {
+                total += node.box.perimeter();
+            }
+        }
+        return static_cast<float>(total / nodes[root].box.perimeter());
+    }
+
+    // ======================================================================== //
+    // ================================= Queries ============================== //
+    // ======================================================================== //
+    bool DynamicAabbTree::rayHitsBox(const Aabb& box, float origin_x, float origin_y, float dir_x, float dir_y, float max_t) {
+        float t_min = 0.0f;
+        float t_max = max_t;
+        const float origin[2] = {origin_x, origin_y};
+        const float dir[2] = {dir_x, dir_y};
+        const float lower[2] = {box.min_x, box.min_y};
+        const float upper[2] = {box.max_x, box.max_y};
+        for (int axis = 0; axis < 2; axis++) {
+            if (dir[axis] == 0.0f) {
+                // Parallel to this slab, must already be inside it
+                if (origin[axis] < lower[axis] || origin[axis] > upper[axis]) {
+                    return false;
+                }
+                continue;
+            }
+            float inv = 1.0f / dir[axis];
+            float t1 = (lower[axis] - origin[axis]) * inv;
+            float t2 = (upper[axis] - origin[axis]) * inv;
+            if (t1 > t2) {
+                std::swap(t1, t2);
+            }
+            t_min = std::max(t_min, t1);
+            t_max = std::min(t_max, t2);
+            if (t_min > t_max) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // ======================================================================== //
+    // ============================ Tree Broad-phase ========================== //
+    // ======================================================================== //
+    TreeBroadPhase::TreeBroadPhase(float margin) : margin(margin) {}
+
+    void TreeBroadPhase::Batch::insertInto(DynamicAabbTree& tree, std::vector<Proxy>& proxies) {
+        nodes.resize(boxes.size());
+        tree.insert(boxes.data(), slots.data(), boxes.size(), nodes.data());
+        for (std::size_t i = 0; i < slots.size(); i++) {
+            proxies[slots[i]].node = nodes[i];
+        }
+        boxes.clear();
+        slots.clear();
+    }
+
+    void TreeBroadPhase::sync(const world::BodyStore& bodies) {
+        const std::uint32_t count = static_cast<std::uint32_t>(bodies.size());
+        const std::uint32_t* flags = bodies.flags();
+        syncs++;
+
+        if (syncs == 1 || synced_to < bodies.changesFrom()) {
+            // Changes were missed (first sync, or bodies written through the arrays): check every body
+            for (std::uint32_t slot = 0; slot < proxies.size(); slot++) {
+                Proxy& proxy = proxies[slot];
+                if (proxy.node != DynamicAabbTree::NULL_NODE && !bodies.isValid(world::BodyHandle{slot, proxy.generation})) {
+                    (proxy.is_static ? static_tree : dynamic_tree).remove(proxy.node);
+                    proxy.node = DynamicAabbTree::NULL_NODE;
+                }
+            }
+            for (std::uint32_t i = 0; i < count; i++) {
+                syncBody(bodies, bodies.handleOf(i));
+            }
+        } else {
+            // Bodies created, destroyed or moved since the last sync, then everything integration can have moved
+            const std::vector<world::BodyHandle>& changes = bodies.changes();
+            for (std::size_t c = synced_to - bodies.changesFrom(); c < changes.size(); c++) {
+                syncBody(bodies, changes[c]);
+            }
+            moving.clear();
+            dynamic_tree.forEachLeaf([&](int node) {
+                std::uint32_t slot = dynamic_tree.userData(node);
+                if (!(flags[bodies.indexOf(world::BodyHandle{slot, proxies[slot].generation})] & world::BODY_INACTIVE)) {
+                    moving.push_back(slot);
+                }
+            });
+            for (std::uint32_t slot : moving) {
+                syncBody(bodies, world::BodyHandle{slot, proxies[slot].generation});
+            }
+        }
+        synced_to = bodies.changesEnd();
+
+        static_batch.insertInto(static_tree, proxies);
+        dynamic_batch.insertInto(dynamic_tree, proxies);
+        rebuilds += static_tree.rebuildIfDegraded();
+        rebuilds += dynamic_tree.rebuildIfDegraded();
+    }
+
+    void TreeBroadPhase::syncBody(const world::BodyStore& bodies, world::BodyHandle handle) {
+        if (handle.index >= proxies.size()) {
+            proxies.resize(handle.index + 1);
+        }
+        Proxy& proxy = proxies[handle.index];
+        if (proxy.visited == syncs) {
+            return;
+        }
+
+        // Drop the proxy of a destroyed body, including one whose slot a new body reuses
+        if (proxy.node != DynamicAabbTree::NULL_NODE && !bodies.isValid(world::BodyHandle{handle.index, proxy.generation})) {
+            (proxy.is_static ? static_tree : dynamic_tree).remove(proxy.node);
+            proxy.node = DynamicAabbTree::NULL_NODE;
+        }
+        if (!bodies.isValid(handle)) {
+            return;
+        }
+        proxy.visited = syncs;
+
+        const std::uint32_t i = bodies.indexOf(handle);
+        const float x = bodies.x()[i];
+        const float y = bodies.y()[i];
+        const float r = bodies.radius()[i];
+        bool is_static = (bodies.flags()[i] & world::BODY_STATIC) != 0;
+        Aabb tight{x - r, y - r, x + r, y + r};
+
+        if (proxy.node != DynamicAabbTree::NULL_NODE && proxy.is_static == is_static) {
+            // Still inside its fat box: nothing to do, the common case
+            if ((is_static ? static_tree : dynamic_tree).box(proxy.node).contains(tight)) {
+                return;
+            }
+        }
+
+        float grow = margin * r;
+        Aabb fat{tight.min_x - grow, tight.min_y - grow, tight.max_x + grow, tight.max_y + grow};
+        if (proxy.node != DynamicAabbTree::NULL_NODE) {
+            if (proxy.is_static == is_static) {
+                (is_static ? static_tree : dynamic_tree).update(proxy.node, fat);
+                refits++;
+                return;
+            }
+            // Switched between static and dynamic, move it to the other tree
+            (proxy.is_static ? static_tree : dynamic_tree).remove(proxy.node);
+            proxy.node = DynamicAabbTree::NULL_NODE;
+        }
+        Batch& batch = is_static ? static_batch : dynamic_batch;
+        batch.boxes.push_back(fat);
+        batch.slots.push_back(handle.index);
+        proxy.generation = handle.generation;
+        proxy.is_static = is_static;
+    }
+
+    void TreeBroadPhase::findPairs(const world::BodyStore& bodies, std::vector<BodyPair>& pairs) {
+        pairs.clear();
+        counters.queries++;
+        sync(bodies);
+
+        const float* x = bodies.x();
+        const float* y = bodies.y();
+        const float* r = bodies.radius();
+        const std::uint32_t* flags = bodies.flags();
+
+        /* Only awake dynamic bodies go looking for partners; static and sleeping ones
+        are found from the other side. They query in the dynamic tree's leaf order,
+        so consecutive queries walk the same nodes while they are still in cache.*/
+        query_order.clear();
+        dynamic_tree.forEachLeaf([&](int node) {
+            std::uint32_t slot = dynamic_tree.userData(node);
+            std::uint32_t i = bodies.indexOf(world::BodyHandle{slot, proxies[slot].generation});
+            if (!(flags[i] & world::BODY_INACTIVE)) {
+                query_order.push_back(i);
+            }
+        });
+        emitChunked(query_order.size(), 512, pairs, [&](std::size_t begin, std::size_t end, std::vector<BodyPair>& out, std::uint64_t& tested) {
+            for (std::size_t q = begin; q < end; q++) {
+                const std::uint32_t i = query_order[q];
+                Aabb tight{x[i] - r[i], y[i] - r[i], x[i] + r[i], y[i] + r[i]};
+
+                auto test = [&](int node, const DynamicAabbTree& tree, bool dynamic) {
+                    std::uint32_t slot = tree.userData(node);
+                    std::uint32_t j = bodies.indexOf(world::BodyHandle{slot, proxies[slot].generation});
+                    // Each awake pair is seen from both sides, keep the one from the lower index
+                    if (dynamic && j <= i && !(flags[j] & world::BODY_SLEEPING)) {
+                        return true;
+                    }
+                    tested++;
+                    if (std::fabs(x[i] - x[j]) <= r[i] + r[j] && std::fabs(y[i] - y[j]) <= r[i] + r[j]) {
+                        out.push_back(i < j ? BodyPair{i, j} : BodyPair{j, i});
+                    }
+                    return true;
+                };
+                dynamic_tree.query(tight, [&](int node) { return test(node, dynamic_tree, true); });
+                static_tree.query(tight, [&](int node) { return test(node, static_tree, false); });
+            }
+        });
+        counters.pairs_overlapping += pairs.size();
+    }
+
+    void TreeBroadPhase::queryRegion(const world::BodyStore& bodies, const Aabb& region, std::vector<std::uint32_t>& found) {
+        found.clear();
+        sync(bodies);
+
+        auto collect = [&](const DynamicAabbTree& tree, int node) {
+            std::uint32_t slot = tree.userData(node);
+            std::uint32_t i = bodies.indexOf(world::BodyHandle{slot, proxies[slot].generation});
+            if (circleOverlapsAabb(bodies.x()[i], bodies.y()[i], bodies.radius()[i], region)) {
+                found.push_back(i);
+            }
+            return true;
+        };
+        static_tree.query(region, [&](int node) { return collect(static_tree, node); });
+        dynamic_tree.query(region, [&](int node) { return collect(dynamic_tree, node); });
+    }
+
+    bool TreeBroadPhase::rayCast(const world::BodyStore& bodies, float origin_x, float origin_y, float dir_x, float dir_y, float max_t, RayHit& hit) {
+        sync(bodies);
+
+        bool any = false;
+        auto clip = [&](const DynamicAabbTree& tree, int node, float limit) {
+            std::uint32_t slot = tree.userData(node);
+            std::uint32_t i = bodies.indexOf(world::BodyHandle{slot, proxies[slot].generation});
+            float t;
+            if (rayCastCircle(bodies.x()[i], bodies.y()[i], bodies.radius()[i], origin_x, origin_y, dir_x, dir_y, limit, t)) {
+                hit.body = i;
+                hit.t = t;
+                any = true;
+                return t;
+            }
+            return limit;
+        };
+        // The dynamic tree starts with the range already clipped by any static hit
+        static_tree.rayCast(origin_x, origin_y, dir_x, dir_y, max_t, [&](int node, float limit) { return clip(static_tree, node, limit); });
+        float limit = any ? hit.t : max_t;
+        if (limit > 0.0f) {
+            dynamic_tree.rayCast(origin_x, origin_y, dir_x, dir_y, limit, [&](int node, float limit) { return clip(dynamic_tree, node, limit); });
+        }
+
+        if (any) {
+            fillRayNormal(bodies, origin_x, origin_y, dir_x, dir_y, hit);
+        }
+        return any;
+    }
+
+} // namespace broadphase
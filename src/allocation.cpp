@@ -0,0 +1,81 @@
+#include "allocation.h"
+#include <atomic>
+#include <new>
+
+namespace memory {
+
+    // ======================================================================== //
+    // ============================ Allocation Counter ======================== //
+    // ======================================================================== //
+    namespace {
+        std::atomic<std::uint64_t> allocation_count{0};
+    }
+
+    void countHeapAllocation() { allocation_count.fetch_add(1, std::memory_order_relaxed); }
+    std::uint64_t heapAllocations() { return allocation_count.load(std::memory_order_relaxed); }
+
+    // ======================================================================== //
+    // =============================== Frame Arena ============================ //
+    // ======================================================================== //
+    FrameArena::FrameArena(std::size_t initial_bytes) {
+        if (initial_bytes > 0) {
+            blocks.push_back(Block{static_cast<unsigned char*>(::operator new(initial_bytes, std::align_val_t(ALIGNMENT))), initial_bytes});
+        }
+    }
+
+    FrameArena::~FrameArena() { release(); }
+
+    void FrameArena::release() {
+        for (const Block& block : blocks) {
+            ::operator delete(block.data, std::align_val_t(ALIGNMENT));
+        }
+        blocks.clear();
+    }
+
+    void* FrameArena::allocateBytes(std::size_t bytes) {
+        std::size_t padded = (bytes + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT;
+        if (padded == 0) {
+            padded = ALIGNMENT;  // keep pointers distinct
+        }
+
+        // Chain on a block at least as big as everything so far, so overflow stays rare even mid-frame
+        if (blocks.empty() || offset + padded > blocks.back().size) {
+            std::size_t size = blocks.empty() ? 0 : blocks.back().size * 2;
+            if (size < padded) {
+                size = padded;
+            }
+            if (size < 64 * 1024) {
+                size = 64 * 1024;
+            }
+            blocks.push_back(Block{static_cast<unsigned char*>(::operator new(size, std::align_val_t(ALIGNMENT))), size});
+            offset = 0;
+        }
+
+        void* p = blocks.back().data + offset;
+        offset += padded;
+        used += padded;
+        if (used > peak) {
+            peak = used;
+        }
+        return p;
+    }
+
+    void FrameArena::reset() {
+        // Overflowed last frame: swap the chain for one block that fits the peak
+        if (blocks.size() > 1) {
+            release();
+            blocks.push_back(Block{static_cast<unsigned char*>(::operator new(peak, std::align_val_t(ALIGNMENT))), peak});
+        }
+        offset = 0;
+        used = 0;
+    }
+
+    std::size_t FrameArena::capacity() const {
+        std::size_t total = 0;
+        for (const Block& block : blocks) {
+            total += block.size;
+        }
+        return total;
+    }
+
+} // namespace memory
@@ -0,0 +1,286 @@
+#include "body_store.h"
+#include <algorithm>
+
+namespace world {
+
+    namespace {
+
+        // values[i] = values[order[i]], copied back through scratch so values keeps its capacity
+        template<typename T>
+        void permute(std::vector<T>& values, const std::vector<std::uint32_t>& order, std::vector<T>& scratch) {
+            scratch.resize(values.size());
+            for (std::size_t i = 0; i < values.size(); i++) {
+                scratch[i] = values[order[i]];
+            }
+            std::copy(scratch.begin(), scratch.end(), values.begin());
+        }
+
+    }
+
+    // ======================================================================== //
+    // ============================ Body Management =========================== //
+    // ======================================================================== //
+    BodyHandle BodyStore::create(float x, float y, float radius, float mass, bool is_static, float restitution) {
+        std::uint32_t dense = static_cast<std::uint32_t>(pos_x.size());
+        layout_version++;
+
+        pos_x.push_back(x);
+        pos_y.push_back(y);
+        vel_x.push_back(0.0f);
+        vel_y.push_back(0.0f);
+        force_x.push_back(0.0f);
+        force_y.push_back(0.0f);
+        inv_masses.push_back((is_static || mass <= 0.0f) ? 0.0f : 1.0f / mass);
+        masses.push_back(mass);
+        radii.push_back(radius);
+        restitutions.push_back(restitution);
+        body_flags.push_back(is_static ? BODY_STATIC : 0u);
+        rest_steps.push_back(0);
+        island_ids.push_back(0);
+        serials.push_back(next_serial++);
+
+        // Every body can queue at most one wake per step, so stepping never grows the queue
+        if (pending_wakes.capacity() < pos_x.capacity()) {
+            pending_wakes.reserve(pos_x.capacity());
+        }
+
+        // Reuses a released slot if there is one; its generation carries over
+        std::uint32_t slot = slots.allocate();
+        slots[slot].dense = dense;
+        dense_to_slot.push_back(slot);
+
+        BodyHandle handle{slot, slots[slot].generation};
+        changed.push_back(handle);
+        return handle;
+    }
+
+    void BodyStore::destroy(BodyHandle handle) {
+        if (!isValid(handle)) {
+            return;
+        }
+
+        // Neighbours of a sleeping body may have been resting on it
+        std::uint32_t hole = slots[handle.index].dense;
+        if (body_flags[hole] & BODY_SLEEPING) {
+            pending_wakes.push_back(island_ids[hole]);
+        }
+
+        // Move the last body into the hole so the arrays stay contiguous
+        layout_version++;
+        std::uint32_t last = static_cast<std::uint32_t>(pos_x.size() - 1);
+        if (hole != last) {
+            pos_x[hole] = pos_x[last];
+            pos_y[hole] = pos_y[last];
+            vel_x[hole] = vel_x[last];
+            vel_y[hole] = vel_y[last];
+            force_x[hole] = force_x[last];
+            force_y[hole] = force_y[last];
+            inv_masses[hole] = inv_masses[last];
+            masses[hole] = masses[last];
+            radii[hole] = radii[last];
+            restitutions[hole] = restitutions[last];
+            body_flags[hole] = body_flags[last];
+            rest_steps[hole] = rest_steps[last];
+            island_ids[hole] = island_ids[last];
+            serials[hole] = serials[last];
+
+            dense_to_slot[hole] = dense_to_slot[last];
+            slots[dense_to_slot[hole]].dense = hole;
+        }
+
+        pos_x.pop_back();
+        pos_y.pop_back();
+        vel_x.pop_back();
+        vel_y.pop_back();
+        force_x.pop_back();
+        force_y.pop_back();
+        inv_masses.pop_back();
+        masses.pop_back();
+        radii.pop_back();
+        restitutions.pop_back();
+        body_flags.pop_back();
+        rest_steps.pop_back();
+        island_ids.pop_back();
+        serials.pop_back();
+        dense_to_slot.pop_back();
+
+        changed.push_back(handle);
+
+        // Invalidate outstanding handles to this slot before recycling it
+        slots[handle.index].generation++;
+        slots.release(handle.index);
+    }
+
+    bool BodyStore::isValid(BodyHandle handle) const {
+        return handle.index < slots.extent() && slots[handle.index].generation == handle.generation;
+    }
+
+    void BodyStore::reserve(std::size_t count) {
+        pos_x.reserve(count);
+        pos_y.reserve(count);
+        vel_x.reserve(count);
+        vel_y.reserve(count);
+        force_x.reserve(count);
+        force_y.reserve(count);
+        inv_masses.reserve(count);
+        masses.reserve(count);
+        radii.reserve(count);
+        restitutions.reserve(count);
+        body_flags.reserve(count);
+        rest_steps.reserve(count);
+        island_ids.reserve(count);
+        serials.reserve(count);
+        dense_to_slot.reserve(count);
+        pending_wakes.reserve(count);
+        changed.reserve(count);
+        slots.reserve(count);
+    }
+
+    void BodyStore::clear() {
+        // Destroy one at a time so every outstanding handle is invalidated
+        while (!pos_x.empty()) {
+            destroy(handleOf(static_cast<std::uint32_t>(pos_x.size() - 1)));
+        }
+        pending_wakes.clear();
+    }
+
+    void BodyStore::assign(std::size_t count, const BodyArrays& arrays) {
+        clear();
+        layout_version++;
+        invalidateChanges();
+
+        pos_x.assign(arrays.x, arrays.x + count);
+        pos_y.assign(arrays.y, arrays.y + count);
+        vel_x.assign(arrays.vx, arrays.vx + count);
+        vel_y.assign(arrays.vy, arrays.vy + count);
+        force_x.assign(arrays.fx, arrays.fx + count);
+        force_y.assign(arrays.fy, arrays.fy + count);
+        inv_masses.assign(arrays.inv_mass, arrays.inv_mass + count);
+        masses.assign(arrays.mass, arrays.mass + count);
+        radii.assign(arrays.radius, arrays.radius + count);
+        restitutions.assign(arrays.restitution, arrays.restitution + count);
+        body_flags.assign(arrays.flags, arrays.flags + count);
+        rest_steps.assign(arrays.rest_steps, arrays.rest_steps + count);
+        island_ids.assign(arrays.island_ids, arrays.island_ids + count);
+
+        // The saved order is taken as the creation order
+        serials.resize(count);
+        for (std::size_t i = 0; i < count; i++) {
+            serials[i] = i;
+        }
+        next_serial = count;
+
+        pending_wakes.reserve(count);
+        slots.reserve(count);
+        dense_to_slot.resize(count);
+        for (std::uint32_t i = 0; i < count; i++) {
+            std::uint32_t slot = slots.allocate();
+            slots[slot].dense = i;
+            dense_to_slot[i] = slot;
+        }
+    }
+
+    bool BodyStore::restoreCreationOrder() {
+        if (std::is_sorted(serials.begin(), serials.end())) {
+            return false;
+        }
+
+        const std::size_t count = serials.size();
+        order_scratch.resize(count);
+        for (std::uint32_t i = 0; i < count; i++) {
+            order_scratch[i] = i;
+        }
+        std::sort(order_scratch.begin(), order_scratch.end(), [this](std::uint32_t a, std::uint32_t b) { return serials[a] < serials[b]; });
+
+        layout_version++;
+        permute(pos_x, order_scratch, float_scratch);
+        permute(pos_y, order_scratch, float_scratch);
+        permute(vel_x, order_scratch, float_scratch);
+        permute(vel_y, order_scratch, float_scratch);
+        permute(force_x, order_scratch, float_scratch);
+        permute(force_y, order_scratch, float_scratch);
+        permute(inv_masses, order_scratch, float_scratch);
+        permute(masses, order_scratch, float_scratch);
+        permute(radii, order_scratch, float_scratch);
+        permute(restitutions, order_scratch, float_scratch);
+        permute(body_flags, order_scratch, uint_scratch);
+        permute(rest_steps, order_scratch, uint_scratch);
+        permute(island_ids, order_scratch, uint_scratch);
+        permute(serials, order_scratch, serial_scratch);
+        permute(dense_to_slot, order_scratch, uint_scratch);
+        for (std::uint32_t i = 0; i < count; i++) {
+            slots[dense_to_slot[i]].dense = i;
+        }
+        return true;
+    }
+
+    // ======================================================================== //
+    // ============================ Per-body Updates ========================== //
+    // ======================================================================== //
+    void BodyStore::setPosition(std::uint32_t i, float newX, float newY) {
+        wake(i);
+        changed.push_back(handleOf(i));
+        pos_x[i] = newX;
+        pos_y[i] = newY;
+    }
+
+    void BodyStore::setVelocity(std::uint32_t i, float newVx, float newVy) {
+        wake(i);
+        vel_x[i] = newVx;
+        vel_y[i] = newVy;
+    }
+
+    void BodyStore::setForce(std::uint32_t i, float newFx, float newFy) {
+        if (!(body_flags[i] & BODY_STATIC)) {
+            wake(i);
+            force_x[i] = newFx;
+            force_y[i] = newFy;
+        }
+    }
+
+    void BodyStore::applyForce(std::uint32_t i, float forceX, float forceY) {
+        if (!(body_flags[i] & BODY_STATIC)) {
+            wake(i);
+            force_x[i] += forceX;
+            force_y[i] += forceY;
+        }
+    }
+
+    void BodyStore::clearForces(std::size_t begin, std::size_t end) {
+        std::fill(force_x.begin() + begin, force_x.begin() + end, 0.0f);
+        std::fill(force_y.begin() + begin, force_y.begin() + end, 0.0f);
+    }
+
+    // ======================================================================== //
+    // ================================ Change Log ============================ //
+    // ======================================================================== //
+    void BodyStore::forgetChanges() {
+        changed_from += changed.size();
+        changed.clear();
+    }
+
+    void BodyStore::invalidateChanges() {
+        // Leaves a gap in the numbering that every reader will notice
+        changed_from += changed.size() + 1;
+        changed.clear();
+    }
+
+    // ======================================================================== //
+    // ================================= Sleeping ============================= //
+    // ======================================================================== //
+    void BodyStore::sleep(std::uint32_t i, std::uint32_t island) {
+        body_flags[i] |= BODY_SLEEPING;
+        island_ids[i] = island;
+        vel_x[i] = 0.0f;
+        vel_y[i] = 0.0f;
+    }
+
+    void BodyStore::wake(std::uint32_t i) {
+        rest_steps[i] = 0;
+        if (body_flags[i] & BODY_SLEEPING) {
+            body_flags[i] &= ~static_cast<std::uint32_t>(BODY_SLEEPING);
+            pending_wakes.push_back(island_ids[i]);
+        }
+    }
+
+} // namespace world
@@ -0,0 +1,324 @@
+#include "broadphase.h"
+#include <algorithm>
+#include <cmath>
+
+namespace broadphase {
+
+    namespace {
+        // Bounding box overlap test for circles i and j
+        inline bool overlaps(const world::BodyStore& bodies, std::uint32_t i, std::uint32_t j) {
+            const float* x = bodies.x();
+            const float* y = bodies.y();
+            const float* r = bodies.radius();
+            float reach = r[i] + r[j];
+            return std::fabs(x[i] - x[j]) <= reach && std::fabs(y[i] - y[j]) <= reach;
+        }
+
+        // Neither body can move this step (static or asleep), so the pair needs no contact
+        inline bool bothInactive(const world::BodyStore& bodies, std::uint32_t i, std::uint32_t j) {
+            return (bodies.flags()[i] & world::BODY_INACTIVE) && (bodies.flags()[j] & world::BODY_INACTIVE);
+        }
+
+        inline BodyPair makePair(std::uint32_t i, std::uint32_t j) {
+            return i < j ? BodyPair{i, j} : BodyPair{j, i};
+        }
+    }
+
+    // ======================================================================== //
+    // ============================ Shared Queries ============================ //
+    // ======================================================================== //
+    bool circleOverlapsAabb(float cx, float cy, float radius, const Aabb& box) {
+        // Distance from the centre to the closest point of the box
+        float px = std::min(std::max(cx, box.min_x), box.max_x);
+        float py = std::min(std::max(cy, box.min_y), box.max_y);
+        float dx = cx - px;
+        float dy = cy - py;
+        return dx * dx + dy * dy <= radius * radius;
+    }
+
+    bool rayCastCircle(float cx, float cy, float radius, float origin_x, float origin_y, float dir_x, float dir_y, float max_t, float& t) {
+        // Solve |origin + t * dir - centre|^2 = radius^2 for the smallest t >= 0
+        float mx = origin_x - cx;
+        float my = origin_y - cy;
+        float c = mx * mx + my * my - radius * radius;
+        if (c <= 0.0f) {
+            t = 0.0f;
+            return true;
+        }
+        float a = dir_x * dir_x + dir_y * dir_y;
+        float b = mx * dir_x + my * dir_y;
+        float discriminant = b * b - a * c;
+        if (a <= 0.0f || b >= 0.0f || discriminant < 0.0f) {
+            return false;
+        }
+        float root = (-b - std::sqrt(discriminant)) / a;
+        if (root > max_t) {
+            return false;
+        }
+        t = root;
+        return true;
+    }
+
+    void BroadPhase::queryRegion(const world::BodyStore& bodies, const Aabb& region, std::vector<std::uint32_t>& found) {
+        found.clear();
+        const std::uint32_t count = static_cast<std::uint32_t>(bodies.size());
+        for (std::uint32_t i = 0; i < count; i++) {
+            if (circleOverlapsAabb(bodies.x()[i], bodies.y()[i], bodies.radius()[i], region)) {
+                found.push_back(i);
+            }
+        }
+    }
+
+    bool BroadPhase::rayCast(const world::BodyStore& bodies, float origin_x, float origin_y, float dir_x, float dir_y, float max_t, RayHit& hit) {
+        bool any = false;
+        const std::uint32_t count = static_cast<std::uint32_t>(bodies.size());
+        for (std::uint32_t i = 0; i < count; i++) {
+            float t;
+            if (rayCastCircle(bodies.x()[i], bodies.y()[i], bodies.radius()[i], origin_x, origin_y, dir_x, dir_y, max_t, t)) {
+                max_t = t;
+                hit.body = i;
+                hit.t = t;
+                any = true;
+            }
+        }
+        if (any) {
+            fillRayNormal(bodies, origin_x, origin_y, dir_x, dir_y, hit);
+        }
+        return any;
+    }
+
+    void fillRayNormal(const world::BodyStore& bodies, float origin_x, float origin_y, float dir_x, float dir_y, RayHit& hit) {
+        float nx = origin_x + hit.t * dir_x - bodies.x()[hit.body];
+        float ny = origin_y + hit.t * dir_y - bodies.y()[hit.body];
+        float length = std::sqrt(nx * nx + ny * ny);
+        if (length > 0.0f) {
+            hit.normal_x = nx / length;
+            hit.normal_y = ny / length;
+        } else {
+            hit.normal_x = 0.0f;
+            hit.normal_y = 0.0f;
+        }
+    }
+
+    /* Least significant digit first: b's digits then a's, each pass a stable
+    counting sort, with only as many digits as the largest index needs.*/
+    void sortPairs(std::vector<BodyPair>& pairs, std::vector<BodyPair>& scratch) {
+        const int DIGIT_BITS = 11;
+        const std::uint32_t DIGIT_MASK = (1u << DIGIT_BITS) - 1;
+
+        std::uint32_t largest = 0;
+        for (const BodyPair& pair : pairs) {
+            largest = std::max(largest, std::max(pair.a, pair.b));
+        }
+        int digits = 0;
+        while (digits * DIGIT_BITS < 32 && (largest >> (digits * DIGIT_BITS)) != 0) {
+            digits++;
+        }
+
+        scratch.resize(pairs.size());
+        std::size_t counts[DIGIT_MASK + 1];
+        for (int pass = 0; pass < 2 * digits; pass++) {
+            const bool by_a = pass >= digits;
+            const int shift = (pass % digits) * DIGIT_BITS;
+            std::fill(counts, counts + DIGIT_MASK + 1, std::size_t(0));
+            for (const BodyPair& pair : pairs) {
+                counts[((by_a ? pair.a : pair.b) >> shift) & DIGIT_MASK]++;
+            }
+            std::size_t start = 0;
+            for (std::size_t& count : counts) {
+                std::size_t n = count;
+                count = start;
+                start += n;
+            }
+            for (const BodyPair& pair : pairs) {
+                scratch[counts[((by_a ? pair.a : pair.b) >> shift) & DIGIT_MASK]++] = pair;
+            }
+            pairs.swap(scratch);
+        }
+    }
+
+    // ======================================================================== //
+    // ================================ Brute Force =========================== //
+    // ======================================================================== //
+    void BruteForce::findPairs(const world::BodyStore& bodies, std::vector<BodyPair>& pairs) {
+        pairs.clear();
+        counters.queries++;
+
+        const std::uint32_t count = static_cast<std::uint32_t>(bodies.size());
+        emitChunked(count, 64, pairs, [&](std::size_t begin, std::size_t end, std::vector<BodyPair>& out, std::uint64_t& tested) {
+            for (std::uint32_t i = static_cast<std::uint32_t>(begin); i < end; i++) {
+                for (std::uint32_t j = i + 1; j < count; j++) {
+                    if (bothInactive(bodies, i, j)) {
+                        continue;
+                    }
+                    tested++;
+                    if (overlaps(bodies, i, j)) {
+                        out.push_back(BodyPair{i, j});
+                    }
+                }
+            }
+        });
+        counters.pairs_overlapping += pairs.size();
+    }
+
+    // ======================================================================== //
+    // ============================ Spatial Hash Grid ========================= //
+    // ======================================================================== //
+    SpatialHashGrid::SpatialHashGrid(float cell_size) : fixed_cell_size(cell_size) {}
+
+    void SpatialHashGrid::findPairs(const world::BodyStore& bodies, std::vector<BodyPair>& pairs) {
+        pairs.clear();
+        counters.queries++;
+
+        const std::uint32_t count = static_cast<std::uint32_t>(bodies.size());
+        if (count < 2) {
+            return;
+        }
+        const float* x = bodies.x();
+        const float* y = bodies.y();
+        const float* r = bodies.radius();
+
+        // Pick the cell size, deriving it from the radius distribution if none was given
+        float cell_size = fixed_cell_size;
+        if (cell_size <= 0.0f) {
+            double sum = 0.0, sum_sq = 0.0;
+            for (std::uint32_t i = 0; i < count; i++) {
+                sum += r[i];
+                sum_sq += static_cast<double>(r[i]) * r[i];
+            }
+            double mean = sum / count;
+            double deviation = std::sqrt(std::max(0.0, sum_sq / count - mean * mean));
+            cell_size = static_cast<float>(2.0 * (mean + deviation));
+            if (!(cell_size > 0.0f)) {
+                cell_size = 1.0f;
+            }
+        }
+        last_cell_size = cell_size;
+        const float inv_cell = 1.0f / cell_size;
+
+        // Insert every body into each cell its bounding box touches
+        entries.clear();
+        for (std::uint32_t i = 0; i < count; i++) {
+            std::int32_t x0 = static_cast<std::int32_t>(std::floor((x[i] - r[i]) * inv_cell));
+            std::int32_t x1 = static_cast<std::int32_t>(std::floor((x[i] + r[i]) * inv_cell));
+            std::int32_t y0 = static_cast<std::int32_t>(std::floor((y[i] - r[i]) * inv_cell));
+            std::int32_t y1 = static_cast<std::int32_t>(std::floor((y[i] + r[i]) * inv_cell));
+            for (std::int32_t cy = y0; cy <= y1; cy++) {
+                for (std::int32_t cx = x0; cx <= x1; cx++) {
+                    entries.push_back(Entry{0, cx, cy, i});
+                }
+            }
+        }
+
+        // Hash cells into a power of two table at least twice the entry count
+        std::uint32_t table_size = 1;
+        while (table_size < 2 * entries.size()) {
+            table_size <<= 1;
+        }
+        const std::uint32_t mask = table_size - 1;
+        for (Entry& e : entries) {
+            e.bucket = ((static_cast<std::uint32_t>(e.cx) * 73856093u) ^ (static_cast<std::uint32_t>(e.cy) * 19349663u)) & mask;
+        }
+
+        // Counting sort by bucket so each bucket's entries are contiguous
+        bucket_start.assign(table_size + 1, 0);
+        for (const Entry& e : entries) {
+            bucket_start[e.bucket + 1]++;
+        }
+        for (std::uint32_t b = 0; b < table_size; b++) {
+            bucket_start[b + 1] += bucket_start[b];
+        }
+        sorted.resize(entries.size());
+        for (const Entry& e : entries) {
+            sorted[bucket_start[e.bucket]++] = e;
+        }
+        // bucket_start[b] now holds the end of bucket b, i.e. the start of b + 1
+        emitChunked(table_size, 1024, pairs, [&](std::size_t first, std::size_t last, std::vector<BodyPair>& out, std::uint64_t& tested) {
+            for (std::size_t b = first; b < last; b++) {
+                std::uint32_t begin = b == 0 ? 0 : bucket_start[b - 1];
+                std::uint32_t end = bucket_start[b];
+                for (std::uint32_t p = begin; p < end; p++) {
+                    const Entry& ep = sorted[p];
+                    for (std::uint32_t q = p + 1; q < end; q++) {
+                        const Entry& eq = sorted[q];
+                        // Different cells can hash to the same bucket
+                        if (ep.cx != eq.cx || ep.cy != eq.cy || bothInactive(bodies, ep.body, eq.body)) {
+                            continue;
+                        }
+                        tested++;
+                        if (!overlaps(bodies, ep.body, eq.body)) {
+                            continue;
+                        }
+                        // Report only from the cell holding the min corner of the intersection
+                        float ix = std::max(x[ep.body] - r[ep.body], x[eq.body] - r[eq.body]);
+                        float iy = std::max(y[ep.body] - r[ep.body], y[eq.body] - r[eq.body]);
+                        if (static_cast<std::int32_t>(std::floor(ix * inv_cell)) == ep.cx &&
+                            static_cast<std::int32_t>(std::floor(iy * inv_cell)) == ep.cy) {
+                            out.push_back(makePair(ep.body, eq.body));
+                        }
+                    }
+                }
+            }
+        });
+        counters.pairs_overlapping += pairs.size();
+    }
+
+    // ======================================================================== //
+    // ============================== Sweep And Prune ========================= //
+    // ======================================================================== //
+    void SweepAndPrune::findPairs(const world::BodyStore& bodies, std::vector<BodyPair>& pairs) {
+        pairs.clear();
+        counters.queries++;
+
+        const std::uint32_t count = static_cast<std::uint32_t>(bodies.size());
+        const float* x = bodies.x();
+        const float* y = bodies.y();
+        const float* r = bodies.radius();
+
+        min_x.resize(count);
+        for (std::uint32_t i = 0; i < count; i++) {
+            min_x[i] = x[i] - r[i];
+        }
+
+        // Bodies were created or destroyed since the last query, start from scratch
+        if (order.size() != count) {
+            order.resize(count);
+            for (std::uint32_t i = 0; i < count; i++) {
+                order[i] = i;
+            }
+            std::sort(order.begin(), order.end(), [this](std::uint32_t a, std::uint32_t b) { return min_x[a] < min_x[b]; });
+        }
+
+        // Insertion sort, cheap when the previous order is almost right
+        for (std::uint32_t i = 1; i < count; i++) {
+            std::uint32_t body = order[i];
+            float key = min_x[body];
+            std::uint32_t j = i;
+            while (j > 0 && min_x[order[j - 1]] > key) {
+                order[j] = order[j - 1];
+                j--;
+            }
+            order[j] = body;
+        }
+
+        // Sweep: only bodies starting before i ends can overlap it along x
+        emitChunked(count, 1024, pairs, [&](std::size_t begin, std::size_t end, std::vector<BodyPair>& out, std::uint64_t& tested) {
+            for (std::size_t p = begin; p < end; p++) {
+                std::uint32_t i = order[p];
+                float max_x = x[i] + r[i];
+                for (std::size_t q = p + 1; q < count && min_x[order[q]] <= max_x; q++) {
+                    std::uint32_t j = order[q];
+                    if (bothInactive(bodies, i, j)) {
+                        continue;
+                    }
+                    tested++;
+                    if (std::fabs(y[i] - y[j]) <= r[i] + r[j]) {
+                        out.push_back(makePair(i, j));
+                    }
+                }
+            }
+        });
+        counters.pairs_overlapping += pairs.size();
+    }
+
+} // namespace broadphase
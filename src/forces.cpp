@@ -0,0 +1,467 @@
+#include "forces.h"
+#include <simd.h>
+#include <algorithm>
+#include <cmath>
+
+#if SIMD_X86
+#include <immintrin.h>
+#endif
+
+namespace forces {
+
+    namespace {
+
+        const std::size_t FIELD_GRAIN = 4096;   // bodies per chunk for the single pass generators
+        const std::size_t PAIR_GRAIN = 256;     // bodies per chunk for mutual gravity, each visiting many others
+
+        // Spreads the low 16 bits of value out to the even bits
+        inline std::uint32_t spreadBits(std::uint32_t value) {
+            value &= 0xFFFF;
+            value = (value | (value << 8)) & 0x00FF00FF;
+            value = (value | (value << 4)) & 0x0F0F0F0F;
+            value = (value | (value << 2)) & 0x33333333;
+            value = (value | (value << 1)) & 0x55555555;
+            return value;
+        }
+
+        // Cell coordinate of value along an axis of the root cell, 16 bits
+        inline std::uint32_t gridCoordinate(float value, float min, float inv_size) {
+            float cell = (value - min) * inv_size * 65536.0f;
+            return cell <= 0.0f ? 0u : (cell >= 65535.0f ? 65535u : static_cast<std::uint32_t>(cell));
+        }
+
+        // Raw array view shared by the field kernels
+        struct Arrays {
+            const float* vx;
+            const float* vy;
+            float* fx;
+            float* fy;
+            const float* mass;
+            const std::uint32_t* flags;
+        };
+
+        Arrays arraysOf(world::BodyStore& bodies) {
+            return Arrays{bodies.vx(), bodies.vy(), bodies.fx(), bodies.fy(), bodies.mass(), bodies.flags()};
+        }
+
+        // ======================================================================== //
+        // ============================ Scalar Reference ========================== //
+        // ======================================================================== //
+        void gravityScalar(const Arrays& a, std::size_t begin, std::size_t end, float gx, float gy) {
+            for (std::size_t i = begin; i < end; i++) {
+                if (a.flags[i] & world::BODY_INACTIVE) {
+                    continue;
+                }
+                a.fx[i] = a.fx[i] + a.mass[i] * gx;
+                a.fy[i] = a.fy[i] + a.mass[i] * gy;
+            }
+        }
+
+        void dragScalar(const Arrays& a, std::size_t begin, std::size_t end, float linear, float quadratic) {
+            for (std::size_t i = begin; i < end; i++) {
+                if (a.flags[i] & world::BODY_INACTIVE) {
+                    continue;
+                }
+                float speed = std::sqrt(a.vx[i] * a.vx[i] + a.vy[i] * a.vy[i]);
+                float k = linear + quadratic * speed;
+                a.fx[i] = a.fx[i] - k * a.vx[i];
+                a.fy[i] = a.fy[i] - k * a.vy[i];
+            }
+        }
+
+#if SIMD_X86
+        // ======================================================================== //
+        // ================================== SSE2 ================================ //
+        // ======================================================================== //
+        __attribute__((target("sse2")))
+        void gravitySse2(const Arrays& a, std::size_t begin, std::size_t end, float gx, float gy) {
+            const __m128 vgx = _mm_set1_ps(gx);
+            const __m128 vgy = _mm_set1_ps(gy);
+            const __m128i inactive_bit = _mm_set1_epi32(static_cast<int>(world::BODY_INACTIVE));
+            const __m128i zero = _mm_setzero_si128();
+
+            std::size_t i = begin;
+            for (; i + 4 <= end; i += 4) {
+                __m128i flags = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a.flags + i));
+                __m128 active = _mm_castsi128_ps(_mm_cmpeq_epi32(_mm_and_si128(flags, inactive_bit), zero));
+                __m128 fx = _mm_loadu_ps(a.fx + i);
+                __m128 fy = _mm_loadu_ps(a.fy + i);
+                __m128 mass = _mm_loadu_ps(a.mass + i);
+                __m128 new_fx = _mm_add_ps(fx, _mm_mul_ps(mass, vgx));
+                __m128 new_fy = _mm_add_ps(fy, _mm_mul_ps(mass, vgy));
+                // Selected rather than adding zero, which would turn a -0 force into +0 unlike the scalar path
+                _mm_storeu_ps(a.fx + i, _mm_or_ps(_mm_and_ps(active, new_fx), _mm_andnot_ps(active, fx)));
+                _mm_storeu_ps(a.fy + i, _mm_or_ps(_mm_and_ps(active, new_fy), _mm_andnot_ps(active, fy)));
+            }
+            gravityScalar(a, i, end, gx, gy);
+        }
+
+        __attribute__((target("sse2")))
+        void dragSse2(const Arrays& a, std::size_t begin, std::size_t end, float linear, float quadratic) {
+            const __m128 vlinear = _mm_set1_ps(linear);
+            const __m128 vquadratic = _mm_set1_ps(quadratic);
+            const __m128i inactive_bit = _mm_set1_epi32(static_cast<int>(world::BODY_INACTIVE));
+            const __m128i zero = _mm_setzero_si128();
+
+            std::size_t i = begin;
+            for (; i + 4 <= end; i += 4) {
+                __m128i flags = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a.flags + i));
+                __m128 active = _mm_castsi128_ps(_mm_cmpeq_epi32(_mm_and_si128(flags, inactive_bit), zero));
+                __m128 vx = _mm_loadu_ps(a.vx + i);
+                __m128 vy = _mm_loadu_ps(a.vy + i);
+                __m128 fx = _mm_loadu_ps(a.fx + i);
+                __m128 fy = _mm_loadu_ps(a.fy + i);
+                __m128 speed = _mm_sqrt_ps(_mm_add_ps(_mm_mul_ps(vx, vx), _mm_mul_ps(vy, vy)));
+                __m128 k = _mm_add_ps(vlinear, _mm_mul_ps(vquadratic, speed));
+                __m128 new_fx = _mm_sub_ps(fx, _mm_mul_ps(k, vx));
+                __m128 new_fy = _mm_sub_ps(fy, _mm_mul_ps(k, vy));
+                _mm_storeu_ps(a.fx + i, _mm_or_ps(_mm_and_ps(active, new_fx), _mm_andnot_ps(active, fx)));
+                _mm_storeu_ps(a.fy + i, _mm_or_ps(_mm_and_ps(active, new_fy), _mm_andnot_ps(active, fy)));
+            }
+            dragScalar(a, i, end, linear, quadratic);
+        }
+
+        // ======================================================================== //
+        // ================================== AVX2 ================================ //
+        // ======================================================================== //
+        __attribute__((target("avx2")))
+        void gravityAvx2(const Arrays& a, std::size_t begin, std::size_t end, float gx, float gy) {
+            const __m256 vgx = _mm256_set1_ps(gx);
+            const __m256 vgy = _mm256_set1_ps(gy);
+            const __m256i inactive_bit = _mm256_set1_epi32(static_cast<int>(world::BODY_INACTIVE));
+            const __m256i zero = _mm256_setzero_si256();
+
+            std::size_t i = begin;
+            for (; i + 8 <= end; i += 8) {
+                __m256i flags = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a.flags + i));
+                __m256 active = _mm256_castsi256_ps(_mm256_cmpeq_epi32(_mm256_and_si256(flags, inactive_bit), zero));
+                __m256 fx = _mm256_loadu_ps(a.fx + i);
+                __m256 fy = _mm256_loadu_ps(a.fy + i);
+                __m256 mass = _mm256_loadu_ps(a.mass + i);
+                _mm256_storeu_ps(a.fx + i, _mm256_blendv_ps(fx, _mm256_add_ps(fx, _mm256_mul_ps(mass, vgx)), active));
+                _mm256_storeu_ps(a.fy + i, _mm256_blendv_ps(fy, _mm256_add_ps(fy, _mm256_mul_ps(mass, vgy)), active));
+            }
+            gravityScalar(a, i, end, gx, gy);
+            _mm256_zeroupper();  // see integrateAvx2 in integrate.cpp
+        }
+
+        __attribute__((target("avx2")))
+        void dragAvx2(const Arrays& a, std::size_t begin, std::size_t end, float linear, float quadratic) {
+            const __m256 vlinear = _mm256_set1_ps(linear);
+            const __m256 vquadratic = _mm256_set1_ps(quadratic);
+            const __m256i inactive_bit = _mm256_set1_epi32(static_cast<int>(world::BODY_INACTIVE));
+            const __m256i zero = _mm256_setzero_si256();
+
+            std::size_t i = begin;
+            for (; i + 8 <= end; i += 8) {
+                __m256i flags = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a.flags + i));
+                __m256 active = _mm256_castsi256_ps(_mm256_cmpeq_epi32(_mm256_and_si256(flags, inactive_bit), zero));
+                __m256 vx = _mm256_loadu_ps(a.vx + i);
+                __m256 vy = _mm256_loadu_ps(a.vy + i);
+                __m256 fx = _mm256_loadu_ps(a.fx + i);
+                __m256 fy = _mm256_loadu_ps(a.fy + i);
+                __m256 speed = _mm256_sqrt_ps(_mm256_add_ps(_mm256_mul_ps(vx, vx), _mm256_mul_ps(vy, vy)));
+                __m256 k = _mm256_add_ps(vlinear, _mm256_mul_ps(vquadratic, speed));
+                _mm256_storeu_ps(a.fx + i, _mm256_blendv_ps(fx, _mm256_sub_ps(fx, _mm256_mul_ps(k, vx)), active));
+                _mm256_storeu_ps(a.fy + i, _mm256_blendv_ps(fy, _mm256_sub_ps(fy, _mm256_mul_ps(k, vy)), active));
+            }
+            dragScalar(a, i, end, linear, quadratic);
+            _mm256_zeroupper();
+        }
+
+        // ======================================================================== //
+        // ================================= AVX-512 ============================== //
+        // ======================================================================== //
+        __attribute__((target("avx512f")))
+        void gravityAvx512(const Arrays& a, std::size_t begin, std::size_t end, float gx, float gy) {
+            const __m512 vgx = _mm512_set1_ps(gx);
+            const __m512 vgy = _mm512_set1_ps(gy);
+            const __m512i inactive_bit = _mm512_set1_epi32(static_cast<int>(world::BODY_INACTIVE));
+
+            std::size_t i = begin;
+            for (; i + 16 <= end; i += 16) {
+                __mmask16 active = _mm512_testn_epi32_mask(_mm512_loadu_si512(a.flags + i), inactive_bit);
+                __m512 fx = _mm512_loadu_ps(a.fx + i);
+                __m512 fy = _mm512_loadu_ps(a.fy + i);
+                __m512 mass = _mm512_loadu_ps(a.mass + i);
+                _mm512_storeu_ps(a.fx + i, _mm512_mask_add_ps(fx, active, fx, _mm512_mul_ps(mass, vgx)));
+                _mm512_storeu_ps(a.fy + i, _mm512_mask_add_ps(fy, active, fy, _mm512_mul_ps(mass, vgy)));
+            }
+            gravityScalar(a, i, end, gx, gy);
+            _mm256_zeroupper();
+        }
+
+        __attribute__((target("avx512f")))
+        void dragAvx512(const Arrays& a, std::size_t begin, std::size_t end, float linear, float quadratic) {
+            const __m512 vlinear = _mm512_set1_ps(linear);
+            const __m512 vquadratic = _mm512_set1_ps(quadratic);
+            const __m512i inactive_bit = _mm512_set1_epi32(static_cast<int>(world::BODY_INACTIVE));
+            const __mmask16 all = 0xFFFF;
+
+            std::size_t i = begin;
+            for (; i + 16 <= end; i += 16) {
+                __mmask16 active = _mm512_testn_epi32_mask(_mm512_loadu_si512(a.flags + i), inactive_bit);
+                __m512 vx = _mm512_loadu_ps(a.vx + i);
+                __m512 vy = _mm512_loadu_ps(a.vy + i);
+                __m512 fx = _mm512_loadu_ps(a.fx + i);
+                __m512 fy = _mm512_loadu_ps(a.fy + i);
+                // Masked sqrt as in narrowphase.cpp, the unmasked form trips GCC 12's maybe-uninitialized warning
+                __m512 speed = _mm512_maskz_sqrt_ps(all, _mm512_add_ps(_mm512_mul_ps(vx, vx), _mm512_mul_ps(vy, vy)));
+                __m512 k = _mm512_add_ps(vlinear, _mm512_mul_ps(vquadratic, speed));
+                _mm512_storeu_ps(a.fx + i, _mm512_mask_sub_ps(fx, active, fx, _mm512_mul_ps(k, vx)));
+                _mm512_storeu_ps(a.fy + i, _mm512_mask_sub_ps(fy, active, fy, _mm512_mul_ps(k, vy)));
+            }
+            dragScalar(a, i, end, linear, quadratic);
+            _mm256_zeroupper();
+        }
+#endif
+    }
+
+    // ======================================================================== //
+    // ============================== Field Generators ======================== //
+    // ======================================================================== //
+    void UniformGravity::apply(world::BodyStore& bodies, threading::ThreadPool* pool) {
+        const Arrays a = arraysOf(bodies);
+        const float gravity_x = gx, gravity_y = gy;
+        threading::parallelFor(pool, 0, bodies.size(), FIELD_GRAIN, [&](std::size_t begin, std::size_t end, unsigned) {
+            switch (simd::active()) {
+#if SIMD_X86
+                case simd::Level::AVX512: gravityAvx512(a, begin, end, gravity_x, gravity_y); return;
+                case simd::Level::AVX2: gravityAvx2(a, begin, end, gravity_x, gravity_y); return;
+                case simd::Level::SSE2: gravitySse2(a, begin, end, gravity_x, gravity_y); return;
+#endif
+                default: gravityScalar(a, begin, end, gravity_x, gravity_y); return;
+            }
+        });
+    }
+
+    void Drag::apply(world::BodyStore& bodies, threading::ThreadPool* pool) {
+        const Arrays a = arraysOf(bodies);
+        const float k1 = linear, k2 = quadratic;
+        threading::parallelFor(pool, 0, bodies.size(), FIELD_GRAIN, [&](std::size_t begin, std::size_t end, unsigned) {
+            switch (simd::active()) {
+#if SIMD_X86
+                case simd::Level::AVX512: dragAvx512(a, begin, end, k1, k2); return;
+                case simd::Level::AVX2: dragAvx2(a, begin, end, k1, k2); return;
+                case simd::Level::SSE2: dragSse2(a, begin, end, k1, k2); return;
+#endif
+                default: dragScalar(a, begin, end, k1, k2); return;
+            }
+        });
+    }
+
+    // ======================================================================== //
+    // ============================== Mutual Gravity ========================== //
+    // ======================================================================== //
+    MutualGravity::MutualGravity(float constant, float opening_angle, float softening, Method method)
+    : constant(constant), opening_angle(opening_angle), softening(softening), method(method) {}
+
+    void MutualGravity::apply(world::BodyStore& bodies, threading::ThreadPool* pool) {
+        if (method == Method::Exact) {
+            applyExact(bodies, pool);
+            return;
+        }
+        build(bodies);
+        applyBarnesHut(bodies, pool);
+    }
+
+    /* Bodies are inserted one at a time, splitting an occupied leaf into four
+    until the two bodies land in different cells. Children are always pushed
+    after their parent, so one backwards pass over the nodes finishes every
+    cell's children before the cell itself when totalling masses.*/
+    void MutualGravity::build(const world::BodyStore& bodies) {
+        const std::size_t count = bodies.size();
+        const float* x = bodies.x();
+        const float* y = bodies.y();
+        const float* mass = bodies.mass();
+
+        // Root cell: a square around every body that attracts
+        float min_x = 0.0f, min_y = 0.0f, max_x = 0.0f, max_y = 0.0f;
+        bool any = false;
+        for (std::size_t i = 0; i < count; i++) {
+            if (!(mass[i] > 0.0f)) {
+                continue;
+            }
+            min_x = any ? std::min(min_x, x[i]) : x[i];
+            min_y = any ? std::min(min_y, y[i]) : y[i];
+            max_x = any ? std::max(max_x, x[i]) : x[i];
+            max_y = any ? std::max(max_y, y[i]) : y[i];
+            any = true;
+        }
+        float size = std::max(max_x - min_x, max_y - min_y);
+        size = size > 0.0f ? size * 1.0001f : 1.0f;  // keep the max corner strictly inside
+
+        // Morton order by a two pass radix sort on 16-bit halves of the key
+        const float inv_size = 1.0f / size;
+        keys.resize(count);
+        order.resize(count);
+        key_scratch.resize(count);
+        order_scratch.resize(count);
+        for (std::size_t i = 0; i < count; i++) {
+            keys[i] = spreadBits(gridCoordinate(x[i], min_x, inv_size)) | (spreadBits(gridCoordinate(y[i], min_y, inv_size)) << 1);
+            order[i] = static_cast<std::uint32_t>(i);
+        }
+        std::vector<std::size_t>& counts = digit_counts;
+        for (int shift = 0; shift < 32; shift += 16) {
+            counts.assign(std::size_t(1) << 16, 0);
+            for (std::size_t k = 0; k < count; k++) {
+                counts[(keys[k] >> shift) & 0xFFFF]++;
+            }
+            std::size_t start = 0;
+            for (std::size_t& bucket : counts) {
+                std::size_t n = bucket;
+                bucket = start;
+                start += n;
+            }
+            for (std::size_t k = 0; k < count; k++) {
+                std::size_t to = counts[(keys[k] >> shift) & 0xFFFF]++;
+                key_scratch[to] = keys[k];
+                order_scratch[to] = order[k];
+            }
+            keys.swap(key_scratch);
+            order.swap(order_scratch);
+        }
+
+        nodes.clear();
+        nodes.push_back(Node{min_x, min_y, size, 0.0f, 0.0f, 0.0f, -1, EMPTY});
+
+        for (std::uint32_t i : order) {
+            if (!(mass[i] > 0.0f)) {
+                continue;
+            }
+            const std::int32_t body = static_cast<std::int32_t>(i);
+            std::size_t n = 0;
+            for (int depth = 0;; depth++) {
+                if (nodes[n].first_child >= 0) {
+                    const Node& cell = nodes[n];
+                    float half = cell.size * 0.5f;
+                    int quadrant = (x[i] >= cell.min_x + half ? 1 : 0) + (y[i] >= cell.min_y + half ? 2 : 0);
+                    n = static_cast<std::size_t>(cell.first_child + quadrant);
+                    continue;
+                }
+                if (nodes[n].body == EMPTY || depth >= MAX_DEPTH) {
+                    Node& leaf = nodes[n];
+                    leaf.body = leaf.body == EMPTY ? body : SEVERAL;
+                    leaf.mass += mass[i];
+                    leaf.com_x += mass[i] * x[i];
+                    leaf.com_y += mass[i] * y[i];
+                    break;
+                }
+
+                // Split the occupied leaf and move its body down, then carry on inserting
+                const Node leaf = nodes[n];
+                const std::int32_t first = static_cast<std::int32_t>(nodes.size());
+                const float half = leaf.size * 0.5f;
+                for (int q = 0; q < 4; q++) {
+                    nodes.push_back(Node{leaf.min_x + (q & 1 ? half : 0.0f), leaf.min_y + (q & 2 ? half : 0.0f), half, 0.0f, 0.0f, 0.0f, -1, EMPTY});
+                }
+                const std::size_t moved = static_cast<std::size_t>(leaf.body);
+                int quadrant = (x[moved] >= leaf.min_x + half ? 1 : 0) + (y[moved] >= leaf.min_y + half ? 2 : 0);
+                Node& child = nodes[first + quadrant];
+                child.body = leaf.body;
+                child.mass = leaf.mass;
+                child.com_x = leaf.com_x;
+                child.com_y = leaf.com_y;
+                nodes[n] = Node{leaf.min_x, leaf.min_y, leaf.size, 0.0f, 0.0f, 0.0f, first, EMPTY};
+            }
+        }
+
+        for (std::size_t n = nodes.size(); n-- > 0;) {
+            Node& cell = nodes[n];
+            if (cell.first_child >= 0) {
+                for (int q = 0; q < 4; q++) {
+                    const Node& child = nodes[cell.first_child + q];
+                    cell.mass += child.mass;
+                    cell.com_x += child.mass * child.com_x;
+                    cell.com_y += child.mass * child.com_y;
+                }
+            }
+            if (cell.mass > 0.0f) {
+                cell.com_x /= cell.mass;
+                cell.com_y /= cell.mass;
+            }
+        }
+    }
+
+    /* Depth-first walk from the root for every pulled body, always visiting
+    children in the same order so the sum doesn't depend on the thread count.*/
+    void MutualGravity::applyBarnesHut(world::BodyStore& bodies, threading::ThreadPool* pool) const {
+        const float* x = bodies.x();
+        const float* y = bodies.y();
+        const float* mass = bodies.mass();
+        const std::uint32_t* flags = bodies.flags();
+        float* fx = bodies.fx();
+        float* fy = bodies.fy();
+        const float theta2 = opening_angle * opening_angle;
+        const float eps2 = softening * softening;
+
+        threading::parallelFor(pool, 0, order.size(), PAIR_GRAIN, [&](std::size_t begin, std::size_t end, unsigned) {
+            std::int32_t stack[3 * MAX_DEPTH + 4];  // each level leaves at most three siblings waiting
+            for (std::size_t k = begin; k < end; k++) {
+                const std::uint32_t i = order[k];
+                if (flags[i] & world::BODY_INACTIVE) {
+                    continue;
+                }
+                float ax = 0.0f, ay = 0.0f;
+                int top = 0;
+                stack[top++] = 0;
+                while (top > 0) {
+                    const Node& cell = nodes[stack[--top]];
+                    if (!(cell.mass > 0.0f) || cell.body == static_cast<std::int32_t>(i)) {
+                        continue;
+                    }
+                    float dx = cell.com_x - x[i];
+                    float dy = cell.com_y - y[i];
+                    float d2 = dx * dx + dy * dy;
+                    bool inside = x[i] >= cell.min_x && x[i] < cell.min_x + cell.size && y[i] >= cell.min_y && y[i] < cell.min_y + cell.size;
+                    if (cell.first_child >= 0 && (inside || cell.size * cell.size >= theta2 * d2)) {
+                        for (int q = 3; q >= 0; q--) {
+                            stack[top++] = cell.first_child + q;
+                        }
+                        continue;
+                    }
+                    float r2 = d2 + eps2;
+                    float scale = cell.mass / (r2 * std::sqrt(r2));
+                    ax += dx * scale;
+                    ay += dy * scale;
+                }
+                fx[i] += constant * mass[i] * ax;
+                fy[i] += constant * mass[i] * ay;
+            }
+        });
+    }
+
+    void MutualGravity::applyExact(world::BodyStore& bodies, threading::ThreadPool* pool) const {
+        const std::size_t count = bodies.size();
+        const float* x = bodies.x();
+        const float* y = bodies.y();
+        const float* mass = bodies.mass();
+        const std::uint32_t* flags = bodies.flags();
+        float* fx = bodies.fx();
+        float* fy = bodies.fy();
+        const double eps2 = static_cast<double>(softening) * softening;
+
+        threading::parallelFor(pool, 0, count, PAIR_GRAIN, [&](std::size_t begin, std::size_t end, unsigned) {
+            for (std::size_t i = begin; i < end; i++) {
+                if (flags[i] & world::BODY_INACTIVE) {
+                    continue;
+                }
+                double ax = 0.0, ay = 0.0;
+                for (std::size_t j = 0; j < count; j++) {
+                    if (j == i || !(mass[j] > 0.0f)) {
+                        continue;
+                    }
+                    double dx = static_cast<double>(x[j]) - x[i];
+                    double dy = static_cast<double>(y[j]) - y[i];
+                    double r2 = dx * dx + dy * dy + eps2;
+                    double scale = mass[j] / (r2 * std::sqrt(r2));
+                    ax += dx * scale;
+                    ay += dy * scale;
+                }
+                fx[i] += static_cast<float>(constant * mass[i] * ax);
+                fy[i] += static_cast<float>(constant * mass[i] * ay);
+            }
+        });
+    }
+
+} // namespace forces
@@ -0,0 +1,161 @@
+#include "integrate.h"
+#include <simd.h>
+#include <cstdint>
+
+#if SIMD_X86
+#include <immintrin.h>
+#endif
+
+namespace world {
+
+    namespace {
+
+        // Raw array view shared by every kernel
+        struct Arrays {
+            float* x;
+            float* y;
+            float* vx;
+            float* vy;
+            const float* fx;
+            const float* fy;
+            const float* inv_mass;
+            const std::uint32_t* flags;
+        };
+
+        // ======================================================================== //
+        // ============================ Scalar Reference ========================== //
+        // ======================================================================== //
+        void integrateScalar(const Arrays& a, std::size_t begin, std::size_t end, float dt) {
+            for (std::size_t i = begin; i < end; i++) {
+                if (a.flags[i] & BODY_INACTIVE) {
+                    continue;
+                }
+                a.vx[i] = a.vx[i] + (a.fx[i] * a.inv_mass[i]) * dt;
+                a.vy[i] = a.vy[i] + (a.fy[i] * a.inv_mass[i]) * dt;
+                a.x[i] = a.x[i] + a.vx[i] * dt;
+                a.y[i] = a.y[i] + a.vy[i] * dt;
+            }
+        }
+
+#if SIMD_X86
+        // ======================================================================== //
+        // ================================== SSE2 ================================ //
+        // ======================================================================== //
+        __attribute__((target("sse2")))
+        void integrateSse2(const Arrays& a, std::size_t begin, std::size_t end, float dt) {
+            const __m128 vdt = _mm_set1_ps(dt);
+            const __m128i inactive_bit = _mm_set1_epi32(static_cast<int>(BODY_INACTIVE));
+            const __m128i zero = _mm_setzero_si128();
+
+            std::size_t i = begin;
+            for (; i + 4 <= end; i += 4) {
+                // All bits set in lanes whose body is dynamic and awake
+                __m128i flags = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a.flags + i));
+                __m128 active = _mm_castsi128_ps(_mm_cmpeq_epi32(_mm_and_si128(flags, inactive_bit), zero));
+
+                __m128 inv_mass = _mm_loadu_ps(a.inv_mass + i);
+                __m128 vx = _mm_loadu_ps(a.vx + i);
+                __m128 vy = _mm_loadu_ps(a.vy + i);
+                __m128 x = _mm_loadu_ps(a.x + i);
+                __m128 y = _mm_loadu_ps(a.y + i);
+
+                __m128 new_vx = _mm_add_ps(vx, _mm_mul_ps(_mm_mul_ps(_mm_loadu_ps(a.fx + i), inv_mass), vdt));
+                __m128 new_vy = _mm_add_ps(vy, _mm_mul_ps(_mm_mul_ps(_mm_loadu_ps(a.fy + i), inv_mass), vdt));
+                __m128 new_x = _mm_add_ps(x, _mm_mul_ps(new_vx, vdt));
+                __m128 new_y = _mm_add_ps(y, _mm_mul_ps(new_vy, vdt));
+
+                // SSE2 has no blend instruction, select with and/andnot/or
+                _mm_storeu_ps(a.vx + i, _mm_or_ps(_mm_and_ps(active, new_vx), _mm_andnot_ps(active, vx)));
+                _mm_storeu_ps(a.vy + i, _mm_or_ps(_mm_and_ps(active, new_vy), _mm_andnot_ps(active, vy)));
+                _mm_storeu_ps(a.x + i, _mm_or_ps(_mm_and_ps(active, new_x), _mm_andnot_ps(active, x)));
+                _mm_storeu_ps(a.y + i, _mm_or_ps(_mm_and_ps(active, new_y), _mm_andnot_ps(active, y)));
+            }
+            integrateScalar(a, i, end, dt);
+        }
+
+        // ======================================================================== //
+        // ================================== AVX2 ================================ //
+        // ======================================================================== //
+        __attribute__((target("avx2")))
+        void integrateAvx2(const Arrays& a, std::size_t begin, std::size_t end, float dt) {
+            const __m256 vdt = _mm256_set1_ps(dt);
+            const __m256i inactive_bit = _mm256_set1_epi32(static_cast<int>(BODY_INACTIVE));
+            const __m256i zero = _mm256_setzero_si256();
+
+            std::size_t i = begin;
+            for (; i + 8 <= end; i += 8) {
+                __m256i flags = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a.flags + i));
+                __m256 active = _mm256_castsi256_ps(_mm256_cmpeq_epi32(_mm256_and_si256(flags, inactive_bit), zero));
+
+                __m256 inv_mass = _mm256_loadu_ps(a.inv_mass + i);
+                __m256 vx = _mm256_loadu_ps(a.vx + i);
+                __m256 vy = _mm256_loadu_ps(a.vy + i);
+                __m256 x = _mm256_loadu_ps(a.x + i);
+                __m256 y = _mm256_loadu_ps(a.y + i);
+
+                __m256 new_vx = _mm256_add_ps(vx, _mm256_mul_ps(_mm256_mul_ps(_mm256_loadu_ps(a.fx + i), inv_mass), vdt));
+                __m256 new_vy = _mm256_add_ps(vy, _mm256_mul_ps(_mm256_mul_ps(_mm256_loadu_ps(a.fy + i), inv_mass), vdt));
+                __m256 new_x = _mm256_add_ps(x, _mm256_mul_ps(new_vx, vdt));
+                __m256 new_y = _mm256_add_ps(y, _mm256_mul_ps(new_vy, vdt));
+
+                _mm256_storeu_ps(a.vx + i, _mm256_blendv_ps(vx, new_vx, active));
+                _mm256_storeu_ps(a.vy + i, _mm256_blendv_ps(vy, new_vy, active));
+                _mm256_storeu_ps(a.x + i, _mm256_blendv_ps(x, new_x, active));
+                _mm256_storeu_ps(a.y + i, _mm256_blendv_ps(y, new_y, active));
+            }
+            integrateScalar(a, i, end, dt);
+            // GCC doesn't always clear the upper register halves on return here, and every
+            // SSE instruction the caller runs afterwards would then pay a transition penalty
+            _mm256_zeroupper();
+        }
+
+        // ======================================================================== //
+        // ================================= AVX-512 ============================== //
+        // ======================================================================== //
+        __attribute__((target("avx512f")))
+        void integrateAvx512(const Arrays& a, std::size_t begin, std::size_t end, float dt) {
+            const __m512 vdt = _mm512_set1_ps(dt);
+            const __m512i inactive_bit = _mm512_set1_epi32(static_cast<int>(BODY_INACTIVE));
+
+            std::size_t i = begin;
+            for (; i + 16 <= end; i += 16) {
+                // Mask register with one bit per active lane; masked-off lanes pass through unchanged
+                __m512i flags = _mm512_loadu_si512(a.flags + i);
+                __mmask16 active = _mm512_testn_epi32_mask(flags, inactive_bit);
+
+                __m512 inv_mass = _mm512_loadu_ps(a.inv_mass + i);
+                __m512 vx = _mm512_loadu_ps(a.vx + i);
+                __m512 vy = _mm512_loadu_ps(a.vy + i);
+
+                vx = _mm512_mask_add_ps(vx, active, vx, _mm512_mul_ps(_mm512_mul_ps(_mm512_loadu_ps(a.fx + i), inv_mass), vdt));
+                vy = _mm512_mask_add_ps(vy, active, vy, _mm512_mul_ps(_mm512_mul_ps(_mm512_loadu_ps(a.fy + i), inv_mass), vdt));
+                __m512 x = _mm512_loadu_ps(a.x + i);
+                __m512 y = _mm512_loadu_ps(a.y + i);
+                x = _mm512_mask_add_ps(x, active, x, _mm512_mul_ps(vx, vdt));
+                y = _mm512_mask_add_ps(y, active, y, _mm512_mul_ps(vy, vdt));
+
+                _mm512_storeu_ps(a.vx + i, vx);
+                _mm512_storeu_ps(a.vy + i, vy);
+                _mm512_storeu_ps(a.x + i, x);
+                _mm512_storeu_ps(a.y + i, y);
+            }
+            integrateScalar(a, i, end, dt);
+            _mm256_zeroupper();  // see integrateAvx2
+        }
+#endif
+    }
+
+    void integrateRange(BodyStore& store, std::size_t begin, std::size_t end, float deltaTime) {
+        Arrays a{store.x(), store.y(), store.vx(), store.vy(), store.fx(), store.fy(), store.invMass(), store.flags()};
+
+        switch (simd::active()) {
+#if SIMD_X86
+            case simd::Level::AVX512: integrateAvx512(a, begin, end, deltaTime); return;
+            case simd::Level::AVX2: integrateAvx2(a, begin, end, deltaTime); return;
+            case simd::Level::SSE2: integrateSse2(a, begin, end, deltaTime); return;
+#endif
+            default: integrateScalar(a, begin, end, deltaTime); return;
+        }
+    }
+
+} // namespace world
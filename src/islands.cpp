@@ -0,0 +1,145 @@
+#include "islands.h"
+#include <algorithm>
+
+namespace world {
+
+    // ======================================================================== //
+    // ================================ Union-Find ============================ //
+    // ======================================================================== //
+    std::uint32_t IslandManager::find(std::uint32_t i) {
+        // Path halving keeps the trees flat without recursion
+        while (parent[i] != i) {
+            parent[i] = parent[parent[i]];
+            i = parent[i];
+        }
+        return i;
+    }
+
+    void IslandManager::unite(std::uint32_t a, std::uint32_t b) {
+        a = find(a);
+        b = find(b);
+        // Lowest index becomes the root so the result doesn't depend on contact order
+        if (a < b) {
+            parent[b] = a;
+        } else if (b < a) {
+            parent[a] = b;
+        }
+    }
+
+    // ======================================================================== //
+    // ================================== Waking ============================== //
+    // ======================================================================== //
+    void IslandManager::wakePending(BodyStore& bodies) {
+        std::vector<std::uint32_t>& pending = bodies.pendingWakes();
+        if (pending.empty()) {
+            return;
+        }
+        std::sort(pending.begin(), pending.end());
+        pending.erase(std::unique(pending.begin(), pending.end()), pending.end());
+
+        const std::uint32_t count = static_cast<std::uint32_t>(bodies.size());
+        std::uint32_t* flags = bodies.flags();
+        const std::uint32_t* island_ids = bodies.islandIds();
+        for (std::uint32_t i = 0; i < count; i++) {
+            if ((flags[i] & BODY_SLEEPING) && std::binary_search(pending.begin(), pending.end(), island_ids[i])) {
+                flags[i] &= ~static_cast<std::uint32_t>(BODY_SLEEPING);
+                bodies.restSteps()[i] = 0;
+            }
+        }
+        pending.clear();
+    }
+
+    void IslandManager::wakeTouched(BodyStore& bodies, const std::vector<narrowphase::Contact>& contacts) {
+        // The broad-phase only pairs a sleeper with an awake dynamic body
+        for (const narrowphase::Contact& contact : contacts) {
+            if (bodies.isSleeping(contact.a)) {
+                bodies.wake(contact.a);
+            }
+            if (bodies.isSleeping(contact.b)) {
+                bodies.wake(contact.b);
+            }
+        }
+        wakePending(bodies);
+    }
+
+    // ======================================================================== //
+    // ================================= Sleeping ============================= //
+    // ======================================================================== //
+    void IslandManager::countResting(BodyStore& bodies) {
+        if (!config.enabled) {
+            return;
+        }
+        const std::uint32_t count = static_cast<std::uint32_t>(bodies.size());
+        const std::uint32_t* flags = bodies.flags();
+        const float* vx = bodies.vx();
+        const float* vy = bodies.vy();
+        std::uint32_t* rest_steps = bodies.restSteps();
+        const float threshold = config.velocity * config.velocity;
+        for (std::uint32_t i = 0; i < count; i++) {
+            if (!(flags[i] & BODY_INACTIVE)) {
+                rest_steps[i] = vx[i] * vx[i] + vy[i] * vy[i] < threshold ? rest_steps[i] + 1 : 0;
+            }
+        }
+    }
+
+    void IslandManager::update(BodyStore& bodies, const std::vector<narrowphase::Contact>& contacts, memory::FrameArena& arena) {
+        const std::uint32_t count = static_cast<std::uint32_t>(bodies.size());
+        const std::uint32_t* flags = bodies.flags();
+        counts = IslandStats();
+
+        if (!config.enabled) {
+            for (std::uint32_t i = 0; i < count; i++) {
+                if (!(flags[i] & BODY_INACTIVE)) {
+                    counts.awake_bodies++;
+                } else if (flags[i] & BODY_SLEEPING) {
+                    counts.asleep_bodies++;
+                }
+            }
+            counts.islands = counts.awake_bodies;
+            return;
+        }
+
+        parent = arena.allocate<std::uint32_t>(count);
+        for (std::uint32_t i = 0; i < count; i++) {
+            parent[i] = i;
+        }
+        for (const narrowphase::Contact& contact : contacts) {
+            if (!(flags[contact.a] & BODY_INACTIVE) && !(flags[contact.b] & BODY_INACTIVE)) {
+                unite(contact.a, contact.b);
+            }
+        }
+
+        // Take the fewest resting steps (counted by countResting) over each island
+        const std::uint32_t* rest_steps = bodies.restSteps();
+        std::uint32_t* island_rest = arena.allocate<std::uint32_t>(count);  // per root: fewest rest steps of any member
+        std::fill(island_rest, island_rest + count, 0xFFFFFFFFu);
+        for (std::uint32_t i = 0; i < count; i++) {
+            if (flags[i] & BODY_INACTIVE) {
+                if (flags[i] & BODY_SLEEPING) {
+                    counts.asleep_bodies++;
+                }
+                continue;
+            }
+            std::uint32_t root = find(i);
+            island_rest[root] = std::min(island_rest[root], rest_steps[i]);
+            if (root == i) {
+                counts.islands++;
+            }
+        }
+
+        // Put islands that have rested long enough to sleep, labelled by their root's handle
+        for (std::uint32_t i = 0; i < count; i++) {
+            if (flags[i] & BODY_INACTIVE) {
+                continue;
+            }
+            std::uint32_t root = find(i);
+            if (island_rest[root] >= config.steps) {
+                bodies.sleep(i, bodies.handleOf(root).index);
+                counts.asleep_bodies++;
+            } else {
+                counts.awake_bodies++;
+            }
+        }
+    }
+
+} // namespace world
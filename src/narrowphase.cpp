@@ -0,0 +1,270 @@
+#include "narrowphase.h"
+#include <simd.h>
+#include <cmath>
+
+#if SIMD_X86
+#include <immintrin.h>
+#endif
+
+namespace narrowphase {
+
+    namespace {
+        const std::size_t GRAIN = 1024;  // pairs per chunk
+
+        // ======================================================================== //
+        // ============================ Scalar Reference ========================== //
+        // ======================================================================== //
+        void collideScalar(const world::BodyStore& bodies, const broadphase::BodyPair* pairs, std::size_t begin, std::size_t end, std::vector<Contact>& out) {
+            const float* x = bodies.x();
+            const float* y = bodies.y();
+            const float* r = bodies.radius();
+
+            for (std::size_t p = begin; p < end; p++) {
+                std::uint32_t a = pairs[p].a;
+                std::uint32_t b = pairs[p].b;
+                float dx = x[b] - x[a];
+                float dy = y[b] - y[a];
+                float reach = r[a] + r[b];
+                float distance_sq = dx * dx + dy * dy;
+                if (!(distance_sq < reach * reach)) {
+                    continue;
+                }
+
+                Contact contact;
+                contact.a = a;
+                contact.b = b;
+                float distance = std::sqrt(distance_sq);
+                if (distance > 0.0f) {
+                    contact.normal_x = dx / distance;
+                    contact.normal_y = dy / distance;
+                } else {
+                    // Coincident centres, any direction will do
+                    contact.normal_x = 1.0f;
+                    contact.normal_y = 0.0f;
+                }
+                contact.penetration = reach - distance;
+                float along = r[a] - 0.5f * contact.penetration;
+                contact.point_x = x[a] + contact.normal_x * along;
+                contact.point_y = y[a] + contact.normal_y * along;
+                out.push_back(contact);
+            }
+        }
+
+        /* The SIMD kernels below compute a batch of pairs into these lane arrays,
+        then append the overlapping lanes in pair order. They use the same
+        operations in the same order as collideScalar, so every ISA produces
+        exactly the same contacts.*/
+        struct Lanes {
+            std::uint32_t a[16], b[16];
+            float normal_x[16], normal_y[16], penetration[16], point_x[16], point_y[16];
+        };
+
+        inline void emitLanes(const Lanes& lanes, unsigned mask, std::vector<Contact>& out) {
+            while (mask) {
+                int lane = __builtin_ctz(mask);
+                mask &= mask - 1;
+                out.push_back(Contact{lanes.a[lane], lanes.b[lane], lanes.normal_x[lane], lanes.normal_y[lane],
+                                      lanes.penetration[lane], lanes.point_x[lane], lanes.point_y[lane]});
+            }
+        }
+
+#if SIMD_X86
+        // ======================================================================== //
+        // ================================== SSE2 ================================ //
+        // ======================================================================== //
+        __attribute__((target("sse2")))
+        void collideSse2(const world::BodyStore& bodies, const broadphase::BodyPair* pairs, std::size_t begin, std::size_t end, std::vector<Contact>& out) {
+            const float* x = bodies.x();
+            const float* y = bodies.y();
+            const float* r = bodies.radius();
+            const __m128 zero = _mm_setzero_ps();
+            const __m128 one = _mm_set1_ps(1.0f);
+            const __m128 half = _mm_set1_ps(0.5f);
+            Lanes lanes;
+
+            std::size_t p = begin;
+            for (; p + 4 <= end; p += 4) {
+                for (int l = 0; l < 4; l++) {
+                    lanes.a[l] = pairs[p + l].a;
+                    lanes.b[l] = pairs[p + l].b;
+                }
+                // No gather before AVX2, load each lane by hand
+                __m128 xa = _mm_setr_ps(x[lanes.a[0]], x[lanes.a[1]], x[lanes.a[2]], x[lanes.a[3]]);
+                __m128 ya = _mm_setr_ps(y[lanes.a[0]], y[lanes.a[1]], y[lanes.a[2]], y[lanes.a[3]]);
+                __m128 ra = _mm_setr_ps(r[lanes.a[0]], r[lanes.a[1]], r[lanes.a[2]], r[lanes.a[3]]);
+                __m128 xb = _mm_setr_ps(x[lanes.b[0]], x[lanes.b[1]], x[lanes.b[2]], x[lanes.b[3]]);
+                __m128 yb = _mm_setr_ps(y[lanes.b[0]], y[lanes.b[1]], y[lanes.b[2]], y[lanes.b[3]]);
+                __m128 rb = _mm_setr_ps(r[lanes.b[0]], r[lanes.b[1]], r[lanes.b[2]], r[lanes.b[3]]);
+
+                __m128 dx = _mm_sub_ps(xb, xa);
+                __m128 dy = _mm_sub_ps(yb, ya);
+                __m128 reach = _mm_add_ps(ra, rb);
+                __m128 distance_sq = _mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy));
+                unsigned mask = static_cast<unsigned>(_mm_movemask_ps(_mm_cmplt_ps(distance_sq, _mm_mul_ps(reach, reach))));
+                if (mask == 0) {
+                    continue;
+                }
+
+                __m128 distance = _mm_sqrt_ps(distance_sq);
+                __m128 apart = _mm_cmpgt_ps(distance, zero);
+                __m128 nx = _mm_or_ps(_mm_and_ps(apart, _mm_div_ps(dx, distance)), _mm_andnot_ps(apart, one));
+                __m128 ny = _mm_and_ps(apart, _mm_div_ps(dy, distance));
+                __m128 penetration = _mm_sub_ps(reach, distance);
+                __m128 along = _mm_sub_ps(ra, _mm_mul_ps(half, penetration));
+
+                _mm_storeu_ps(lanes.normal_x, nx);
+                _mm_storeu_ps(lanes.normal_y, ny);
+                _mm_storeu_ps(lanes.penetration, penetration);
+                _mm_storeu_ps(lanes.point_x, _mm_add_ps(xa, _mm_mul_ps(nx, along)));
+                _mm_storeu_ps(lanes.point_y, _mm_add_ps(ya, _mm_mul_ps(ny, along)));
+                emitLanes(lanes, mask, out);
+            }
+            collideScalar(bodies, pairs, p, end, out);
+        }
+
+        // ======================================================================== //
+        // ================================== AVX2 ================================ //
+        // ======================================================================== //
+        __attribute__((target("avx2")))
+        void collideAvx2(const world::BodyStore& bodies, const broadphase::BodyPair* pairs, std::size_t begin, std::size_t end, std::vector<Contact>& out) {
+            const float* x = bodies.x();
+            const float* y = bodies.y();
+            const float* r = bodies.radius();
+            const __m256 zero = _mm256_setzero_ps();
+            const __m256 one = _mm256_set1_ps(1.0f);
+            const __m256 half = _mm256_set1_ps(0.5f);
+            Lanes lanes;
+
+            std::size_t p = begin;
+            for (; p + 8 <= end; p += 8) {
+                for (int l = 0; l < 8; l++) {
+                    lanes.a[l] = pairs[p + l].a;
+                    lanes.b[l] = pairs[p + l].b;
+                }
+                __m256i ia = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(lanes.a));
+                __m256i ib = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(lanes.b));
+                __m256 xa = _mm256_i32gather_ps(x, ia, 4);
+                __m256 ya = _mm256_i32gather_ps(y, ia, 4);
+                __m256 ra = _mm256_i32gather_ps(r, ia, 4);
+                __m256 xb = _mm256_i32gather_ps(x, ib, 4);
+                __m256 yb = _mm256_i32gather_ps(y, ib, 4);
+                __m256 rb = _mm256_i32gather_ps(r, ib, 4);
+
+                __m256 dx = _mm256_sub_ps(xb, xa);
+                __m256 dy = _mm256_sub_ps(yb, ya);
+                __m256 reach = _mm256_add_ps(ra, rb);
+                __m256 distance_sq = _mm256_add_ps(_mm256_mul_ps(dx, dx), _mm256_mul_ps(dy, dy));
+                unsigned mask = static_cast<unsigned>(_mm256_movemask_ps(_mm256_cmp_ps(distance_sq, _mm256_mul_ps(reach, reach), _CMP_LT_OQ)));
+                if (mask == 0) {
+                    continue;
+                }
+
+                __m256 distance = _mm256_sqrt_ps(distance_sq);
+                __m256 apart = _mm256_cmp_ps(distance, zero, _CMP_GT_OQ);
+                __m256 nx = _mm256_blendv_ps(one, _mm256_div_ps(dx, distance), apart);
+                __m256 ny = _mm256_blendv_ps(zero, _mm256_div_ps(dy, distance), apart);
+                __m256 penetration = _mm256_sub_ps(reach, distance);
+                __m256 along = _mm256_sub_ps(ra, _mm256_mul_ps(half, penetration));
+
+                _mm256_storeu_ps(lanes.normal_x, nx);
+                _mm256_storeu_ps(lanes.normal_y, ny);
+                _mm256_storeu_ps(lanes.penetration, penetration);
+                _mm256_storeu_ps(lanes.point_x, _mm256_add_ps(xa, _mm256_mul_ps(nx, along)));
+                _mm256_storeu_ps(lanes.point_y, _mm256_add_ps(ya, _mm256_mul_ps(ny, along)));
+                emitLanes(lanes, mask, out);
+            }
+            collideScalar(bodies, pairs, p, end, out);
+            _mm256_zeroupper();  // see integrateAvx2 in integrate.cpp
+        }
+
+        // ======================================================================== //
+        // ================================= AVX-512 ============================== //
+        // ======================================================================== //
+        __attribute__((target("avx512f")))
+        void collideAvx512(const world::BodyStore& bodies, const broadphase::BodyPair* pairs, std::size_t begin, std::size_t end, std::vector<Contact>& out) {
+            const float* x = bodies.x();
+            const float* y = bodies.y();
+            const float* r = bodies.radius();
+            const __m512 zero = _mm512_setzero_ps();
+            const __m512 one = _mm512_set1_ps(1.0f);
+            const __m512 half = _mm512_set1_ps(0.5f);
+            const __mmask16 all = 0xFFFF;
+            Lanes lanes;
+
+            std::size_t p = begin;
+            for (; p + 16 <= end; p += 16) {
+                for (int l = 0; l < 16; l++) {
+                    lanes.a[l] = pairs[p + l].a;
+                    lanes.b[l] = pairs[p + l].b;
+                }
+                __m512i ia = _mm512_loadu_si512(lanes.a);
+                __m512i ib = _mm512_loadu_si512(lanes.b);
+                // Masked forms with a zero source: the plain gather and sqrt pass an undefined
+                // register through, which GCC 12 reports as uninitialised when optimising
+                __m512 xa = _mm512_mask_i32gather_ps(zero, all, ia, x, 4);
+                __m512 ya = _mm512_mask_i32gather_ps(zero, all, ia, y, 4);
+                __m512 ra = _mm512_mask_i32gather_ps(zero, all, ia, r, 4);
+                __m512 xb = _mm512_mask_i32gather_ps(zero, all, ib, x, 4);
+                __m512 yb = _mm512_mask_i32gather_ps(zero, all, ib, y, 4);
+                __m512 rb = _mm512_mask_i32gather_ps(zero, all, ib, r, 4);
+
+                __m512 dx = _mm512_sub_ps(xb, xa);
+                __m512 dy = _mm512_sub_ps(yb, ya);
+                __m512 reach = _mm512_add_ps(ra, rb);
+                __m512 distance_sq = _mm512_add_ps(_mm512_mul_ps(dx, dx), _mm512_mul_ps(dy, dy));
+                __mmask16 mask = _mm512_cmp_ps_mask(distance_sq, _mm512_mul_ps(reach, reach), _CMP_LT_OQ);
+                if (mask == 0) {
+                    continue;
+                }
+
+                __m512 distance = _mm512_maskz_sqrt_ps(all, distance_sq);
+                __mmask16 apart = _mm512_cmp_ps_mask(distance, zero, _CMP_GT_OQ);
+                __m512 nx = _mm512_mask_div_ps(one, apart, dx, distance);
+                __m512 ny = _mm512_mask_div_ps(zero, apart, dy, distance);
+                __m512 penetration = _mm512_sub_ps(reach, distance);
+                __m512 along = _mm512_sub_ps(ra, _mm512_mul_ps(half, penetration));
+
+                _mm512_storeu_ps(lanes.normal_x, nx);
+                _mm512_storeu_ps(lanes.normal_y, ny);
+                _mm512_storeu_ps(lanes.penetration, penetration);
+                _mm512_storeu_ps(lanes.point_x, _mm512_add_ps(xa, _mm512_mul_ps(nx, along)));
+                _mm512_storeu_ps(lanes.point_y, _mm512_add_ps(ya, _mm512_mul_ps(ny, along)));
+                emitLanes(lanes, mask, out);
+            }
+            collideScalar(bodies, pairs, p, end, out);
+            _mm256_zeroupper();
+        }
+#endif
+
+        void collideRange(const world::BodyStore& bodies, const broadphase::BodyPair* pairs, std::size_t begin, std::size_t end, std::vector<Contact>& out) {
+            switch (simd::active()) {
+#if SIMD_X86
+                case simd::Level::AVX512: collideAvx512(bodies, pairs, begin, end, out); return;
+                case simd::Level::AVX2: collideAvx2(bodies, pairs, begin, end, out); return;
+                case simd::Level::SSE2: collideSse2(bodies, pairs, begin, end, out); return;
+#endif
+                default: collideScalar(bodies, pairs, begin, end, out); return;
+            }
+        }
+    }
+
+    void NarrowPhase::collide(const world::BodyStore& bodies, const std::vector<broadphase::BodyPair>& pairs,
+                              std::vector<Contact>& contacts, threading::ThreadPool* pool) {
+        contacts.clear();
+        const std::size_t chunk_count = (pairs.size() + GRAIN - 1) / GRAIN;
+        if (chunk_contacts.size() < chunk_count) {
+            chunk_contacts.resize(chunk_count);
+        }
+
+        threading::parallelFor(pool, 0, pairs.size(), GRAIN, [&](std::size_t begin, std::size_t end, unsigned) {
+            std::vector<Contact>& out = chunk_contacts[begin / GRAIN];
+            out.clear();
+            collideRange(bodies, pairs.data(), begin, end, out);
+        });
+
+        for (std::size_t chunk = 0; chunk < chunk_count; chunk++) {
+            contacts.insert(contacts.end(), chunk_contacts[chunk].begin(), chunk_contacts[chunk].end());
+        }
+    }
+
+} // namespace narrowphase
@@ -1,62 +1,123 @@
 #include "objects.h"
 #include <cmath> // For physics calculations
 #include <vector.h>
+#include <integrate.h>
 
 namespace objects {
 
     // ======================================================================== //
     // =============================== Constructors =========================== //
     // ======================================================================== //
-    Circle::Circle(vector::Vector<float, 2> pos, float radius, float mass, bool is_static, float restitution) 
+    Circle::Circle(vector::Vector<float, 2> pos, float radius, float mass, bool is_static, float restitution)
     : position(pos), radius(radius), mass(mass), is_static(is_static), restitution(restitution), velocity(), force() {}
 
+    Circle::Circle(world::BodyStore& store, world::BodyHandle handle)
+    : position(), radius(0.0f), mass(0.0f), is_static(false), restitution(0.0f), velocity(), force(), store(&store), handle(handle) {}
+
     // ======================================================================== //
     // ================================== Getters ============================= //
     // ======================================================================== //
-    vector::Vector<float, 2> Circle::getPosition() const { return position;}
-    float Circle::getRadius() const { return radius;}
-    vector::Vector<float, 2> Circle::getVelocity() const { return velocity;}
-    float Circle::getMass() const { return mass;}
-    bool Circle::isStatic() const { return is_static;}
-    float Circle::getRestitution() const { return restitution;}
+    vector::Vector<float, 2> Circle::getPosition() const {
+        if (store) {
+            std::uint32_t i = store->indexOf(handle);
+            return vector::Vector<float, 2>(store->x()[i], store->y()[i]);
+        }
+        return position;
+    }
+    float Circle::getRadius() const { return store ? store->radius()[store->indexOf(handle)] : radius;}
+    vector::Vector<float, 2> Circle::getVelocity() const {
+        if (store) {
+            std::uint32_t i = store->indexOf(handle);
+            return vector::Vector<float, 2>(store->vx()[i], store->vy()[i]);
+        }
+        return velocity;
+    }
+    float Circle::getMass() const { return store ? store->mass()[store->indexOf(handle)] : mass;}
+    bool Circle::isStatic() const { return store ? (store->flags()[store->indexOf(handle)] & world::BODY_STATIC) != 0 : is_static;}
+    float Circle::getRestitution() const { return store ? store->restitution()[store->indexOf(handle)] : restitution;}
+    world::BodyHandle Circle::getHandle() const { return handle;}
+    bool Circle::isView() const { return store != nullptr;}
+    bool Circle::isValid() const { return !store || store->isValid(handle);}
+    bool Circle::isSleeping() const { return store ? store->isSleeping(store->indexOf(handle)) : false;}
 
     // ======================================================================== //
     // ================================== Setters ============================= //
     // ======================================================================== //
-    
+
     // Position Setters
     void Circle::setPosition(float newX, float newY) {
+        if (store) {
+            store->setPosition(store->indexOf(handle), newX, newY);
+            return;
+        }
         position[0] = newX;
         position[1] = newY;
     }
-    void Circle::setPosition(const vector::Vector<float, 2>& newPos){ position = newPos; }
+    void Circle::setPosition(const vector::Vector<float, 2>& newPos){
+        if (store) {
+            setPosition(newPos[0], newPos[1]);
+            return;
+        }
+        position = newPos;
+    }
 
     // Velocity Setters
     void Circle::setVelocity(float newVx, float newVy) {
+        if (store) {
+            store->setVelocity(store->indexOf(handle), newVx, newVy);
+            return;
+        }
         velocity[0] = newVx;
         velocity[1] = newVy;
     }
-    void Circle::setVelocity(const vector::Vector<float, 2>& newVel){ velocity = newVel;}
+    void Circle::setVelocity(const vector::Vector<float, 2>& newVel){
+        if (store) {
+            setVelocity(newVel[0], newVel[1]);
+            return;
+        }
+        velocity = newVel;
+    }
 
     // Force Setters
     void Circle::setForce(float newFx, float newFy) {
-        force[0] = newFx;
-        force[1] = newFy;
+        if (store) {
+            store->setForce(store->indexOf(handle), newFx, newFy);
+            return;
+        }
+        if (!is_static) {
+            force[0] = newFx;
+            force[1] = newFy;
+        }
     }
-    void Circle::setForce(const vector::Vector<float, 2>& newForce){ force = newForce; }
+    void Circle::setForce(const vector::Vector<float, 2>& newForce){ setForce(newForce[0], newForce[1]); }
 
     void Circle::applyForce(float forceX, float forceY) {
+        if (store) {
+            store->applyForce(store->indexOf(handle), forceX, forceY);
+            return;
+        }
         if (!is_static) {
             force[0] += forceX;
             force[1] += forceY;
         }
     }
-    void Circle::applyForce(const vector::Vector<float, 2>& appliedForce){ force += appliedForce; }; 
+    void Circle::applyForce(const vector::Vector<float, 2>& appliedForce){ applyForce(appliedForce[0], appliedForce[1]); }
 
     // ======================================================================== //
     // ============================== Update Functions ======================== //
     // ======================================================================== //
     void Circle::update(float deltaTime) {
+        if (store) {
+            // Same kernel World::step applies to every body
+            std::uint32_t i = store->indexOf(handle);
+            world::integrateRange(*store, i, i + 1, deltaTime);
+            store->clearForces(i, i + 1);
+            return;
+        }
+        if (is_static) {
+            return;
+        }
+
         // calculate accelerations due to forces
         vector::Vector<float, 2> acceleration;
         acceleration[0] = force[0] / mass;
@@ -70,7 +131,9 @@ namespace objects {
         position[0] += velocity[0] * deltaTime;
         position[1] += velocity[1] * deltaTime;
 
+        // Forces act for one update, so they don't keep accelerating the circle
+        force = vector::Vector<float, 2>();
     }
 
 
-} // Namespace objects
\ No newline at end of file
+} // Namespace objects
@@ -0,0 +1,171 @@
+#include "profiler.h"
+#include <algorithm>
+#include <cstdio>
+#if SIMD_X86
+#include <cpuid.h>
+#endif
+
+namespace profiling {
+
+    namespace {
+
+        const double CALIBRATION_SECONDS = 0.005;   // spin used to measure the tick rate when the CPU doesn't report it
+
+        /* Ticks are steady_clock nanoseconds without a time stamp counter. With
+        one, CPUID leaf 0x15 gives its frequency as the core crystal clock times
+        a ratio on CPUs that report both; otherwise the ticks elapsed over a
+        short spin on steady_clock are counted.*/
+        double measureSecondsPerTick() {
+#if SIMD_X86
+            unsigned eax, ebx, ecx, edx;
+            if (__get_cpuid_max(0, nullptr) >= 0x15 && __get_cpuid_count(0x15, 0, &eax, &ebx, &ecx, &edx) && eax != 0 && ebx != 0 && ecx != 0) {
+                return static_cast<double>(eax) / (static_cast<double>(ecx) * ebx);
+            }
+            const auto origin_time = std::chrono::steady_clock::now();
+            const std::uint64_t origin_ticks = ticks();
+            double seconds;
+            std::uint64_t now;
+            do {
+                seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - origin_time).count();
+                now = ticks();
+            } while (seconds < CALIBRATION_SECONDS);
+            return seconds / static_cast<double>(now - origin_ticks);
+#else
+            return 1e-9;
+#endif
+        }
+
+        double secondsPerTick() {
+            static const double rate = measureSecondsPerTick();  // once per process, thread-safe
+            return rate;
+        }
+
+    }
+
+    const char* stageName(Stage stage) {
+        switch (stage) {
+            case Stage::Wake: return "wake";
+            case Stage::Forces: return "forces";
+            case Stage::Integrate: return "integrate";
+            case Stage::BroadPhase: return "broad-phase";
+            case Stage::NarrowPhase: return "narrow-phase";
+            case Stage::Solve: return "solve";
+            case Stage::Islands: return "islands";
+            case Stage::Hash: return "state-hash";
+            default: return "unknown";
+        }
+    }
+
+    // ======================================================================== //
+    // =============================== Constructors =========================== //
+    // ======================================================================== //
+    Profiler::Profiler(unsigned thread_count) : origin_ticks(ticks()), seconds_per_tick(secondsPerTick()) {
+        history.resize(FRAME_HISTORY);
+        history_end.resize(FRAME_HISTORY);
+        setThreadCount(thread_count);
+    }
+
+    void Profiler::setThreadCount(unsigned thread_count) {
+        rings.assign(thread_count == 0 ? 1 : thread_count, Ring());
+        for (Ring& ring : rings) {
+            ring.events.resize(EVENTS_PER_THREAD);
+        }
+    }
+
+    // ======================================================================== //
+    // ================================== Frames ============================== //
+    // ======================================================================== //
+    void Profiler::beginFrame() {
+        frames++;
+        std::fill(stage_ticks, stage_ticks + STAGE_COUNT, std::uint64_t(0));
+#if PROFILING
+        frame_start = ticks();
+#endif
+    }
+
+    void Profiler::endFrame(std::uint32_t bodies, std::uint32_t awake_bodies, std::uint32_t pairs, std::uint32_t contacts, std::uint32_t solver_iterations,
+                            std::uint64_t state_hash) {
+        const std::size_t slot = (frames - 1) % FRAME_HISTORY;
+        FrameStats& stats = history[slot];
+        stats = FrameStats();
+        stats.frame = frames;
+        std::uint64_t frame_end = ticks();
+        history_end[slot] = frame_end;
+#if PROFILING
+        stats.step_seconds = toSeconds(frame_end - frame_start);
+        for (std::size_t s = 0; s < STAGE_COUNT; s++) {
+            stats.stage_seconds[s] = toSeconds(stage_ticks[s]);
+        }
+        // Kept as a span too so the trace shows whole steps
+        rings[0].events[rings[0].written % EVENTS_PER_THREAD] = Event{frame_start, frame_end, static_cast<std::uint32_t>(frames), Stage::Count, false};
+        rings[0].written++;
+#endif
+        stats.bodies = bodies;
+        stats.awake_bodies = awake_bodies;
+        stats.pairs = pairs;
+        stats.contacts = contacts;
+        stats.solver_iterations = solver_iterations;
+        stats.state_hash = state_hash;
+    }
+
+    // ======================================================================== //
+    // ================================== Results ============================= //
+    // ======================================================================== //
+    const FrameStats& Profiler::lastFrame() const {
+        static const FrameStats empty;
+        return frames == 0 ? empty : history[(frames - 1) % FRAME_HISTORY];
+    }
+
+    std::size_t Profiler::frameCount() const { return static_cast<std::size_t>(std::min<std::uint64_t>(frames, FRAME_HISTORY)); }
+
+    const FrameStats& Profiler::frameAt(std::size_t index) const {
+        std::uint64_t first = frames - frameCount();
+        return history[(first + index) % FRAME_HISTORY];
+    }
+
+    void Profiler::clear() {
+        for (Ring& ring : rings) {
+            ring.written = 0;
+        }
+        frames = 0;
+    }
+
+    /* Spans become complete ("X") events with one track per pool thread, whole
+    steps included; counters become counter ("C") events at the end of each
+    step still in the history. Times are microseconds since construction.*/
+    bool Profiler::writeChromeTrace(const char* path) const {
+        std::FILE* file = std::fopen(path, "w");
+        if (!file) {
+            return false;
+        }
+        const double us_per_tick = seconds_per_tick * 1e6;
+        auto microseconds = [&](std::uint64_t tick) { return static_cast<double>(static_cast<std::int64_t>(tick - origin_ticks)) * us_per_tick; };
+
+        std::fprintf(file, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+        std::fprintf(file, "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"args\":{\"name\":\"World::step\"}}");
+        for (std::size_t worker = 0; worker < rings.size(); worker++) {
+            std::fprintf(file, ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%zu,\"args\":{\"name\":\"%s %zu\"}}",
+                         worker, worker == 0 ? "stepping thread" : "worker", worker);
+
+            const Ring& ring = rings[worker];
+            std::uint64_t held = std::min<std::uint64_t>(ring.written, EVENTS_PER_THREAD);
+            for (std::uint64_t e = ring.written - held; e < ring.written; e++) {
+                const Event& event = ring.events[e % EVENTS_PER_THREAD];
+                const char* name = event.stage == Stage::Count ? "step" : stageName(event.stage);
+                std::fprintf(file, ",\n{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%zu,\"ts\":%.3f,\"dur\":%.3f,\"args\":{\"frame\":%u}}",
+                             name, event.chunk ? "chunk" : "stage", worker, microseconds(event.start),
+                             microseconds(event.end) - microseconds(event.start), event.frame);
+            }
+        }
+
+        std::uint64_t first = frames - frameCount();
+        for (std::uint64_t f = first; f < frames; f++) {
+            const FrameStats& stats = history[f % FRAME_HISTORY];
+            std::fprintf(file, ",\n{\"name\":\"counters\",\"ph\":\"C\",\"pid\":1,\"ts\":%.3f,\"args\":{\"bodies\":%u,\"awake\":%u,\"pairs\":%u,\"contacts\":%u,\"solver iterations\":%u}}",
+                         microseconds(history_end[f % FRAME_HISTORY]), stats.bodies, stats.awake_bodies, stats.pairs, stats.contacts, stats.solver_iterations);
+        }
+        std::fprintf(file, "\n]}\n");
+        return std::fclose(file) == 0;
+    }
+
+} // namespace profiling
@@ -0,0 +1,307 @@
+#include "recorder.h"
+#include <cmath>
+#include <cstring>
+#include <sys/stat.h>
+
+namespace recording {
+
+    namespace {
+
+        const char MAGIC[8] = {'P', 'H', 'Y', 'S', 'R', 'E', 'C', '1'};
+
+        // Nearest multiple of step, clamped to the int32 range (NaN becomes 0)
+        inline std::int32_t quantise(float value, float inv_step) {
+            double scaled = std::nearbyint(static_cast<double>(value) * inv_step);
+            if (!(scaled > -2147483648.0)) {
+                return scaled < 0.0 ? INT32_MIN : 0;
+            }
+            return scaled < 2147483647.0 ? static_cast<std::int32_t>(scaled) : INT32_MAX;
+        }
+
+        // Zigzag maps small magnitudes of either sign to small unsigned values: 0, -1, 1, -2 -> 0, 1, 2, 3
+        inline std::uint64_t zigzag(std::int64_t value) { return (static_cast<std::uint64_t>(value) << 1) ^ static_cast<std::uint64_t>(value >> 63); }
+        inline std::int64_t unzigzag(std::uint64_t value) { return static_cast<std::int64_t>(value >> 1) ^ -static_cast<std::int64_t>(value & 1); }
+
+        inline void putVarint(std::vector<unsigned char>& out, std::uint64_t value) {
+            while (value >= 0x80) {
+                out.push_back(static_cast<unsigned char>(value | 0x80));
+                value >>= 7;
+            }
+            out.push_back(static_cast<unsigned char>(value));
+        }
+
+        inline bool getVarint(const unsigned char*& in, const unsigned char* end, std::uint64_t& value) {
+            value = 0;
+            for (int shift = 0; in < end && shift < 64; shift += 7) {
+                unsigned char byte = *in++;
+                value |= static_cast<std::uint64_t>(byte & 0x7F) << shift;
+                if (!(byte & 0x80)) {
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        // Appends the differences between current and previous, or current itself when previous is null
+        void encodeChannel(std::vector<unsigned char>& out, std::vector<std::int32_t>& current, std::vector<std::int32_t>* previous) {
+            const std::size_t count = current.size();
+            std::size_t i = 0;
+            while (i < count) {
+                std::int64_t delta = previous ? static_cast<std::int64_t>(current[i]) - (*previous)[i] : current[i];
+                if (delta != 0) {
+                    putVarint(out, zigzag(delta));
+                    i++;
+                    continue;
+                }
+                std::size_t run = 1;
+                while (i + run < count && current[i + run] == (previous ? (*previous)[i + run] : 0)) {
+                    run++;
+                }
+                putVarint(out, 0);
+                putVarint(out, run - 1);
+                i += run;
+            }
+        }
+
+        // Inverse of encodeChannel, values holds the previous frame's channel for a delta
+        bool decodeChannel(const unsigned char*& in, const unsigned char* end, std::vector<std::int32_t>& values, bool delta) {
+            const std::size_t count = values.size();
+            std::size_t i = 0;
+            while (i < count) {
+                std::uint64_t code;
+                if (!getVarint(in, end, code)) {
+                    return false;
+                }
+                if (code != 0) {
+                    std::int64_t value = unzigzag(code) + (delta ? values[i] : 0);
+                    values[i++] = static_cast<std::int32_t>(value);
+                    continue;
+                }
+                std::uint64_t run;
+                if (!getVarint(in, end, run) || run >= count - i) {
+                    return false;
+                }
+                for (std::uint64_t r = 0; r <= run; r++, i++) {
+                    values[i] = delta ? values[i] : 0;
+                }
+            }
+            return true;
+        }
+
+    }
+
+    // ======================================================================== //
+    // ================================= Recorder ============================= //
+    // ======================================================================== //
+    bool Recorder::open(const char* path, const RecorderSettings& settings) {
+        close();
+        file = std::fopen(path, "wb");
+        if (!file) {
+            return false;
+        }
+        config = settings;
+        if (config.queue_frames == 0) {
+            config.queue_frames = 1;
+        }
+
+        FileHeader header = {};
+        std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+        header.version = VERSION;
+        header.keyframe_interval = config.keyframe_interval;
+        header.position_step = config.position_step;
+        header.velocity_step = config.velocity_step;
+        if (std::fwrite(&header, sizeof(header), 1, file) != 1) {
+            std::fclose(file);
+            file = nullptr;
+            return false;
+        }
+
+        captures.assign(config.queue_frames, Capture());
+        free_captures.clear();
+        for (std::size_t c = 0; c < captures.size(); c++) {
+            free_captures.push_back(c);
+        }
+        ready_captures.clear();
+        ready_captures.reserve(captures.size());  // so capture() never allocates for the queue
+        stopping = false;
+        next_frame = 0;
+        dropped = 0;
+        written = sizeof(header);
+        failed = false;
+        have_previous = false;
+        io_thread = std::thread(&Recorder::ioLoop, this);
+        return true;
+    }
+
+    void Recorder::close() {
+        if (!file) {
+            return;
+        }
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            stopping = true;
+        }
+        ready_signal.notify_all();
+        io_thread.join();
+        std::fclose(file);
+        file = nullptr;
+    }
+
+    bool Recorder::capture(const world::BodyStore& bodies) {
+        const std::uint64_t frame = next_frame++;
+        std::size_t index;
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            if (free_captures.empty() || failed || bodies.size() > MAX_FRAME_BODIES) {
+                dropped++;
+                return false;
+            }
+            index = free_captures.back();
+            free_captures.pop_back();
+        }
+
+        // The buffer belongs to this thread until it is queued
+        Capture& capture = captures[index];
+        const std::size_t count = bodies.size();
+        capture.frame = frame;
+        capture.layout = bodies.layoutVersion();
+        capture.x.assign(bodies.x(), bodies.x() + count);
+        capture.y.assign(bodies.y(), bodies.y() + count);
+        capture.vx.assign(bodies.vx(), bodies.vx() + count);
+        capture.vy.assign(bodies.vy(), bodies.vy() + count);
+
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            ready_captures.push_back(index);
+        }
+        ready_signal.notify_one();
+        return true;
+    }
+
+    void Recorder::ioLoop() {
+        for (;;) {
+            std::size_t index;
+            {
+                std::unique_lock<std::mutex> guard(lock);
+                ready_signal.wait(guard, [this] { return stopping || !ready_captures.empty(); });
+                if (ready_captures.empty()) {
+                    return;  // stopping, and everything queued has been written
+                }
+                index = ready_captures.front();
+                ready_captures.erase(ready_captures.begin());  // at most queue_frames long
+            }
+            if (!failed) {
+                writeFrame(captures[index]);
+            }
+            {
+                std::lock_guard<std::mutex> guard(lock);
+                free_captures.push_back(index);
+            }
+        }
+    }
+
+    void Recorder::writeFrame(const Capture& capture) {
+        const std::size_t count = capture.x.size();
+        const bool keyframe = !have_previous || previous[0].size() != count || capture.layout != previous_layout ||
+                              since_keyframe + 1 >= config.keyframe_interval;
+
+        const std::vector<float>* channels[4] = {&capture.x, &capture.y, &capture.vx, &capture.vy};
+        const float inv_steps[4] = {1.0f / config.position_step, 1.0f / config.position_step, 1.0f / config.velocity_step, 1.0f / config.velocity_step};
+        payload.clear();
+        for (int c = 0; c < 4; c++) {
+            quantised.resize(count);
+            const float* values = channels[c]->data();
+            for (std::size_t i = 0; i < count; i++) {
+                quantised[i] = quantise(values[i], inv_steps[c]);
+            }
+            encodeChannel(payload, quantised, keyframe ? nullptr : &previous[c]);
+            previous[c].swap(quantised);
+        }
+
+        FrameHeader header{keyframe ? 1u : 0u, static_cast<std::uint32_t>(count), capture.frame, payload.size()};
+        bool ok = std::fwrite(&header, sizeof(header), 1, file) == 1 && (payload.empty() || std::fwrite(payload.data(), 1, payload.size(), file) == payload.size());
+        if (!ok) {
+            failed = true;
+            return;
+        }
+        written += sizeof(header) + payload.size();
+        have_previous = true;
+        previous_layout = capture.layout;
+        since_keyframe = keyframe ? 0 : since_keyframe + 1;
+    }
+
+    // ======================================================================== //
+    // ================================== Reader ============================== //
+    // ======================================================================== //
+    bool Reader::open(const char* path) {
+        close();
+        file = std::fopen(path, "rb");
+        if (!file) {
+            return false;
+        }
+#ifdef _WIN32
+        struct _stat64 info;
+        bool sized = _fstat64(_fileno(file), &info) == 0;
+#else
+        struct stat info;
+        bool sized = fstat(fileno(file), &info) == 0;
+#endif
+        if (!sized || info.st_size < static_cast<std::int64_t>(sizeof(header)) || std::fread(&header, sizeof(header), 1, file) != 1 ||
+            std::memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0 || header.version != VERSION) {
+            close();
+            return false;
+        }
+        remaining = static_cast<std::uint64_t>(info.st_size) - sizeof(header);
+        for (std::vector<std::int32_t>& channel : previous) {
+            channel.clear();
+        }
+        return true;
+    }
+
+    void Reader::close() {
+        if (file) {
+            std::fclose(file);
+        }
+        file = nullptr;
+        remaining = 0;
+    }
+
+    bool Reader::next(Frame& frame) {
+        FrameHeader frame_header;
+        if (!file || remaining < sizeof(frame_header) || std::fread(&frame_header, sizeof(frame_header), 1, file) != 1) {
+            return false;
+        }
+        remaining -= sizeof(frame_header);
+
+        // Sizes come from the file, so check them before allocating anything
+        const bool delta = frame_header.keyframe == 0;
+        const std::size_t count = frame_header.body_count;
+        if (frame_header.payload_bytes > remaining || count > MAX_FRAME_BODIES || (delta && previous[0].size() != count)) {
+            return false;
+        }
+        payload.resize(static_cast<std::size_t>(frame_header.payload_bytes));
+        if (!payload.empty() && std::fread(payload.data(), 1, payload.size(), file) != payload.size()) {
+            return false;
+        }
+        remaining -= payload.size();
+
+        const unsigned char* in = payload.data();
+        const unsigned char* end = in + payload.size();
+        std::vector<float>* channels[4] = {&frame.x, &frame.y, &frame.vx, &frame.vy};
+        const float steps[4] = {header.position_step, header.position_step, header.velocity_step, header.velocity_step};
+        for (int c = 0; c < 4; c++) {
+            previous[c].resize(count);
+            if (!decodeChannel(in, end, previous[c], delta)) {
+                return false;
+            }
+            channels[c]->resize(count);
+            for (std::size_t i = 0; i < count; i++) {
+                (*channels[c])[i] = static_cast<float>(previous[c][i] * static_cast<double>(steps[c]));
+            }
+        }
+        frame.frame = frame_header.frame;
+        frame.keyframe = !delta;
+        return true;
+    }
+
+} // namespace recording
@@ -0,0 +1,54 @@
+#include "simd.h"
+#include <atomic>
+
+namespace simd {
+
+    namespace {
+        Level queryCpu() {
+#if SIMD_X86
+            // __builtin_cpu_supports reads CPUID (and XGETBV for OS register support)
+            __builtin_cpu_init();
+            if (__builtin_cpu_supports("avx512f")) {
+                return Level::AVX512;
+            }
+            if (__builtin_cpu_supports("avx2")) {
+                return Level::AVX2;
+            }
+            if (__builtin_cpu_supports("sse2")) {
+                return Level::SSE2;
+            }
+#endif
+            return Level::Scalar;
+        }
+
+        std::atomic<Level>& activeLevel() {
+            static std::atomic<Level> level(detect());
+            return level;
+        }
+    }
+
+    Level detect() {
+        static const Level detected = queryCpu();
+        return detected;
+    }
+
+    Level active() { return activeLevel().load(std::memory_order_relaxed); }
+
+    void setLevel(Level level) {
+        if (level > detect()) {
+            level = detect();
+        }
+        activeLevel().store(level, std::memory_order_relaxed);
+    }
+
+    const char* name(Level level) {
+        switch (level) {
+            case Level::Scalar: return "scalar";
+            case Level::SSE2: return "sse2";
+            case Level::AVX2: return "avx2";
+            case Level::AVX512: return "avx512";
+        }
+        return "unknown";
+    }
+
+} // namespace simd
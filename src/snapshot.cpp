@@ -0,0 +1,180 @@
+#include "snapshot.h"
+#include <cstdio>
+#include <cstring>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace snapshot {
+
+    namespace {
+
+        const char MAGIC[8] = {'P', 'H', 'Y', 'S', 'S', 'N', 'A', 'P'};
+        const std::uint32_t BYTE_ORDER = 0x01020304u;
+
+        std::uint64_t alignUp(std::uint64_t offset) { return (offset + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT; }
+
+        // Sizes of the elements of every array, in ArrayId order
+        const std::uint32_t ELEMENT_SIZES[ARRAY_COUNT] = {
+            sizeof(float), sizeof(float), sizeof(float), sizeof(float), sizeof(float), sizeof(float), sizeof(float),
+            sizeof(float), sizeof(float), sizeof(float), sizeof(std::uint32_t), sizeof(std::uint32_t), sizeof(std::uint32_t),
+        };
+
+    }
+
+    // ======================================================================== //
+    // ================================== Saving ============================== //
+    // ======================================================================== //
+    bool save(const world::BodyStore& bodies, const char* path) {
+        const void* sources[ARRAY_COUNT] = {
+            bodies.x(), bodies.y(), bodies.vx(), bodies.vy(), bodies.fx(), bodies.fy(), bodies.invMass(),
+            bodies.mass(), bodies.radius(), bodies.restitution(), bodies.flags(), bodies.restSteps(), bodies.islandIds(),
+        };
+        const std::uint64_t count = bodies.size();
+
+        ArrayEntry table[ARRAY_COUNT];
+        std::uint64_t offset = alignUp(sizeof(Header) + sizeof(table));
+        for (std::uint32_t a = 0; a < ARRAY_COUNT; a++) {
+            table[a] = ArrayEntry{a, ELEMENT_SIZES[a], offset, count * ELEMENT_SIZES[a]};
+            offset = alignUp(offset + table[a].bytes);
+        }
+
+        Header header = {};
+        std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+        header.version = VERSION;
+        header.byte_order = BYTE_ORDER;
+        header.body_count = count;
+        header.file_size = offset;
+        header.table_offset = sizeof(Header);
+        header.array_count = ARRAY_COUNT;
+        header.alignment = ALIGNMENT;
+
+        std::FILE* file = std::fopen(path, "wb");
+        if (!file) {
+            return false;
+        }
+        static const unsigned char padding[ALIGNMENT] = {};
+        bool ok = std::fwrite(&header, sizeof(header), 1, file) == 1 && std::fwrite(table, sizeof(table), 1, file) == 1;
+        std::uint64_t written = sizeof(header) + sizeof(table);
+        for (std::uint32_t a = 0; a < ARRAY_COUNT && ok; a++) {
+            ok = std::fwrite(padding, 1, table[a].offset - written, file) == table[a].offset - written;
+            ok = ok && (count == 0 || std::fwrite(sources[a], ELEMENT_SIZES[a], count, file) == count);
+            written = table[a].offset + table[a].bytes;
+        }
+        ok = ok && std::fwrite(padding, 1, header.file_size - written, file) == header.file_size - written;
+        return std::fclose(file) == 0 && ok;
+    }
+
+    // ======================================================================== //
+    // ================================== Mapping ============================= //
+    // ======================================================================== //
+    bool View::open(const char* path) {
+        close();
+
+#ifdef _WIN32
+        HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (file == INVALID_HANDLE_VALUE) {
+            return false;
+        }
+        LARGE_INTEGER size;
+        HANDLE map = nullptr;
+        if (GetFileSizeEx(file, &size) && size.QuadPart >= static_cast<LONGLONG>(sizeof(Header))) {
+            map = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        }
+        CloseHandle(file);  // the mapping keeps the file open
+        if (!map) {
+            return false;
+        }
+        const void* base = MapViewOfFile(map, FILE_MAP_READ, 0, 0, 0);
+        if (!base) {
+            CloseHandle(map);
+            return false;
+        }
+        data = static_cast<const unsigned char*>(base);
+        length = static_cast<std::size_t>(size.QuadPart);
+        mapping = map;
+#else
+        int file = ::open(path, O_RDONLY);
+        if (file < 0) {
+            return false;
+        }
+        struct stat info;
+        void* base = MAP_FAILED;
+        if (fstat(file, &info) == 0 && info.st_size >= static_cast<off_t>(sizeof(Header))) {
+            base = mmap(nullptr, static_cast<std::size_t>(info.st_size), PROT_READ, MAP_SHARED, file, 0);
+        }
+        ::close(file);  // the mapping keeps the file open
+        if (base == MAP_FAILED) {
+            return false;
+        }
+        data = static_cast<const unsigned char*>(base);
+        length = static_cast<std::size_t>(info.st_size);
+#endif
+
+        /* Only the header and table are read here, the arrays are used where they lie.
+        Every size is checked by dividing the bytes available rather than
+        multiplying what the file claims, which a crafted file could overflow.*/
+        const Header* header = reinterpret_cast<const Header*>(data);
+        bool valid = std::memcmp(header->magic, MAGIC, sizeof(MAGIC)) == 0 && header->version == VERSION &&
+                     header->byte_order == BYTE_ORDER && header->file_size == length && header->alignment == ALIGNMENT &&
+                     header->table_offset % alignof(ArrayEntry) == 0 && header->table_offset <= length &&
+                     header->array_count <= (length - header->table_offset) / sizeof(ArrayEntry) && header->body_count <= length;
+        if (valid) {
+            count = static_cast<std::size_t>(header->body_count);
+            const ArrayEntry* table = reinterpret_cast<const ArrayEntry*>(data + header->table_offset);
+            for (std::uint32_t e = 0; e < header->array_count && valid; e++) {
+                const ArrayEntry& entry = table[e];
+                if (entry.id >= ARRAY_COUNT) {
+                    continue;  // written by a newer version, not needed here
+                }
+                valid = entry.element_size == ELEMENT_SIZES[entry.id] && entry.offset % ALIGNMENT == 0 && entry.offset <= length &&
+                        count <= (length - entry.offset) / entry.element_size && entry.bytes == count * entry.element_size;
+                arrays[entry.id] = data + entry.offset;
+            }
+            for (std::uint32_t a = 0; a < ARRAY_COUNT && valid; a++) {
+                valid = arrays[a] != nullptr;
+            }
+        }
+        if (!valid) {
+            close();
+        }
+        return valid;
+    }
+
+    void View::close() {
+        if (data) {
+#ifdef _WIN32
+            UnmapViewOfFile(data);
+            CloseHandle(static_cast<HANDLE>(mapping));
+#else
+            munmap(const_cast<unsigned char*>(data), length);
+#endif
+        }
+        data = nullptr;
+        length = 0;
+        mapping = nullptr;
+        count = 0;
+        std::memset(arrays, 0, sizeof(arrays));
+    }
+
+    // ======================================================================== //
+    // ================================== Loading ============================= //
+    // ======================================================================== //
+    bool load(world::BodyStore& bodies, const char* path) {
+        View view;
+        if (!view.open(path)) {
+            return false;
+        }
+        world::BodyArrays arrays{view.x(), view.y(), view.vx(), view.vy(), view.fx(), view.fy(), view.invMass(),
+                                 view.mass(), view.radius(), view.restitution(), view.flags(), view.restSteps(), view.islandIds()};
+        bodies.assign(view.size(), arrays);
+        return true;
+    }
+
+} // namespace snapshot
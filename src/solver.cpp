@@ -0,0 +1,274 @@
+#include "solver.h"
+#include <algorithm>
+#include <cmath>
+
+namespace solver {
+
+    namespace {
+        const std::size_t GRAIN = 256;      // contacts per chunk
+        const std::uint32_t MAX_COLOURS = 64; // colours tracked per body; the rest share a final serial colour
+
+        // Order independent id for the pair of bodies behind a contact, with their handle generations in the same order
+        inline std::uint64_t pairKey(world::BodyHandle a, world::BodyHandle b, std::uint64_t& generations) {
+            if (a.index > b.index) {
+                std::swap(a, b);
+            }
+            generations = (static_cast<std::uint64_t>(a.generation) << 32) | b.generation;
+            return (static_cast<std::uint64_t>(a.index) << 32) | b.index;
+        }
+
+        // Apply impulse along the normal; static bodies are shared between contacts of one colour, so never write to them
+        template<typename Constraint>
+        inline void applyImpulse(float* vx, float* vy, const Constraint& c, float impulse) {
+            if (c.inv_mass_a > 0.0f) {
+                vx[c.a] -= impulse * c.inv_mass_a * c.normal_x;
+                vy[c.a] -= impulse * c.inv_mass_a * c.normal_y;
+            }
+            if (c.inv_mass_b > 0.0f) {
+                vx[c.b] += impulse * c.inv_mass_b * c.normal_x;
+                vy[c.b] += impulse * c.inv_mass_b * c.normal_y;
+            }
+        }
+    }
+
+    ContactSolver::ContactSolver(const Settings& settings) : config(settings) {}
+
+    // ======================================================================== //
+    // ============================== Graph Colouring ========================= //
+    // ======================================================================== //
+    void ContactSolver::colour(const world::BodyStore& bodies, const std::vector<narrowphase::Contact>& contacts, memory::FrameArena& arena) {
+        const std::uint32_t* flags = bodies.flags();
+        std::uint64_t* body_colours = arena.allocate<std::uint64_t>(bodies.size());   // bit c set if the body has a contact of colour c
+        std::uint32_t* contact_colour = arena.allocate<std::uint32_t>(contacts.size());
+        std::fill(body_colours, body_colours + bodies.size(), 0);
+
+        // Greedy: lowest colour neither dynamic body already uses. Static bodies
+        // are never written by the solver so they don't constrain the colouring.
+        std::uint32_t count = 0;
+        for (std::size_t i = 0; i < contacts.size(); i++) {
+            std::uint32_t a = contacts[i].a;
+            std::uint32_t b = contacts[i].b;
+            bool a_dynamic = !(flags[a] & world::BODY_STATIC);
+            bool b_dynamic = !(flags[b] & world::BODY_STATIC);
+            std::uint64_t used = (a_dynamic ? body_colours[a] : 0) | (b_dynamic ? body_colours[b] : 0);
+
+            std::uint32_t colour = MAX_COLOURS;
+            if (used != ~std::uint64_t(0)) {
+                colour = static_cast<std::uint32_t>(__builtin_ctzll(~used));
+                if (a_dynamic) {
+                    body_colours[a] |= std::uint64_t(1) << colour;
+                }
+                if (b_dynamic) {
+                    body_colours[b] |= std::uint64_t(1) << colour;
+                }
+            }
+            contact_colour[i] = colour;
+            count = std::max(count, colour + 1);
+        }
+        colour_count = count;
+
+        // Counting sort by colour, keeping contact order within a colour
+        colour_start = arena.allocate<std::uint32_t>(count + 1);
+        std::fill(colour_start, colour_start + count + 1, 0);
+        for (std::size_t i = 0; i < contacts.size(); i++) {
+            colour_start[contact_colour[i] + 1]++;
+        }
+        for (std::uint32_t c = 0; c < count; c++) {
+            colour_start[c + 1] += colour_start[c];
+        }
+        std::uint32_t* cursor = arena.allocate<std::uint32_t>(count);
+        std::copy(colour_start, colour_start + count, cursor);
+        ordered = arena.allocate<std::uint32_t>(contacts.size());
+        for (std::uint32_t i = 0; i < contacts.size(); i++) {
+            ordered[cursor[contact_colour[i]]++] = i;
+        }
+    }
+
+    // ======================================================================== //
+    // ============================== Warm Starting =========================== //
+    // ======================================================================== //
+    namespace {
+        inline std::size_t bucketOf(std::uint64_t key, std::size_t bucket_count) {
+            // Fibonacci hashing; bucket_count is a power of two
+            return static_cast<std::size_t>((key * 0x9E3779B97F4A7C15ull) >> 32) & (bucket_count - 1);
+        }
+    }
+
+    void ContactSolver::clearCache() {
+        // Entries go back to the pool rather than freeing it, so refilling doesn't allocate
+        for (std::uint32_t& head : cache_buckets) {
+            for (std::uint32_t id = head; id != NO_ENTRY;) {
+                std::uint32_t next = cache_entries[id].next;
+                cache_entries.release(id);
+                id = next;
+            }
+            head = NO_ENTRY;
+        }
+    }
+
+    std::uint32_t ContactSolver::findCached(std::uint64_t key) const {
+        if (cache_buckets.empty()) {
+            return NO_ENTRY;
+        }
+        for (std::uint32_t id = cache_buckets[bucketOf(key, cache_buckets.size())]; id != NO_ENTRY; id = cache_entries[id].next) {
+            if (cache_entries[id].key == key) {
+                return id;
+            }
+        }
+        return NO_ENTRY;
+    }
+
+    void ContactSolver::storeImpulses(std::size_t count, memory::FrameArena& arena) {
+        cache_stamp++;
+
+        // Grow to one bucket per contact, rehashing the surviving entries; only happens while warming up
+        if (cache_buckets.size() < count) {
+            std::size_t old_size = cache_buckets.size();
+            std::uint32_t* old_heads = arena.allocate<std::uint32_t>(old_size);
+            std::copy(cache_buckets.begin(), cache_buckets.end(), old_heads);
+
+            std::size_t size = 64;
+            while (size < count) {
+                size *= 2;
+            }
+            cache_buckets.assign(size, NO_ENTRY);
+            for (std::size_t bucket = 0; bucket < old_size; bucket++) {
+                std::uint32_t id = old_heads[bucket];
+                while (id != NO_ENTRY) {
+                    CacheEntry& entry = cache_entries[id];
+                    std::uint32_t next = entry.next;
+                    std::uint32_t& head = cache_buckets[bucketOf(entry.key, size)];
+                    entry.next = head;
+                    head = id;
+                    id = next;
+                }
+            }
+        }
+
+        // Refresh pairs that were already cached, add the new ones
+        for (std::size_t k = 0; k < count; k++) {
+            const Constraint& c = constraints[k];
+            std::uint32_t id = c.entry;
+            if (id == NO_ENTRY) {
+                id = cache_entries.allocate();
+                std::uint32_t& head = cache_buckets[bucketOf(c.key, cache_buckets.size())];
+                cache_entries[id].key = c.key;
+                cache_entries[id].next = head;
+                head = id;
+            }
+            cache_entries[id].generations = c.generations;
+            cache_entries[id].impulse = c.impulse;
+            cache_entries[id].stamp = cache_stamp;
+        }
+
+        // Evict pairs that stopped touching
+        if (cache_entries.size() > count) {
+            for (std::uint32_t& head : cache_buckets) {
+                std::uint32_t* link = &head;
+                while (*link != NO_ENTRY) {
+                    std::uint32_t id = *link;
+                    if (cache_entries[id].stamp != cache_stamp) {
+                        *link = cache_entries[id].next;
+                        cache_entries.release(id);
+                    } else {
+                        link = &cache_entries[id].next;
+                    }
+                }
+            }
+        }
+    }
+
+    // ======================================================================== //
+    // ================================== Solving ============================= //
+    // ======================================================================== //
+    void ContactSolver::solve(world::BodyStore& bodies, const std::vector<narrowphase::Contact>& contacts, float deltaTime,
+                              memory::FrameArena& arena, threading::ThreadPool* pool) {
+        last_iterations = 0;
+        colour_count = 0;
+        constraints = arena.allocate<Constraint>(contacts.size());
+        if (contacts.empty()) {
+            storeImpulses(0, arena);
+            return;
+        }
+        colour(bodies, contacts, arena);
+
+        float* vx = bodies.vx();
+        float* vy = bodies.vy();
+        const float* inv_mass = bodies.invMass();
+        const float* restitution = bodies.restitution();
+        const float inv_dt = deltaTime > 0.0f ? 1.0f / deltaTime : 0.0f;
+
+        // Prepare constraints; reading the cache from several threads at once is safe
+        threading::parallelFor(pool, 0, contacts.size(), GRAIN, [&](std::size_t begin, std::size_t end, unsigned) {
+            for (std::size_t k = begin; k < end; k++) {
+                const narrowphase::Contact& contact = contacts[k];
+                Constraint& c = constraints[k];
+                c.a = contact.a;
+                c.b = contact.b;
+                c.normal_x = contact.normal_x;
+                c.normal_y = contact.normal_y;
+                c.inv_mass_a = inv_mass[c.a];
+                c.inv_mass_b = inv_mass[c.b];
+                float mass_sum = c.inv_mass_a + c.inv_mass_b;
+                c.normal_mass = mass_sum > 0.0f ? 1.0f / mass_sum : 0.0f;
+
+                // Push out penetration, or bounce if approaching fast enough, whichever asks for more
+                c.bias = config.baumgarte * inv_dt * std::max(contact.penetration - config.slop, 0.0f);
+                float normal_speed = (vx[c.b] - vx[c.a]) * c.normal_x + (vy[c.b] - vy[c.a]) * c.normal_y;
+                if (-normal_speed > config.restitution_threshold) {
+                    float e = std::min(restitution[c.a], restitution[c.b]);
+                    c.bias = std::max(c.bias, -e * normal_speed);
+                }
+
+                c.key = pairKey(bodies.handleOf(c.a), bodies.handleOf(c.b), c.generations);
+                c.entry = findCached(c.key);
+                // An entry left by bodies since destroyed is reused, but its impulse isn't
+                bool cached = c.entry != NO_ENTRY && cache_entries[c.entry].generations == c.generations;
+                c.impulse = config.warm_starting && cached ? cache_entries[c.entry].impulse : 0.0f;
+            }
+        });
+
+        // Runs pass over every colour in order; colour MAX_COLOURS may share bodies so it runs serially
+        auto sweep = [&](auto&& resolve) {
+            for (std::size_t colour = 0; colour < colour_count; colour++) {
+                auto body = [&](std::size_t first, std::size_t last, unsigned worker) {
+                    for (std::size_t k = first; k < last; k++) {
+                        resolve(constraints[ordered[k]], worker);
+                    }
+                };
+                threading::parallelFor(colour < MAX_COLOURS ? pool : nullptr, colour_start[colour], colour_start[colour + 1], GRAIN, body);
+            }
+        };
+
+        if (config.warm_starting) {
+            sweep([&](const Constraint& c, unsigned) { applyImpulse(vx, vy, c, c.impulse); });
+        }
+
+        const std::size_t workers = pool ? pool->size() : 1;
+        worker_change = arena.allocate<float>(workers);
+        for (int iteration = 0; iteration < config.iterations; iteration++) {
+            std::fill(worker_change, worker_change + workers, 0.0f);
+            sweep([&](Constraint& c, unsigned worker) {
+                float normal_speed = (vx[c.b] - vx[c.a]) * c.normal_x + (vy[c.b] - vy[c.a]) * c.normal_y;
+                float lambda = c.normal_mass * (c.bias - normal_speed);
+
+                // Clamp the running total, not the increment, so later iterations can take impulse back
+                float total = std::max(c.impulse + lambda, 0.0f);
+                lambda = total - c.impulse;
+                c.impulse = total;
+                applyImpulse(vx, vy, c, lambda);
+                worker_change[worker] = std::max(worker_change[worker], std::fabs(lambda));
+            });
+            last_iterations = iteration + 1;
+
+            // The largest change doesn't depend on which worker saw it, so this is deterministic
+            if (*std::max_element(worker_change, worker_change + workers) < config.tolerance) {
+                break;
+            }
+        }
+
+        // Remember this step's impulses for the next one
+        storeImpulses(contacts.size(), arena);
+    }
+
+} // namespace solver
@@ -0,0 +1,111 @@
+#include "state_hash.h"
+#include <cstring>
+
+namespace hashing {
+
+    namespace {
+
+        const std::uint64_t PRIME1 = 11400714785074694791ull;
+        const std::uint64_t PRIME2 = 14029467366897019727ull;
+        const std::uint64_t PRIME3 = 1609587929392839161ull;
+        const std::uint64_t PRIME4 = 9650029242287828579ull;
+        const std::uint64_t PRIME5 = 2870177450012600261ull;
+
+        inline std::uint64_t rotl(std::uint64_t value, int bits) { return (value << bits) | (value >> (64 - bits)); }
+
+        inline std::uint64_t read64(const unsigned char* p) {
+            std::uint64_t value;
+            std::memcpy(&value, p, sizeof(value));
+            return value;
+        }
+
+        inline std::uint32_t read32(const unsigned char* p) {
+            std::uint32_t value;
+            std::memcpy(&value, p, sizeof(value));
+            return value;
+        }
+
+        inline std::uint64_t round(std::uint64_t acc, std::uint64_t input) { return rotl(acc + input * PRIME2, 31) * PRIME1; }
+        inline std::uint64_t mergeRound(std::uint64_t acc, std::uint64_t lane) { return (acc ^ round(0, lane)) * PRIME1 + PRIME4; }
+
+    }
+
+    // ======================================================================== //
+    // ================================== XXH64 =============================== //
+    // ======================================================================== //
+    std::uint64_t xxh64(const void* data, std::size_t bytes, std::uint64_t seed) {
+        const unsigned char* p = static_cast<const unsigned char*>(data);
+        const unsigned char* end = p + bytes;
+        std::uint64_t h;
+
+        // Four independent lanes over 32-byte stripes
+        if (bytes >= 32) {
+            std::uint64_t v1 = seed + PRIME1 + PRIME2;
+            std::uint64_t v2 = seed + PRIME2;
+            std::uint64_t v3 = seed;
+            std::uint64_t v4 = seed - PRIME1;
+            const unsigned char* limit = end - 32;
+            do {
+                v1 = round(v1, read64(p));
+                v2 = round(v2, read64(p + 8));
+                v3 = round(v3, read64(p + 16));
+                v4 = round(v4, read64(p + 24));
+                p += 32;
+            } while (p <= limit);
+            h = rotl(v1, 1) + rotl(v2, 7) + rotl(v3, 12) + rotl(v4, 18);
+            h = mergeRound(h, v1);
+            h = mergeRound(h, v2);
+            h = mergeRound(h, v3);
+            h = mergeRound(h, v4);
+        } else {
+            h = seed + PRIME5;
+        }
+        h += static_cast<std::uint64_t>(bytes);
+
+        // Tail of up to 31 bytes
+        for (; p + 8 <= end; p += 8) {
+            h = rotl(h ^ round(0, read64(p)), 27) * PRIME1 + PRIME4;
+        }
+        if (p + 4 <= end) {
+            h = rotl(h ^ (read32(p) * PRIME1), 23) * PRIME2 + PRIME3;
+            p += 4;
+        }
+        for (; p < end; p++) {
+            h = rotl(h ^ (*p * PRIME5), 11) * PRIME1;
+        }
+
+        // Avalanche
+        h ^= h >> 33;
+        h *= PRIME2;
+        h ^= h >> 29;
+        h *= PRIME3;
+        h ^= h >> 32;
+        return h;
+    }
+
+    // ======================================================================== //
+    // ================================ Body State ============================ //
+    // ======================================================================== //
+    std::uint64_t hashBodies(const world::BodyStore& bodies, memory::FrameArena& arena, threading::ThreadPool* pool) {
+        const std::size_t count = bodies.size();
+        const std::size_t chunk_count = (count + HASH_CHUNK_BODIES - 1) / HASH_CHUNK_BODIES;
+        std::uint64_t* chunk_hashes = arena.allocate<std::uint64_t>(chunk_count);
+
+        const void* arrays[] = {
+            bodies.x(), bodies.y(), bodies.vx(), bodies.vy(), bodies.fx(), bodies.fy(), bodies.invMass(),
+            bodies.mass(), bodies.radius(), bodies.restitution(), bodies.flags(), bodies.restSteps(), bodies.islandIds(),
+        };
+        static_assert(sizeof(float) == sizeof(std::uint32_t), "every body array has 4-byte elements");
+
+        // Each array's slice is chained into the next through the seed
+        threading::parallelFor(pool, 0, count, HASH_CHUNK_BODIES, [&](std::size_t begin, std::size_t end, unsigned) {
+            std::uint64_t h = 0;
+            for (const void* array : arrays) {
+                h = xxh64(static_cast<const unsigned char*>(array) + begin * 4, (end - begin) * 4, h);
+            }
+            chunk_hashes[begin / HASH_CHUNK_BODIES] = h;
+        });
+        return xxh64(chunk_hashes, chunk_count * sizeof(std::uint64_t), count);
+    }
+
+} // namespace hashing
@@ -0,0 +1,87 @@
+#include "stepper.h"
+#include <cmath>
+
+namespace world {
+
+    // ======================================================================== //
+    // =============================== Constructors =========================== //
+    // ======================================================================== //
+    FixedStepper::FixedStepper(World& world, const StepperSettings& settings) : target(world), config(settings) {}
+
+    // ======================================================================== //
+    // ============================== Update Functions ======================== //
+    // ======================================================================== //
+    int FixedStepper::advance(float frameTime) {
+        const BodyStore& store = target.bodies();
+        const double dt = config.fixed_dt;
+
+        // A broken timer reading (negative, NaN or infinite) would poison the accumulator for good, so it counts as no time
+        if (!std::isfinite(frameTime) || frameTime < 0.0f) {
+            frameTime = 0.0f;
+        }
+        // A long stall (debugger, window drag) shouldn't be simulated in full
+        if (frameTime > config.max_frame_time) {
+            dropped += frameTime - config.max_frame_time;
+            frameTime = config.max_frame_time;
+        }
+        accumulator += frameTime;
+
+        int substeps = 0;
+        while (accumulator >= dt && substeps < config.max_substeps) {
+            // Keep the pre-step positions so the frame can be drawn between them and the new ones
+            prev_x.assign(store.x(), store.x() + store.size());
+            prev_y.assign(store.y(), store.y() + store.size());
+            prev_layout = store.layoutVersion();
+
+            target.step(config.fixed_dt);
+            accumulator -= dt;
+            substeps++;
+            steps++;
+        }
+
+        // Out of substeps: drop the whole steps still owed but keep the fraction, so alpha stays meaningful
+        if (accumulator >= dt) {
+            double owed = std::floor(accumulator / dt) * dt;
+            dropped += owed;
+            accumulator -= owed;
+        }
+
+        last_substeps = substeps;
+        interpolate();
+        return substeps;
+    }
+
+    void FixedStepper::interpolate() {
+        const BodyStore& store = target.bodies();
+        const std::size_t count = store.size();
+        const float* x = store.x();
+        const float* y = store.y();
+        render_x.resize(count);
+        render_y.resize(count);
+        render_layout = store.layoutVersion();
+
+        // Dense indices only line up with the saved positions if no body was created or destroyed since
+        if (steps == 0 || prev_layout != store.layoutVersion() || prev_x.size() != count) {
+            render_x.assign(x, x + count);
+            render_y.assign(y, y + count);
+            return;
+        }
+
+        const float t = alpha();
+        for (std::size_t i = 0; i < count; i++) {
+            render_x[i] = prev_x[i] + (x[i] - prev_x[i]) * t;
+            render_y[i] = prev_y[i] + (y[i] - prev_y[i]) * t;
+        }
+    }
+
+    vector::Vector<float, 2> FixedStepper::renderPosition(BodyHandle handle) const {
+        const BodyStore& store = target.bodies();
+        std::uint32_t i = store.indexOf(handle);
+        if (render_layout == store.layoutVersion() && i < render_x.size()) {
+            return vector::Vector<float, 2>(render_x[i], render_y[i]);
+        }
+        // Dense index i may belong to another body in the captured arrays
+        return vector::Vector<float, 2>(store.x()[i], store.y()[i]);
+    }
+
+} // namespace world
@@ -0,0 +1,126 @@
+#include "thread_pool.h"
+
+namespace threading {
+
+    // ======================================================================== //
+    // =============================== Constructors =========================== //
+    // ======================================================================== //
+    ThreadPool::ThreadPool(unsigned thread_count)
+    : participants(thread_count == 0 ? 1 : thread_count), queues(new Queue[thread_count == 0 ? 1 : thread_count]) {
+        threads.reserve(participants - 1);
+        for (unsigned worker = 1; worker < participants; worker++) {
+            threads.emplace_back(&ThreadPool::workerLoop, this, worker);
+        }
+    }
+
+    ThreadPool::~ThreadPool() {
+        {
+            std::lock_guard<std::mutex> guard(sleep_lock);
+            stopping = true;
+        }
+        wake.notify_all();
+        for (std::thread& thread : threads) {
+            thread.join();
+        }
+    }
+
+    // ======================================================================== //
+    // ================================ Scheduling ============================ //
+    // ======================================================================== //
+    void ThreadPool::run(std::size_t begin, std::size_t end, std::size_t grain, const Job& job) {
+        if (begin >= end) {
+            return;
+        }
+        if (grain == 0) {
+            grain = 1;
+        }
+        const std::size_t chunk_count = (end - begin + grain - 1) / grain;
+
+        // Nothing to share, skip the queues entirely
+        if (participants == 1 || chunk_count == 1) {
+            for (std::size_t b = begin; b < end; b += grain) {
+                job.run(job.context, b, end - b < grain ? end : b + grain, 0);
+            }
+            return;
+        }
+
+        // Deal out contiguous runs of chunks so neighbouring data stays on one thread
+        remaining.store(chunk_count, std::memory_order_relaxed);
+        const std::size_t per_queue = (chunk_count + participants - 1) / participants;
+        for (unsigned worker = 0; worker < participants; worker++) {
+            Queue& queue = queues[worker];
+            std::lock_guard<std::mutex> guard(queue.lock);
+            queue.chunks.clear();
+            queue.head = 0;
+            std::size_t first = worker * per_queue;
+            std::size_t last = first + per_queue < chunk_count ? first + per_queue : chunk_count;
+            // Pushed in reverse so the owner, popping from the back, runs its run in order
+            for (std::size_t c = last; c > first; c--) {
+                std::size_t b = begin + (c - 1) * grain;
+                queue.chunks.push_back(Chunk{b, end - b < grain ? end : b + grain, &job});
+            }
+        }
+        {
+            std::lock_guard<std::mutex> guard(sleep_lock);
+            epoch++;
+        }
+        wake.notify_all();
+
+        // Help out until every chunk has finished
+        while (remaining.load(std::memory_order_acquire) != 0) {
+            if (!runOne(0)) {
+                std::this_thread::yield();
+            }
+        }
+    }
+
+    bool ThreadPool::runOne(unsigned worker) {
+        Chunk chunk;
+        bool found = false;
+
+        // Own queue first, from the back
+        {
+            Queue& own = queues[worker];
+            std::lock_guard<std::mutex> guard(own.lock);
+            if (own.head < own.chunks.size()) {
+                chunk = own.chunks.back();
+                own.chunks.pop_back();
+                found = true;
+            }
+        }
+
+        // Then steal from the front of the others, starting with the next thread along
+        for (unsigned offset = 1; !found && offset < participants; offset++) {
+            Queue& victim = queues[(worker + offset) % participants];
+            std::lock_guard<std::mutex> guard(victim.lock);
+            if (victim.head < victim.chunks.size()) {
+                chunk = victim.chunks[victim.head++];
+                found = true;
+            }
+        }
+
+        if (!found) {
+            return false;
+        }
+        chunk.job->run(chunk.job->context, chunk.begin, chunk.end, worker);
+        remaining.fetch_sub(1, std::memory_order_acq_rel);
+        return true;
+    }
+
+    void ThreadPool::workerLoop(unsigned worker) {
+        std::uint64_t seen = 0;
+        while (true) {
+            {
+                std::unique_lock<std::mutex> guard(sleep_lock);
+                wake.wait(guard, [&] { return stopping || epoch != seen; });
+                if (stopping) {
+                    return;
+                }
+                seen = epoch;
+            }
+            while (runOne(worker)) {
+            }
+        }
+    }
+
+} // namespace threading
@@ -0,0 +1,263 @@
+#include "world.h"
+#include <snapshot.h>
+#include <algorithm>
+
+namespace world {
+
+    // ======================================================================== //
+    // =============================== Constructors =========================== //
+    // ======================================================================== //
+    World::World(unsigned thread_count)
+    : pool(new threading::ThreadPool(thread_count)), broad_phase(new broadphase::SpatialHashGrid()), step_profiler(pool->size()) {
+        broad_phase->setThreadPool(pool.get());
+    }
+
+    // ======================================================================== //
+    // ============================ Body Management =========================== //
+    // ======================================================================== //
+    objects::Circle World::createCircle(vector::Vector<float, 2> pos, float radius, float mass, bool is_static, float restitution) {
+        BodyHandle handle = store.create(pos[0], pos[1], radius, mass, is_static, restitution);
+        return objects::Circle(store, handle);
+    }
+
+    void World::destroyCircle(const objects::Circle& circle) { store.destroy(circle.getHandle()); }
+    objects::Circle World::getCircle(BodyHandle handle) { return objects::Circle(store, handle); }
+
+    BodyStore& World::bodies() { return store; }
+    const BodyStore& World::bodies() const { return store; }
+
+    bool World::saveSnapshot(const char* path) const { return snapshot::save(store, path); }
+
+    bool World::loadSnapshot(const char* path) {
+        if (!snapshot::load(store, path)) {
+            return false;
+        }
+        // Cached impulses are keyed by handle slots, which now belong to different bodies
+        contact_solver.clearCache();
+        return true;
+    }
+
+    // ======================================================================== //
+    // ================================== Forces ============================== //
+    // ======================================================================== //
+    forces::ForceGenerator& World::addForceGenerator(std::unique_ptr<forces::ForceGenerator> generator) {
+        force_generators.push_back(std::move(generator));
+        return *force_generators.back();
+    }
+    void World::clearForceGenerators() { force_generators.clear(); }
+
+    // ======================================================================== //
+    // =============================== Broad-phase ============================ //
+    // ======================================================================== //
+    void World::setBroadPhase(std::unique_ptr<broadphase::BroadPhase> backend) {
+        broad_phase = std::move(backend);
+        broad_phase->setThreadPool(pool.get());
+    }
+    broadphase::BroadPhase& World::broadPhase() { return *broad_phase; }
+    const std::vector<broadphase::BodyPair>& World::pairs() const { return pair_list; }
+
+    // ======================================================================== //
+    // ============================= Contacts & Threads ======================= //
+    // ======================================================================== //
+    const std::vector<narrowphase::Contact>& World::contacts() const { return contact_list; }
+    solver::Settings& World::solverSettings() { return contact_solver.settings(); }
+    int World::solverIterations() const { return contact_solver.iterationsUsed(); }
+
+    void World::setThreadCount(unsigned thread_count) {
+        pool.reset(new threading::ThreadPool(thread_count));
+        broad_phase->setThreadPool(pool.get());
+        step_profiler.setThreadCount(pool->size());
+    }
+
+    unsigned World::threadCount() const { return pool->size(); }
+
+    // ======================================================================== //
+    // ================================= Profiling ============================ //
+    // ======================================================================== //
+    const profiling::FrameStats& World::frameStats() const { return step_profiler.lastFrame(); }
+    profiling::Profiler& World::profiler() { return step_profiler; }
+
+    // ======================================================================== //
+    // =============================== Determinism ============================ //
+    // ======================================================================== //
+    DeterminismSettings& World::determinismSettings() { return determinism; }
+
+    // ======================================================================== //
+    // ================================= Sleeping ============================= //
+    // ======================================================================== //
+    SleepSettings& World::sleepSettings() { return islands.settings(); }
+    const IslandStats& World::islandStats() const { return islands.stats(); }
+
+    // ======================================================================== //
+    // ============================= Spatial Queries ========================== //
+    // ======================================================================== //
+    std::vector<objects::Circle> World::queryRegion(const vector::Vector<float, 2>& min, const vector::Vector<float, 2>& max) {
+        broad_phase->queryRegion(store, broadphase::Aabb{min[0], min[1], max[0], max[1]}, query_results);
+
+        std::vector<objects::Circle> circles;
+        circles.reserve(query_results.size());
+        for (std::uint32_t i : query_results) {
+            circles.push_back(objects::Circle(store, store.handleOf(i)));
+        }
+        return circles;
+    }
+
+    std::vector<objects::Circle> World::queryRadius(const vector::Vector<float, 2>& point, float distance) {
+        broadphase::Aabb region{point[0] - distance, point[1] - distance, point[0] + distance, point[1] + distance};
+        broad_phase->queryRegion(store, region, query_results);
+
+        // The box query is conservative, keep circles whose surface is within distance
+        std::vector<objects::Circle> circles;
+        for (std::uint32_t i : query_results) {
+            float dx = store.x()[i] - point[0];
+            float dy = store.y()[i] - point[1];
+            float reach = store.radius()[i] + distance;
+            if (dx * dx + dy * dy <= reach * reach) {
+                circles.push_back(objects::Circle(store, store.handleOf(i)));
+            }
+        }
+        return circles;
+    }
+
+    bool World::rayCast(const vector::Vector<float, 2>& origin, const vector::Vector<float, 2>& direction, float max_t, broadphase::RayHit& hit) {
+        return broad_phase->rayCast(store, origin[0], origin[1], direction[0], direction[1], max_t, hit);
+    }
+
+    // ======================================================================== //
+    // ============================== Update Functions ======================== //
+    // ======================================================================== //
+    void World::step(float deltaTime) {
+        step_profiler.beginFrame();
+        frame_arena.reset();
+
+        // Only bodies destroyed since the last step can have moved others
+        if (determinism.creation_order && store.layoutVersion() != ordered_layout) {
+            store.restoreCreationOrder();
+            ordered_layout = store.layoutVersion();
+        }
+
+        // Islands woken by setters or destroyed bodies since the last step
+        {
+            PROFILE_STAGE(step_profiler, profiling::Stage::Wake);
+            islands.wakePending(store);
+        }
+
+        // Higher order integrators evaluate the generators again mid-step, on top of the applied forces kept here
+        const bool staged = integrator_evaluations > 1 && !force_generators.empty();
+        float* applied_x = nullptr;
+        float* applied_y = nullptr;
+        {
+            PROFILE_STAGE(step_profiler, profiling::Stage::Forces);
+            if (staged) {
+                applied_x = frame_arena.allocate<float>(store.size());
+                applied_y = frame_arena.allocate<float>(store.size());
+                std::copy(store.fx(), store.fx() + store.size(), applied_x);
+                std::copy(store.fy(), store.fy() + store.size(), applied_y);
+            }
+            for (const std::unique_ptr<forces::ForceGenerator>& generator : force_generators) {
+                generator->apply(store, pool.get());
+            }
+        }
+
+        // Semi-implicit Euler (SIMD) unless another integrator was selected; forces are used up
+        {
+            PROFILE_STAGE(step_profiler, profiling::Stage::Integrate);
+            if (staged) {
+                integrateWithGenerators(deltaTime, applied_x, applied_y);
+            } else {
+                pool->parallelFor(0, store.size(), 4096, [&](std::size_t begin, std::size_t end, unsigned worker) {
+                    PROFILE_CHUNK(step_profiler, profiling::Stage::Integrate, worker);
+                    integrate_range(store, begin, end, deltaTime);
+                    store.clearForces(begin, end);
+                });
+            }
+        }
+        {
+            PROFILE_STAGE(step_profiler, profiling::Stage::Islands);
+            islands.countResting(store);
+        }
+        {
+            PROFILE_STAGE(step_profiler, profiling::Stage::BroadPhase);
+            broad_phase->findPairs(store, pair_list);
+            store.forgetChanges();
+            if (determinism.ordered_pairs) {
+                broadphase::sortPairs(pair_list, pair_scratch);
+            }
+        }
+        {
+            PROFILE_STAGE(step_profiler, profiling::Stage::NarrowPhase);
+            narrow_phase.collide(store, pair_list, contact_list, pool.get());
+            islands.wakeTouched(store, contact_list);
+        }
+        {
+            PROFILE_STAGE(step_profiler, profiling::Stage::Solve);
+            contact_solver.solve(store, contact_list, deltaTime, frame_arena, pool.get());
+        }
+        {
+            PROFILE_STAGE(step_profiler, profiling::Stage::Islands);
+            islands.update(store, contact_list, frame_arena);
+        }
+        std::uint64_t state_hash = 0;
+        if (determinism.state_hash) {
+            PROFILE_STAGE(step_profiler, profiling::Stage::Hash);
+            state_hash = hashing::hashBodies(store, frame_arena, pool.get());
+        }
+
+        step_profiler.endFrame(static_cast<std::uint32_t>(store.size()), static_cast<std::uint32_t>(islands.stats().awake_bodies),
+                               static_cast<std::uint32_t>(pair_list.size()), static_cast<std::uint32_t>(contact_list.size()),
+                               static_cast<std::uint32_t>(contact_solver.iterationsUsed()), state_hash);
+    }
+
+    void World::integrateWithGenerators(float deltaTime, const float* applied_x, const float* applied_y) {
+        const std::size_t count = store.size();
+        float* x0 = frame_arena.allocate<float>(count);
+        float* y0 = frame_arena.allocate<float>(count);
+        float* vx0 = frame_arena.allocate<float>(count);
+        float* vy0 = frame_arena.allocate<float>(count);
+        std::copy(store.x(), store.x() + count, x0);
+        std::copy(store.y(), store.y() + count, y0);
+        std::copy(store.vx(), store.vx() + count, vx0);
+        std::copy(store.vy(), store.vy() + count, vy0);
+
+        // Acceleration of every body from the forces now in the store
+        StagedState staged{x0, y0, vx0, vy0, {}, {}};
+        auto accelerations = [&](int evaluation) {
+            float* ax = frame_arena.allocate<float>(count);
+            float* ay = frame_arena.allocate<float>(count);
+            pool->parallelFor(0, count, 4096, [&](std::size_t begin, std::size_t end, unsigned worker) {
+                PROFILE_CHUNK(step_profiler, profiling::Stage::Integrate, worker);
+                const float* fx = store.fx();
+                const float* fy = store.fy();
+                const float* inv_mass = store.invMass();
+                for (std::size_t i = begin; i < end; i++) {
+                    ax[i] = fx[i] * inv_mass[i];
+                    ay[i] = fy[i] * inv_mass[i];
+                }
+            });
+            staged.ax[evaluation] = ax;
+            staged.ay[evaluation] = ay;
+        };
+        accelerations(0);
+
+        // Pass s moves the bodies to the state of evaluation s, where the generators run again on the applied forces
+        for (int stage = 1; stage <= integrator_evaluations; stage++) {
+            pool->parallelFor(0, count, 4096, [&](std::size_t begin, std::size_t end, unsigned worker) {
+                PROFILE_CHUNK(step_profiler, profiling::Stage::Integrate, worker);
+                integrate_staged(store, begin, end, deltaTime, staged, stage);
+                if (stage < integrator_evaluations) {
+                    std::copy(applied_x + begin, applied_x + end, store.fx() + begin);
+                    std::copy(applied_y + begin, applied_y + end, store.fy() + begin);
+                } else {
+                    store.clearForces(begin, end);
+                }
+            });
+            if (stage < integrator_evaluations) {
+                for (const std::unique_ptr<forces::ForceGenerator>& generator : force_generators) {
+                    generator->apply(store, pool.get());
+                }
+                accelerations(stage);
+            }
+        }
+    }
+
+} // namespace world
@@ -0,0 +1,37 @@
+#ifndef TESTS_CHECK_H // Inclusion guard
+#define TESTS_CHECK_H
+
+// Pass/fail checks for the programs in tests/. CHECK reports a failed
+// condition with its location and carries on, so one run lists every
+// failure; main returns tests::result(), which is non-zero after any
+// failure, and `make test` stops at the first program that fails.
+// Independent of assert, so release builds check just the same.
+
+#include <cstdio>
+
+namespace tests {
+
+    inline int& failures() {
+        static int count = 0;
+        return count;
+    }
+
+    inline void fail(const char* file, int line, const char* condition) {
+        std::printf("%s:%d: check failed: %s\n", file, line, condition);
+        failures()++;
+    }
+
+    inline int result(const char* name) {
+        if (failures() > 0) {
+            std::printf("%s: %d check(s) failed\n", name, failures());
+            return 1;
+        }
+        std::printf("%s: passed\n", name);
+        return 0;
+    }
+
+} // namespace tests
+
+#define CHECK(condition) ((condition) ? (void)0 : tests::fail(__FILE__, __LINE__, #condition))
+
+#endif
@@ -0,0 +1,88 @@
+// Step profiling: per-stage times and counters in FrameStats, the frame
+// history ring and the Chrome trace file. Built twice by `make test`, as
+// test_profiler and, against a library compiled with PROFILING=0, as
+// test_profiler_off, where every time must be zero but counters and the
+// trace must still work.
+#include "check.h"
+#include <profiler.h>
+#include <world.h>
+#include <cstdio>
+#include <string>
+
+namespace {
+
+    std::string readFile(const char* path) {
+        std::string text;
+        if (std::FILE* file = std::fopen(path, "rb")) {
+            char buffer[4096];
+            std::size_t read;
+            while ((read = std::fread(buffer, 1, sizeof(buffer), file)) > 0) {
+                text.append(buffer, read);
+            }
+            std::fclose(file);
+        }
+        return text;
+    }
+
+}
+
+int main() {
+    world::World world(2);
+    for (int i = 0; i < 200; i++) {
+        objects::Circle circle = world.createCircle(vector::Vector<float, 2>(static_cast<float>(i % 20) * 1.5f, static_cast<float>(i / 20) * 1.5f), 1.0f, 1.0f);
+        circle.setVelocity(static_cast<float>(i % 3) - 1.0f, 0.5f);
+    }
+    profiling::Profiler& profiler = world.profiler();
+    CHECK(profiler.frameCount() == 0);
+
+    // The circles start overlapping their neighbours
+    world.step(1.0f / 60.0f);
+    CHECK(profiler.lastFrame().frame == 1);
+    CHECK(profiler.lastFrame().bodies == 200);
+    CHECK(profiler.lastFrame().pairs > 0);
+    CHECK(profiler.lastFrame().contacts > 0);
+
+    const int steps = static_cast<int>(profiling::Profiler::FRAME_HISTORY) + 10;
+    for (int s = 1; s < steps; s++) {
+        world.step(1.0f / 60.0f);
+    }
+    const profiling::FrameStats& last = profiler.lastFrame();
+    CHECK(last.frame == static_cast<std::uint64_t>(steps));
+    CHECK(profiler.frameCount() == profiling::Profiler::FRAME_HISTORY);
+    CHECK(profiler.frameAt(0).frame == static_cast<std::uint64_t>(steps) - profiling::Profiler::FRAME_HISTORY + 1);
+
+    double stages = 0.0;
+    for (std::size_t s = 0; s < profiling::STAGE_COUNT; s++) {
+        CHECK(last.stage_seconds[s] >= 0.0);
+        stages += last.stage_seconds[s];
+    }
+#if PROFILING
+    CHECK(last.step_seconds > 0.0);
+    CHECK(last.stageSeconds(profiling::Stage::BroadPhase) > 0.0);
+    CHECK(stages <= last.step_seconds);
+#else
+    CHECK(last.step_seconds == 0.0);
+    CHECK(stages == 0.0);
+#endif
+
+    const char* path = "build/test_profiler_trace.json";
+    CHECK(profiler.writeChromeTrace(path));
+    std::string trace = readFile(path);
+    std::remove(path);
+    CHECK(trace.compare(0, 17, "{\"displayTimeUnit") == 0);
+    CHECK(trace.size() >= 4 && trace.compare(trace.size() - 4, 4, "\n]}\n") == 0);
+    CHECK(trace.find("\"name\":\"counters\"") != std::string::npos);
+#if PROFILING
+    CHECK(trace.find("\"name\":\"step\"") != std::string::npos);
+    CHECK(trace.find("\"name\":\"broad-phase\"") != std::string::npos);
+#else
+    CHECK(trace.find("\"ph\":\"X\"") == std::string::npos);
+#endif
+    CHECK(!profiler.writeChromeTrace("build/no/such/directory/trace.json"));
+
+#if PROFILING
+    return tests::result("profiler");
+#else
+    return tests::result("profiler (PROFILING=0)");
+#endif
+}
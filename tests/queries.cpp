@@ -0,0 +1,116 @@
+// World::queryRegion, queryRadius and rayCast on every broad-phase backend,
+// against a scan of every body, in a scene that has stepped (so the tree
+// backend has refit proxies), had bodies destroyed, and had static and
+// dynamic bodies moved by setPosition since the last step.
+#include "check.h"
+#include <aabb_tree.h>
+#include <broadphase.h>
+#include <world.h>
+#include <algorithm>
+#include <cmath>
+#include <memory>
+#include <random>
+#include <vector>
+
+namespace {
+
+    // Bodies as (slot, generation) pairs, sorted, so results compare whatever order a backend returns
+    std::vector<std::uint64_t> keys(const std::vector<objects::Circle>& circles) {
+        std::vector<std::uint64_t> result;
+        for (const objects::Circle& circle : circles) {
+            world::BodyHandle handle = circle.getHandle();
+            result.push_back(static_cast<std::uint64_t>(handle.index) << 32 | handle.generation);
+        }
+        std::sort(result.begin(), result.end());
+        return result;
+    }
+
+    std::uint64_t key(const world::BodyStore& store, std::uint32_t i) {
+        world::BodyHandle handle = store.handleOf(i);
+        return static_cast<std::uint64_t>(handle.index) << 32 | handle.generation;
+    }
+
+    void checkBackend(std::unique_ptr<broadphase::BroadPhase> backend) {
+        world::World world(2);
+        world.setBroadPhase(std::move(backend));
+        std::mt19937 rng(7);
+        std::uniform_real_distribution<float> position(0.0f, 100.0f);
+        std::uniform_real_distribution<float> radius(0.3f, 1.5f);
+        std::uniform_real_distribution<float> speed(-3.0f, 3.0f);
+        std::vector<objects::Circle> created;
+        for (int i = 0; i < 2000; i++) {
+            objects::Circle circle = world.createCircle(vector::Vector<float, 2>(position(rng), position(rng)), radius(rng), 1.0f, i % 5 == 0);
+            if (i % 5 != 0) {
+                circle.setVelocity(speed(rng), speed(rng));
+            }
+            created.push_back(circle);
+        }
+        for (int s = 0; s < 20; s++) {
+            world.step(1.0f / 60.0f);
+        }
+        for (int i = 0; i < 2000; i += 7) {
+            world.destroyCircle(created[i]);
+        }
+        world.step(1.0f / 60.0f);
+
+        // Moved by a setter after the step, static bodies included, so the queries must pick the change up themselves
+        world::BodyStore& store = world.bodies();
+        for (std::uint32_t i = 0; i < store.size(); i += 9) {
+            store.setPosition(i, 100.0f - store.x()[i], store.y()[i] + 3.0f);
+        }
+
+        for (int q = 0; q < 50; q++) {
+            // Region
+            float x0 = position(rng), y0 = position(rng);
+            broadphase::Aabb region{x0, y0, x0 + 15.0f, y0 + 10.0f};
+            std::vector<std::uint64_t> expected;
+            for (std::uint32_t i = 0; i < store.size(); i++) {
+                if (broadphase::circleOverlapsAabb(store.x()[i], store.y()[i], store.radius()[i], region)) {
+                    expected.push_back(key(store, i));
+                }
+            }
+            std::sort(expected.begin(), expected.end());
+            CHECK(keys(world.queryRegion({region.min_x, region.min_y}, {region.max_x, region.max_y})) == expected);
+
+            // Radius: circles whose surface is within distance of the point
+            float px = position(rng), py = position(rng), distance = 6.0f;
+            expected.clear();
+            for (std::uint32_t i = 0; i < store.size(); i++) {
+                float dx = store.x()[i] - px, dy = store.y()[i] - py, reach = store.radius()[i] + distance;
+                if (dx * dx + dy * dy <= reach * reach) {
+                    expected.push_back(key(store, i));
+                }
+            }
+            std::sort(expected.begin(), expected.end());
+            CHECK(keys(world.queryRadius({px, py}, distance)) == expected);
+
+            // Ray: the closest circle hit
+            float angle = position(rng) * 0.0628f;
+            float dx = std::cos(angle), dy = std::sin(angle), max_t = 80.0f;
+            float best_t = max_t;
+            bool any = false;
+            for (std::uint32_t i = 0; i < store.size(); i++) {
+                float t;
+                if (broadphase::rayCastCircle(store.x()[i], store.y()[i], store.radius()[i], px, py, dx, dy, best_t, t)) {
+                    best_t = t;
+                    any = true;
+                }
+            }
+            broadphase::RayHit hit;
+            bool found = world.rayCast({px, py}, {dx, dy}, max_t, hit);
+            CHECK(found == any);
+            if (found && any) {
+                CHECK(hit.t == best_t);
+            }
+        }
+    }
+
+}
+
+int main() {
+    checkBackend(std::make_unique<broadphase::BruteForce>());
+    checkBackend(std::make_unique<broadphase::SpatialHashGrid>());
+    checkBackend(std::make_unique<broadphase::SweepAndPrune>());
+    checkBackend(std::make_unique<broadphase::TreeBroadPhase>());
+    return tests::result("queries");
+}
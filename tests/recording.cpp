@@ -0,0 +1,119 @@
+// Recorder and Reader: a recording reads back within the quantisation step,
+// and corrupt frame headers (sizes beyond the file, absurd body counts, a
+// truncated payload) end the read with false rather than an allocation.
+#include "check.h"
+#include <recorder.h>
+#include <world.h>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+namespace {
+
+    const char* PATH = "build/test_recording.rec";
+
+    std::vector<unsigned char> readFile(const char* path) {
+        std::vector<unsigned char> bytes;
+        if (std::FILE* file = std::fopen(path, "rb")) {
+            unsigned char buffer[4096];
+            std::size_t read;
+            while ((read = std::fread(buffer, 1, sizeof(buffer), file)) > 0) {
+                bytes.insert(bytes.end(), buffer, buffer + read);
+            }
+            std::fclose(file);
+        }
+        return bytes;
+    }
+
+    void writeFile(const char* path, const std::vector<unsigned char>& bytes) {
+        if (std::FILE* file = std::fopen(path, "wb")) {
+            std::fwrite(bytes.data(), 1, bytes.size(), file);
+            std::fclose(file);
+        }
+    }
+
+    // Frames read before next() returns false
+    int countFrames(const char* path) {
+        recording::Reader reader;
+        if (!reader.open(path)) {
+            return -1;
+        }
+        recording::Frame frame;
+        int frames = 0;
+        while (reader.next(frame)) {
+            frames++;
+        }
+        return frames;
+    }
+
+}
+
+int main() {
+    world::World world(1);
+    for (int i = 0; i < 100; i++) {
+        objects::Circle circle = world.createCircle(vector::Vector<float, 2>(static_cast<float>(i) * 3.0f, 0.0f), 1.0f, 1.0f);
+        circle.setVelocity(0.5f, static_cast<float>(i % 7) - 3.0f);
+    }
+
+    const int frames = 10;
+    std::vector<float> last_x;
+
+    // A queue as long as the recording, so no capture is dropped
+    {
+        recording::RecorderSettings settings;
+        settings.queue_frames = frames;
+        recording::Recorder recorder;
+        CHECK(recorder.open(PATH, settings));
+        for (int f = 0; f < frames; f++) {
+            world.step(1.0f / 60.0f);
+            CHECK(recorder.capture(world.bodies()));
+        }
+        recorder.close();
+        CHECK(recorder.framesDropped() == 0);
+        const world::BodyStore& store = world.bodies();
+        last_x.assign(store.x(), store.x() + store.size());
+    }
+    {
+        recording::Reader reader;
+        CHECK(reader.open(PATH));
+        recording::Frame frame;
+        int read = 0;
+        while (reader.next(frame)) {
+            read++;
+        }
+        CHECK(read == frames);
+        CHECK(frame.x.size() == last_x.size());
+        float worst = 0.0f;
+        for (std::size_t i = 0; i < frame.x.size() && i < last_x.size(); i++) {
+            worst = std::fmax(worst, std::fabs(frame.x[i] - last_x[i]));
+        }
+        CHECK(worst <= 0.5f * reader.positionStep());
+    }
+
+    // Corrupt the first frame header, which follows the 32 byte file header
+    const std::vector<unsigned char> good = readFile(PATH);
+    CHECK(good.size() > sizeof(recording::FileHeader) + sizeof(recording::FrameHeader));
+    CHECK(countFrames(PATH) == frames);
+    auto corrupt = [&](auto change) {
+        std::vector<unsigned char> bytes = good;
+        recording::FrameHeader header;
+        std::memcpy(&header, bytes.data() + sizeof(recording::FileHeader), sizeof(header));
+        change(header);
+        std::memcpy(bytes.data() + sizeof(recording::FileHeader), &header, sizeof(header));
+        writeFile(PATH, bytes);
+        return countFrames(PATH);
+    };
+    CHECK(corrupt([](recording::FrameHeader& header) { header.payload_bytes = 1ull << 62; }) == 0);
+    CHECK(corrupt([&](recording::FrameHeader& header) { header.payload_bytes = good.size(); }) == 0);
+    CHECK(corrupt([](recording::FrameHeader& header) { header.body_count = 0xFFFFFFFFu; }) == 0);
+    CHECK(corrupt([](recording::FrameHeader& header) { header.body_count = recording::MAX_FRAME_BODIES + 1; }) == 0);
+
+    // A file cut off mid-frame reads the frames before it
+    std::vector<unsigned char> truncated(good.begin(), good.end() - 5);
+    writeFile(PATH, truncated);
+    CHECK(countFrames(PATH) == frames - 1);
+
+    std::remove(PATH);
+    return tests::result("recording");
+}
@@ -0,0 +1,92 @@
+// Sleeping under gravity: a body and a stack settle on a static floor, fall
+// asleep, stay put while asleep, and wake when changed through a setter.
+#include "check.h"
+#include <forces.h>
+#include <world.h>
+#include <cmath>
+#include <memory>
+#include <vector>
+
+namespace {
+
+    const float DT = 1.0f / 60.0f;
+
+    // Steps until every dynamic body sleeps, or max_steps
+    int stepUntilAsleep(world::World& world, std::size_t dynamic, int max_steps) {
+        for (int s = 1; s <= max_steps; s++) {
+            world.step(DT);
+            if (world.islandStats().asleep_bodies == dynamic) {
+                return s;
+            }
+        }
+        return -1;
+    }
+
+    void checkSettles(int height) {
+        world::World world(1);
+        world.addForceGenerator(std::make_unique<forces::UniformGravity>());
+        world.createCircle(vector::Vector<float, 2>(0.0f, -100.0f), 100.0f, 1.0f, true);
+        std::vector<objects::Circle> stack;
+        for (int i = 0; i < height; i++) {
+            stack.push_back(world.createCircle(vector::Vector<float, 2>(0.0f, 1.2f + 2.1f * static_cast<float>(i)), 1.0f, 1.0f, false, 0.0f));
+        }
+
+        const std::uint32_t rest = world.sleepSettings().steps;
+        int steps = stepUntilAsleep(world, stack.size(), 600);
+        CHECK(steps > static_cast<int>(rest));
+        for (const objects::Circle& circle : stack) {
+            CHECK(circle.isSleeping());
+        }
+        CHECK(world.islandStats().awake_bodies == 0);
+
+        // Asleep bodies don't move, and the stack still stands on the floor
+        const world::BodyStore& store = world.bodies();
+        std::uint32_t top = store.indexOf(stack.back().getHandle());
+        float y = store.y()[top];
+        for (int s = 0; s < 30; s++) {
+            world.step(DT);
+        }
+        CHECK(store.y()[store.indexOf(stack.back().getHandle())] == y);
+        CHECK(std::fabs(y - (static_cast<float>(2 * height) - 1.0f)) < 0.1f * static_cast<float>(height));
+
+        // An upward force on the bottom body wakes the whole island, which lands and sleeps again
+        stack.front().applyForce(0.0f, 300.0f);
+        world.step(DT);
+        for (const objects::Circle& circle : stack) {
+            CHECK(!circle.isSleeping());
+        }
+        CHECK(world.islandStats().asleep_bodies == 0);
+        CHECK(stepUntilAsleep(world, stack.size(), 600) > static_cast<int>(rest));
+
+        // So does a velocity on the top body
+        stack.back().setVelocity(0.0f, 3.0f);
+        world.step(DT);
+        CHECK(!stack.front().isSleeping());
+        CHECK(store.vy()[store.indexOf(stack.back().getHandle())] > 2.0f);
+        CHECK(stepUntilAsleep(world, stack.size(), 600) > static_cast<int>(rest));
+    }
+
+    // A body falling, or drifting slowly without gravity, never counts as resting
+    void checkMovingStaysAwake() {
+        world::World falling_world(1);
+        falling_world.addForceGenerator(std::make_unique<forces::UniformGravity>());
+        objects::Circle falling = falling_world.createCircle(vector::Vector<float, 2>(0.0f, 1000.0f), 1.0f, 1.0f);
+        world::World drifting_world(1);
+        objects::Circle drifting = drifting_world.createCircle(vector::Vector<float, 2>(0.0f, 0.0f), 1.0f, 1.0f);
+        drifting.setVelocity(0.1f, 0.0f);
+        for (int s = 0; s < 300; s++) {
+            falling_world.step(DT);
+            drifting_world.step(DT);
+        }
+        CHECK(!falling.isSleeping());
+        CHECK(!drifting.isSleeping());
+    }
+
+}
+
+int main() {
+    checkSettles(1);
+    checkSettles(3);
+    checkMovingStaysAwake();
+    return tests::result("sleep");
+}
@@ -0,0 +1,95 @@
+// FixedStepper: whole fixed steps per advance(), the leftover as alpha, the
+// frame time and substep caps with the time they drop, broken frame times,
+// and interpolated render positions.
+#include "check.h"
+#include <stepper.h>
+#include <world.h>
+#include <cmath>
+#include <limits>
+
+namespace {
+
+    const double DT = 1.0 / 60.0;
+
+    bool near(double a, double b) {
+        return std::fabs(a - b) < 1e-5;
+    }
+
+    void checkAccumulates() {
+        world::World world(1);
+        world::FixedStepper stepper(world);
+        CHECK(stepper.advance(0.5f * static_cast<float>(DT)) == 0);
+        CHECK(near(stepper.alpha(), 0.5));
+        CHECK(stepper.advance(0.75f * static_cast<float>(DT)) == 1);
+        CHECK(near(stepper.alpha(), 0.25));
+        CHECK(stepper.advance(3.0f * static_cast<float>(DT)) == 3);
+        CHECK(stepper.lastSubsteps() == 3);
+        CHECK(near(stepper.alpha(), 0.25));
+        CHECK(stepper.stepCount() == 4);
+        CHECK(world.profiler().lastFrame().frame == 4);
+        CHECK(stepper.droppedTime() == 0.0);
+    }
+
+    void checkCaps() {
+        world::World world(1);
+        world::StepperSettings settings;
+        settings.max_substeps = 4;
+        settings.max_frame_time = 0.11f;
+        world::FixedStepper stepper(world, settings);
+
+        // 0.5 s is clamped to 0.11 s (6.6 steps owed), of which 4 run and 2 are dropped, the fraction kept
+        CHECK(stepper.advance(0.5f) == 4);
+        CHECK(stepper.stepCount() == 4);
+        double leftover = 0.11 - 6 * DT;
+        CHECK(near(stepper.droppedTime(), 0.39 + 2 * DT));
+        CHECK(near(stepper.alpha(), leftover / DT));
+        CHECK(stepper.alpha() >= 0.0f && stepper.alpha() < 1.0f);
+
+        // Back to normal frames straight away
+        CHECK(stepper.advance(static_cast<float>(DT)) == 1);
+        CHECK(near(stepper.droppedTime(), 0.39 + 2 * DT));
+    }
+
+    void checkBrokenFrameTimes() {
+        world::World world(1);
+        world::FixedStepper stepper(world);
+        stepper.advance(0.5f * static_cast<float>(DT));
+        const float broken[] = {std::numeric_limits<float>::quiet_NaN(), std::numeric_limits<float>::infinity(),
+                                -std::numeric_limits<float>::infinity(), -1.0f};
+        for (float frame_time : broken) {
+            CHECK(stepper.advance(frame_time) == 0);
+            CHECK(near(stepper.alpha(), 0.5));
+            CHECK(stepper.droppedTime() == 0.0);
+        }
+        // Still running afterwards
+        CHECK(stepper.advance(0.5f * static_cast<float>(DT)) == 1);
+        CHECK(stepper.advance(2.0f * static_cast<float>(DT)) == 2);
+        CHECK(stepper.stepCount() == 3);
+        CHECK(std::isfinite(stepper.alpha()));
+    }
+
+    void checkInterpolation() {
+        world::World world(1);
+        objects::Circle circle = world.createCircle(vector::Vector<float, 2>(0.0f, 0.0f), 1.0f, 1.0f);
+        circle.setVelocity(6.0f, 0.0f);
+        world::FixedStepper stepper(world);
+        stepper.advance(1.25f * static_cast<float>(DT));
+        // One step moved it 0.1, and the frame is drawn a quarter of the way into the next
+        vector::Vector<float, 2> drawn = stepper.renderPosition(circle.getHandle());
+        CHECK(near(drawn[0], 0.025));
+        CHECK(near(stepper.renderX()[0], 0.025));
+
+        // A new body changes the layout, so everything is drawn where it is
+        world.createCircle(vector::Vector<float, 2>(10.0f, 0.0f), 1.0f, 1.0f);
+        CHECK(near(stepper.renderPosition(circle.getHandle())[0], 0.1));
+    }
+
+}
+
+int main() {
+    checkAccumulates();
+    checkCaps();
+    checkBrokenFrameTimes();
+    checkInterpolation();
+    return tests::result("stepper");
+}